@@ -36,6 +36,7 @@ public class PhysicsAnimationTools : ModuleRules
 			{
 				"CoreUObject",
 				"Engine",
+				"PhysicsCore",
 				"Slate",
 				"SlateCore",
 				// ... add private dependencies that you statically link with here ...	
@@ -11,7 +11,10 @@
 #include "Serialization/ObjectWriter.h"
 #include "Serialization/ObjectReader.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "PhysicsEngine/PhysicsAsset.h"
 #include "PhysicsEngine/PhysicsConstraintTemplate.h"
+#include "PhysicsEngine/SkeletalBodySetup.h"
+#include "UObject/ObjectSaveContext.h"
 #include "UObject/ReleaseObjectVersion.h"
 #include "UObject/UObjectIterator.h"
 #include "UObject/FortniteNCBranchObjectVersion.h"
@@ -21,7 +24,141 @@
 
 // #define LOCTEXT_NAMESPACE "PhysicsAnimationAsset"
 
+DEFINE_LOG_CATEGORY_STATIC(LogPhysicsAnimationAsset, Log, All);
+
 UPhysicsAnimationAsset::UPhysicsAnimationAsset(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
-}
\ No newline at end of file
+}
+
+int32 UPhysicsAnimationAsset::FindProfileIndex(FName ProfileName) const
+{
+	return BakedProfiles.IndexOfByPredicate([ProfileName](const FPhysicsAnimationBakedProfile& Profile)
+	{
+		return Profile.ProfileName == ProfileName;
+	});
+}
+
+const FPhysicsAnimationBakedProfile* UPhysicsAnimationAsset::GetBakedProfile(int32 ProfileIndex) const
+{
+	return BakedProfiles.IsValidIndex(ProfileIndex) ? &BakedProfiles[ProfileIndex] : nullptr;
+}
+
+void UPhysicsAnimationAsset::BakeProfiles()
+{
+	BakedProfiles.Reset();
+	BodyConstraintIndices.Reset();
+	if (PhysicsAsset == nullptr)
+	{
+		return;
+	}
+
+	// The body hierarchy comes from the constraints (ConstraintBone1 is the child, ConstraintBone2 the parent),
+	// so baking does not need the skeletal mesh.
+	const int32 NumBodies = PhysicsAsset->SkeletalBodySetups.Num();
+	TArray<int32> ParentBodyIndices;
+	ParentBodyIndices.Init(INDEX_NONE, NumBodies);
+	BodyConstraintIndices.Init(INDEX_NONE, NumBodies);
+	for (int32 ConstraintIndex = 0; ConstraintIndex < PhysicsAsset->ConstraintSetup.Num(); ++ConstraintIndex)
+	{
+		const UPhysicsConstraintTemplate* Constraint = PhysicsAsset->ConstraintSetup[ConstraintIndex];
+		if (Constraint == nullptr)
+		{
+			continue;
+		}
+		const int32 ChildIndex = PhysicsAsset->FindBodyIndex(Constraint->DefaultInstance.ConstraintBone1);
+		const int32 ParentIndex = PhysicsAsset->FindBodyIndex(Constraint->DefaultInstance.ConstraintBone2);
+		if (ChildIndex != INDEX_NONE)
+		{
+			ParentBodyIndices[ChildIndex] = ParentIndex;
+			BodyConstraintIndices[ChildIndex] = ConstraintIndex;
+		}
+	}
+
+	const auto IsInChain = [&ParentBodyIndices](int32 BodyIndex, int32 ChainRootIndex, bool bIncludeSelf)
+	{
+		if (BodyIndex == ChainRootIndex)
+		{
+			return bIncludeSelf;
+		}
+		for (int32 Depth = 0; Depth < ParentBodyIndices.Num() && BodyIndex != INDEX_NONE; ++Depth)
+		{
+			BodyIndex = ParentBodyIndices[BodyIndex];
+			if (BodyIndex == ChainRootIndex)
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+
+	for (const FPhysicsAnimationProfile& Profile : Profiles)
+	{
+		FPhysicsAnimationBakedProfile& BakedProfile = BakedProfiles.AddDefaulted_GetRef();
+		BakedProfile.ProfileName = Profile.ProfileName;
+		BakedProfile.BodyDrives.SetNum(NumBodies);
+		for (const FPhysicsAnimationChainProfile& Chain : Profile.Chains)
+		{
+			const int32 ChainRootIndex = PhysicsAsset->FindBodyIndex(Chain.ChainRootBody);
+			if (ChainRootIndex == INDEX_NONE)
+			{
+				UE_LOG(LogPhysicsAnimationAsset, Warning, TEXT("%s: profile %s uses body %s which is not in %s"),
+					*GetName(), *Profile.ProfileName.ToString(), *Chain.ChainRootBody.ToString(), *PhysicsAsset->GetName());
+				continue;
+			}
+			for (int32 BodyIndex = 0; BodyIndex < NumBodies; ++BodyIndex)
+			{
+				if (IsInChain(BodyIndex, ChainRootIndex, Chain.bIncludeSelf))
+				{
+					BakedProfile.BodyDrives[BodyIndex] = Chain.Drive;
+				}
+			}
+		}
+	}
+}
+
+UPhysicsAsset* UPhysicsAnimationAsset::SelectPhysicsAssetLOD(float ViewDistance, bool bVisible) const
+{
+	UPhysicsAsset* Selected = PhysicsAsset;
+	float SelectedDistance = -1.0f;
+	for (const FPhysicsAssetLOD& LOD : PhysicsAssetLODs)
+	{
+		if (LOD.GeneratedPhysicsAsset != nullptr
+			&& (!bVisible || LOD.MinViewDistance <= ViewDistance)
+			&& LOD.MinViewDistance > SelectedDistance)
+		{
+			Selected = LOD.GeneratedPhysicsAsset;
+			SelectedDistance = LOD.MinViewDistance;
+		}
+	}
+	return Selected;
+}
+
+void UPhysicsAnimationAsset::PostLoad()
+{
+	Super::PostLoad();
+
+#if WITH_EDITOR
+	// Assets saved before baking existed, cooked data is always baked in PreSave
+	if (BakedProfiles.Num() != Profiles.Num())
+	{
+		BakeProfiles();
+	}
+#endif
+}
+
+void UPhysicsAnimationAsset::PreSave(FObjectPreSaveContext ObjectSaveContext)
+{
+	Super::PreSave(ObjectSaveContext);
+
+	BakeProfiles();
+}
+
+#if WITH_EDITOR
+void UPhysicsAnimationAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	BakeProfiles();
+}
+#endif
@@ -0,0 +1,134 @@
+// Copyright 2022-2023 XiaWen. All Rights Reserved.
+
+#include "PhysicsAnimationProfileComponent.h"
+#include "PhysicsAnimationAsset.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/Actor.h"
+#include "Physics/PhysicsInterfaceCore.h"
+#include "PhysicsEngine/ConstraintInstance.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "PhysicsEngine/PhysicsConstraintTemplate.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(PhysicsAnimationProfileComponent)
+
+void UPhysicsAnimationProfileComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (SkeletalMeshComponent == nullptr && GetOwner() != nullptr)
+	{
+		SetSkeletalMeshComponent(GetOwner()->FindComponentByClass<USkeletalMeshComponent>());
+	}
+}
+
+void UPhysicsAnimationProfileComponent::SetSkeletalMeshComponent(USkeletalMeshComponent* InSkeletalMeshComponent)
+{
+	SkeletalMeshComponent = InSkeletalMeshComponent;
+	InvalidateAppliedProfile();
+	if (SkeletalMeshComponent != nullptr)
+	{
+		SkeletalMeshComponent->bUpdateJointsFromAnimation = bDriveJointsFromAnimation;
+	}
+}
+
+void UPhysicsAnimationProfileComponent::InvalidateAppliedProfile()
+{
+	CurrentProfileIndex = INDEX_NONE;
+	CurrentProfileName = NAME_None;
+}
+
+void UPhysicsAnimationProfileComponent::RestoreDefaultDrives()
+{
+	const UPhysicsAsset* PhysicsAsset = SkeletalMeshComponent ? SkeletalMeshComponent->GetPhysicsAsset() : nullptr;
+	if (CurrentProfileIndex == INDEX_NONE || PhysicsAsset == nullptr)
+	{
+		return;
+	}
+
+	TArray<FConstraintInstance*>& Constraints = SkeletalMeshComponent->Constraints;
+	FPhysicsCommand::ExecuteWrite(SkeletalMeshComponent, [PhysicsAsset, &Constraints]()
+	{
+		for (FConstraintInstance* Constraint : Constraints)
+		{
+			const UPhysicsConstraintTemplate* Setup = Constraint && PhysicsAsset->ConstraintSetup.IsValidIndex(Constraint->ConstraintIndex)
+				? PhysicsAsset->ConstraintSetup[Constraint->ConstraintIndex].Get() : nullptr;
+			if (Setup == nullptr)
+			{
+				continue;
+			}
+
+			FAngularDriveConstraint& AngularDrive = Constraint->ProfileInstance.AngularDrive;
+			AngularDrive = Setup->DefaultInstance.ProfileInstance.AngularDrive;
+			if (Constraint->ConstraintHandle.IsValid())
+			{
+				FPhysicsInterface::UpdateAngularDrive_AssumesLocked(Constraint->ConstraintHandle, AngularDrive);
+			}
+		}
+	});
+
+	InvalidateAppliedProfile();
+}
+
+bool UPhysicsAnimationProfileComponent::ApplyProfile(FName ProfileName)
+{
+	return ProfileAsset != nullptr && ApplyProfileByIndex(ProfileAsset->FindProfileIndex(ProfileName));
+}
+
+bool UPhysicsAnimationProfileComponent::ApplyProfileByIndex(int32 ProfileIndex)
+{
+	if (ProfileIndex == CurrentProfileIndex)
+	{
+		return true;
+	}
+
+	const FPhysicsAnimationBakedProfile* Profile = ProfileAsset ? ProfileAsset->GetBakedProfile(ProfileIndex) : nullptr;
+	if (Profile == nullptr || !IsCompatibleWithMesh())
+	{
+		return false;
+	}
+
+	// All drives are written under one physics lock instead of one lock and one name lookup per bone
+	TArray<FConstraintInstance*>& Constraints = SkeletalMeshComponent->Constraints;
+	FPhysicsCommand::ExecuteWrite(SkeletalMeshComponent, [this, Profile, &Constraints]()
+	{
+		for (int32 BodyIndex = 0; BodyIndex < Profile->BodyDrives.Num(); ++BodyIndex)
+		{
+			const int32 ConstraintIndex = ProfileAsset->GetBodyConstraintIndex(BodyIndex);
+			FConstraintInstance* Constraint = Constraints.IsValidIndex(ConstraintIndex) ? Constraints[ConstraintIndex] : nullptr;
+			if (Constraint == nullptr)
+			{
+				continue;
+			}
+
+			const FPhysicsAnimationDrive& Drive = Profile->BodyDrives[BodyIndex];
+			FAngularDriveConstraint& AngularDrive = Constraint->ProfileInstance.AngularDrive;
+			AngularDrive.AngularDriveMode = EAngularDriveMode::SLERP;
+			AngularDrive.SlerpDrive.bEnablePositionDrive = Drive.Strength > 0.0f;
+			AngularDrive.SlerpDrive.bEnableVelocityDrive = Drive.Damping > 0.0f;
+			AngularDrive.SlerpDrive.Stiffness = Drive.Strength;
+			AngularDrive.SlerpDrive.Damping = Drive.Damping;
+			AngularDrive.SlerpDrive.MaxForce = Drive.MaxForce;
+			if (Constraint->ConstraintHandle.IsValid())
+			{
+				FPhysicsInterface::UpdateAngularDrive_AssumesLocked(Constraint->ConstraintHandle, AngularDrive);
+			}
+		}
+	});
+
+	CurrentProfileIndex = ProfileIndex;
+	CurrentProfileName = Profile->ProfileName;
+	return true;
+}
+
+bool UPhysicsAnimationProfileComponent::IsCompatibleWithMesh() const
+{
+	if (SkeletalMeshComponent == nullptr)
+	{
+		return false;
+	}
+
+	const UPhysicsAsset* MeshPhysicsAsset = SkeletalMeshComponent->GetPhysicsAsset();
+	return ensureMsgf(MeshPhysicsAsset == ProfileAsset->PhysicsAsset && ProfileAsset->GetNumBakedBodies() == MeshPhysicsAsset->SkeletalBodySetups.Num(),
+		TEXT("%s was baked for %s but %s uses %s"), *ProfileAsset->GetName(), *GetNameSafe(ProfileAsset->PhysicsAsset),
+		*SkeletalMeshComponent->GetName(), *GetNameSafe(MeshPhysicsAsset));
+}
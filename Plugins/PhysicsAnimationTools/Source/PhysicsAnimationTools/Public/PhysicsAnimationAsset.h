@@ -13,21 +13,140 @@
 #include "PhysicsAnimationAsset.generated.h"
 
 class FMeshElementCollector;
+class UPhysicsAsset;
 class USkeletalBodySetup;
 
+/** Angular drive applied to the constraint that connects a body to its parent. */
+USTRUCT(BlueprintType)
+struct FPhysicsAnimationDrive
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Drive, meta = (ClampMin = "0"))
+	float Strength = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Drive, meta = (ClampMin = "0"))
+	float Damping = 0.0f;
+
+	/** 0 means unlimited */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Drive, meta = (ClampMin = "0"))
+	float MaxForce = 0.0f;
+};
+
+/** Drive settings for a body and every body below it. */
+USTRUCT(BlueprintType)
+struct FPhysicsAnimationChainProfile
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Chain)
+	FName ChainRootBody;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Chain)
+	bool bIncludeSelf = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Chain)
+	FPhysicsAnimationDrive Drive;
+};
+
+USTRUCT(BlueprintType)
+struct FPhysicsAnimationProfile
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Profile)
+	FName ProfileName;
+
+	/** Chains are applied in order, later chains override earlier ones on shared bodies. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Profile)
+	TArray<FPhysicsAnimationChainProfile> Chains;
+};
+
+/** A profile flattened to one drive per body, indexed like UPhysicsAsset::SkeletalBodySetups. */
+USTRUCT()
+struct FPhysicsAnimationBakedProfile
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FName ProfileName;
+
+	UPROPERTY()
+	TArray<FPhysicsAnimationDrive> BodyDrives;
+};
+
+/** A reduced copy of the physics asset for ragdolls far from every view, generated by the editor module. */
+USTRUCT(BlueprintType)
+struct FPhysicsAssetLOD
+{
+	GENERATED_BODY()
+
+	/** Bodies kept in the generated asset, must include the root body (pelvis). Other bodies are removed together with their constraints. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = LOD)
+	TArray<FName> KeptBodies;
+
+	/** Append the shapes of removed bodies to their closest kept ancestor instead of dropping them */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = LOD)
+	bool bMergeRemovedShapes = true;
+
+	/** Replace convex hulls with their bounding boxes */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = LOD)
+	bool bReplaceConvexWithBoxes = true;
+
+	/** Used by ragdolls at least this far from the closest view, ragdolls nobody can see use the last LOD */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = LOD, meta = (ClampMin = "0"))
+	float MinViewDistance = 1500.0f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = LOD)
+	TObjectPtr<UPhysicsAsset> GeneratedPhysicsAsset;
+};
+
 /**
- * PhysicsAsset contains a set of rigid bodies and constraints that make up a single ragdoll.
- * The asset is not limited to human ragdolls, and can be used for any physical simulation using bodies and constraints.
- * A SkeletalMesh has a single PhysicsAsset, which allows for easily turning ragdoll physics on or off for many SkeletalMeshComponents
- * The asset can be configured inside the Physics Asset Editor.
- *
- * @see https://docs.unrealengine.com/InteractiveExperiences/Physics/PhysicsAssetEditor
- * @see USkeletalMesh
+ * Physical animation drive profiles for one physics asset (e.g. SK_Mannequin_PhysicsAsset).
+ * Profiles are authored per bone chain and baked on save/cook into flat per-body arrays,
+ * so UPhysicsAnimationProfileComponent can switch profiles without any name lookups.
  */
-
 UCLASS(hidecategories=Object, BlueprintType, MinimalAPI, Config=Game, PerObjectConfig, AutoCollapseCategories=(OldSolverSettings))
 // class UPhysicsAnimationAsset : public UObject, public IInterface_PreviewMeshProvider
 class UPhysicsAnimationAsset : public UObject
 {
 	GENERATED_UCLASS_BODY()
-};
\ No newline at end of file
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = PhysicsAnimation)
+	TObjectPtr<UPhysicsAsset> PhysicsAsset;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = PhysicsAnimation)
+	TArray<FPhysicsAnimationProfile> Profiles;
+
+	/** Ordered by MinViewDistance, regenerate with "Generate Physics Asset LODs" in the asset's context menu after editing */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = PhysicsAnimation)
+	TArray<FPhysicsAssetLOD> PhysicsAssetLODs;
+
+	PHYSICSANIMATIONTOOLS_API int32 FindProfileIndex(FName ProfileName) const;
+	PHYSICSANIMATIONTOOLS_API const FPhysicsAnimationBakedProfile* GetBakedProfile(int32 ProfileIndex) const;
+
+	/** Index of the constraint whose child is the given body, INDEX_NONE for the root body. */
+	int32 GetBodyConstraintIndex(int32 BodyIndex) const { return BodyConstraintIndices.IsValidIndex(BodyIndex) ? BodyConstraintIndices[BodyIndex] : INDEX_NONE; }
+	int32 GetNumBakedBodies() const { return BodyConstraintIndices.Num(); }
+
+	PHYSICSANIMATIONTOOLS_API void BakeProfiles();
+
+	/** The physics asset a ragdoll at ViewDistance should use, falls back to PhysicsAsset */
+	PHYSICSANIMATIONTOOLS_API UPhysicsAsset* SelectPhysicsAssetLOD(float ViewDistance, bool bVisible) const;
+
+	//~ Begin UObject Interface
+	virtual void PostLoad() override;
+	virtual void PreSave(FObjectPreSaveContext ObjectSaveContext) override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+	//~ End UObject Interface
+
+private:
+	UPROPERTY()
+	TArray<FPhysicsAnimationBakedProfile> BakedProfiles;
+
+	UPROPERTY()
+	TArray<int32> BodyConstraintIndices;
+};
@@ -0,0 +1,60 @@
+// Copyright 2022-2023 XiaWen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "PhysicsAnimationProfileComponent.generated.h"
+
+class UPhysicsAnimationAsset;
+class USkeletalMeshComponent;
+
+/**
+ * Applies baked UPhysicsAnimationAsset profiles to a skeletal mesh's joint drives.
+ * A profile switch is a single physics write over the baked per-body arrays, cheap enough to do on every state change.
+ */
+UCLASS(ClassGroup = Physics, meta = (BlueprintSpawnableComponent))
+class PHYSICSANIMATIONTOOLS_API UPhysicsAnimationProfileComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = PhysicsAnimation)
+	TObjectPtr<UPhysicsAnimationAsset> ProfileAsset;
+
+	/** Drive the joints towards the animated pose, otherwise towards the reference pose */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = PhysicsAnimation)
+	bool bDriveJointsFromAnimation = true;
+
+	/** Uses the first skeletal mesh component of the owner if not set */
+	UFUNCTION(BlueprintCallable, Category = PhysicsAnimation)
+	void SetSkeletalMeshComponent(USkeletalMeshComponent* InSkeletalMeshComponent);
+
+	UFUNCTION(BlueprintCallable, Category = PhysicsAnimation)
+	bool ApplyProfile(FName ProfileName);
+
+	bool ApplyProfileByIndex(int32 ProfileIndex);
+
+	/** Forget the applied profile, call after the mesh's constraints are rebuilt (e.g. by SetPhysicsAsset) so the next apply writes the drives again */
+	UFUNCTION(BlueprintCallable, Category = PhysicsAnimation)
+	void InvalidateAppliedProfile();
+
+	/** Put every joint drive back to the physics asset's defaults, so later users of the constraints see the same drives whether or not a profile was applied */
+	UFUNCTION(BlueprintCallable, Category = PhysicsAnimation)
+	void RestoreDefaultDrives();
+
+	UFUNCTION(BlueprintCallable, Category = PhysicsAnimation)
+	FName GetCurrentProfileName() const { return CurrentProfileName; }
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	bool IsCompatibleWithMesh() const;
+
+	UPROPERTY(Transient)
+	TObjectPtr<USkeletalMeshComponent> SkeletalMeshComponent;
+
+	int32 CurrentProfileIndex = INDEX_NONE;
+	FName CurrentProfileName;
+};
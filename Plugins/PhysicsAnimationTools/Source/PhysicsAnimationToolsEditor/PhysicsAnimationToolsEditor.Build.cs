@@ -39,6 +39,7 @@ public class PhysicsAnimationToolsEditor : ModuleRules
 			{
 				"CoreUObject",
 				"Engine",
+				"AssetRegistry",
 				"Slate",
 				"SlateCore",
 				"PropertyEditor",
@@ -2,6 +2,7 @@
 
 #include "AssetTypeActions_PhysicsAnimationAsset.h"
 #include "PhysicsAnimationAsset.h"
+#include "PhysicsAssetLODGenerator.h"
 #include "Framework/MultiBox/MultiBoxBuilder.h"
 
 #define LOCTEXT_NAMESPACE "AssetTypeActions"
@@ -41,7 +42,19 @@ uint32 FAssetTypeActions_PhysicsAnimationAsset::GetCategories()
 void FAssetTypeActions_PhysicsAnimationAsset::GetActions(const TArray<UObject*>& InObjects, FMenuBuilder & MenuBuilder)
 {
 	FAssetTypeActions_Base::GetActions(InObjects, MenuBuilder);
-	
+
+	const TArray<TWeakObjectPtr<UPhysicsAnimationAsset>> Assets = GetTypedWeakObjectPtrs<UPhysicsAnimationAsset>(InObjects);
+	MenuBuilder.AddMenuEntry(
+		LOCTEXT("GeneratePhysicsAssetLODs", "Generate Physics Asset LODs"),
+		LOCTEXT("GeneratePhysicsAssetLODsTooltip", "Regenerate the reduced physics assets listed in Physics Asset LODs"),
+		FSlateIcon(),
+		FUIAction(FExecuteAction::CreateLambda([Assets]()
+		{
+			for (const TWeakObjectPtr<UPhysicsAnimationAsset>& Asset : Assets)
+			{
+				FPhysicsAssetLODGenerator::Generate(Asset.Get());
+			}
+		})));
 }
 
 bool FAssetTypeActions_PhysicsAnimationAsset::HasActions(const TArray<UObject*>& InObjects) const
@@ -0,0 +1,173 @@
+// Copyright 2022-2023 XiaWen. All Rights Reserved.
+
+#include "PhysicsAssetLODGenerator.h"
+#include "PhysicsAnimationAsset.h"
+#include "AnimationRuntime.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Engine/SkeletalMesh.h"
+#include "PhysicsAssetUtils.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "PhysicsEngine/PhysicsConstraintTemplate.h"
+#include "PhysicsEngine/SkeletalBodySetup.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogPhysicsAssetLODGenerator, Log, All);
+
+namespace PhysicsAssetLODGenerator
+{
+	template<typename ElemType>
+	void AppendTransformed(TArray<ElemType>& Target, const TArray<ElemType>& Source, const FTransform& SourceToTarget)
+	{
+		for (ElemType Elem : Source)
+		{
+			Elem.SetTransform(Elem.GetTransform() * SourceToTarget);
+			Target.Add(Elem);
+		}
+	}
+}
+
+bool FPhysicsAssetLODGenerator::Generate(UPhysicsAnimationAsset* Asset)
+{
+	UPhysicsAsset* Source = Asset ? Asset->PhysicsAsset.Get() : nullptr;
+	const USkeletalMesh* PreviewMesh = Source ? Source->GetPreviewMesh() : nullptr;
+	if (PreviewMesh == nullptr)
+	{
+		UE_LOG(LogPhysicsAssetLODGenerator, Warning, TEXT("%s: the physics asset needs a preview mesh to generate LODs"), *GetNameSafe(Asset));
+		return false;
+	}
+
+	Asset->Modify();
+	for (int32 LODIndex = 0; LODIndex < Asset->PhysicsAssetLODs.Num(); ++LODIndex)
+	{
+		FPhysicsAssetLOD& LOD = Asset->PhysicsAssetLODs[LODIndex];
+		LOD.GeneratedPhysicsAsset = GenerateLOD(*Source, *PreviewMesh, LOD, FString::Printf(TEXT("%s_LOD%d"), *Source->GetName(), LODIndex + 1));
+	}
+	Asset->MarkPackageDirty();
+	return true;
+}
+
+UPhysicsAsset* FPhysicsAssetLODGenerator::GenerateLOD(UPhysicsAsset& Source, const USkeletalMesh& Mesh, const FPhysicsAssetLOD& LOD, const FString& AssetName)
+{
+	const FName RootBone = Mesh.GetRefSkeleton().GetBoneName(0);
+	if (Source.FindBodyIndex(RootBone) != INDEX_NONE && !LOD.KeptBodies.Contains(RootBone))
+	{
+		UE_LOG(LogPhysicsAssetLODGenerator, Warning, TEXT("%s: KeptBodies must include the root body %s"), *AssetName, *RootBone.ToString());
+		return nullptr;
+	}
+
+	const FString PackageName = FPackageName::GetLongPackagePath(Source.GetOutermost()->GetName()) / AssetName;
+	UPackage* Package = CreatePackage(*PackageName);
+	if (UObject* Existing = StaticFindObject(UObject::StaticClass(), Package, *AssetName))
+	{
+		Existing->Rename(nullptr, GetTransientPackage(), REN_DontCreateRedirectors | REN_NonTransactional);
+		Existing->MarkAsGarbage();
+	}
+
+	UPhysicsAsset* Result = DuplicateObject<UPhysicsAsset>(&Source, Package, *AssetName);
+	Result->SetFlags(RF_Public | RF_Standalone);
+	Reduce(*Result, Mesh, LOD);
+
+	FAssetRegistryModule::AssetCreated(Result);
+	Package->MarkPackageDirty();
+
+	UE_LOG(LogPhysicsAssetLODGenerator, Log, TEXT("Generated %s: %d/%d bodies, %d/%d constraints"), *PackageName,
+		Result->SkeletalBodySetups.Num(), Source.SkeletalBodySetups.Num(), Result->ConstraintSetup.Num(), Source.ConstraintSetup.Num());
+	return Result;
+}
+
+void FPhysicsAssetLODGenerator::Reduce(UPhysicsAsset& PhysicsAsset, const USkeletalMesh& Mesh, const FPhysicsAssetLOD& LOD)
+{
+	const FReferenceSkeleton& RefSkeleton = Mesh.GetRefSkeleton();
+	const auto GetRefPose = [&RefSkeleton](FName BoneName)
+	{
+		const int32 BoneIndex = RefSkeleton.FindBoneIndex(BoneName);
+		return BoneIndex != INDEX_NONE ? FAnimationRuntime::GetComponentSpaceTransformRefPose(RefSkeleton, BoneIndex) : FTransform::Identity;
+	};
+
+	// Closest kept body at or above each body, kept bodies map to themselves
+	const int32 NumBodies = PhysicsAsset.SkeletalBodySetups.Num();
+	TArray<int32> TargetBodies;
+	TargetBodies.Init(INDEX_NONE, NumBodies);
+	for (int32 BodyIndex = 0; BodyIndex < NumBodies; ++BodyIndex)
+	{
+		for (int32 BoneIndex = RefSkeleton.FindBoneIndex(PhysicsAsset.SkeletalBodySetups[BodyIndex]->BoneName); BoneIndex != INDEX_NONE; BoneIndex = RefSkeleton.GetParentIndex(BoneIndex))
+		{
+			const FName BoneName = RefSkeleton.GetBoneName(BoneIndex);
+			if (LOD.KeptBodies.Contains(BoneName) && PhysicsAsset.FindBodyIndex(BoneName) != INDEX_NONE)
+			{
+				TargetBodies[BodyIndex] = PhysicsAsset.FindBodyIndex(BoneName);
+				break;
+			}
+		}
+	}
+
+	// Merge the shapes of removed bodies into their target, in the target's bone space
+	if (LOD.bMergeRemovedShapes)
+	{
+		for (int32 BodyIndex = 0; BodyIndex < NumBodies; ++BodyIndex)
+		{
+			const int32 TargetIndex = TargetBodies[BodyIndex];
+			if (TargetIndex == INDEX_NONE || TargetIndex == BodyIndex)
+			{
+				continue;
+			}
+
+			const USkeletalBodySetup* Removed = PhysicsAsset.SkeletalBodySetups[BodyIndex];
+			USkeletalBodySetup* Target = PhysicsAsset.SkeletalBodySetups[TargetIndex];
+			const FTransform RemovedToTarget = GetRefPose(Removed->BoneName).GetRelativeTransform(GetRefPose(Target->BoneName));
+			using PhysicsAssetLODGenerator::AppendTransformed;
+			AppendTransformed(Target->AggGeom.SphereElems, Removed->AggGeom.SphereElems, RemovedToTarget);
+			AppendTransformed(Target->AggGeom.BoxElems, Removed->AggGeom.BoxElems, RemovedToTarget);
+			AppendTransformed(Target->AggGeom.SphylElems, Removed->AggGeom.SphylElems, RemovedToTarget);
+			AppendTransformed(Target->AggGeom.TaperedCapsuleElems, Removed->AggGeom.TaperedCapsuleElems, RemovedToTarget);
+			AppendTransformed(Target->AggGeom.ConvexElems, Removed->AggGeom.ConvexElems, RemovedToTarget);
+		}
+	}
+
+	// Constraints of removed bodies are dropped, kept bodies whose parent was removed are reattached to the parent's target
+	for (int32 ConstraintIndex = PhysicsAsset.ConstraintSetup.Num() - 1; ConstraintIndex >= 0; --ConstraintIndex)
+	{
+		FConstraintInstance& Instance = PhysicsAsset.ConstraintSetup[ConstraintIndex]->DefaultInstance;
+		const int32 ChildIndex = PhysicsAsset.FindBodyIndex(Instance.ConstraintBone1);
+		const int32 ParentIndex = PhysicsAsset.FindBodyIndex(Instance.ConstraintBone2);
+		const int32 NewParentIndex = ParentIndex != INDEX_NONE ? TargetBodies[ParentIndex] : INDEX_NONE;
+		if (ChildIndex == INDEX_NONE || TargetBodies[ChildIndex] != ChildIndex || NewParentIndex == INDEX_NONE)
+		{
+			FPhysicsAssetUtils::DestroyConstraint(&PhysicsAsset, ConstraintIndex);
+		}
+		else if (NewParentIndex != ParentIndex)
+		{
+			const FName NewParentBone = PhysicsAsset.SkeletalBodySetups[NewParentIndex]->BoneName;
+			const FTransform JointTransform = Instance.GetRefFrame(EConstraintFrame::Frame1) * GetRefPose(Instance.ConstraintBone1);
+			Instance.ConstraintBone2 = NewParentBone;
+			Instance.SetRefFrame(EConstraintFrame::Frame2, JointTransform.GetRelativeTransform(GetRefPose(NewParentBone)));
+		}
+	}
+
+	for (int32 BodyIndex = NumBodies - 1; BodyIndex >= 0; --BodyIndex)
+	{
+		if (TargetBodies[BodyIndex] != BodyIndex)
+		{
+			FPhysicsAssetUtils::DestroyBody(&PhysicsAsset, BodyIndex);
+		}
+	}
+
+	for (USkeletalBodySetup* BodySetup : PhysicsAsset.SkeletalBodySetups)
+	{
+		if (LOD.bReplaceConvexWithBoxes)
+		{
+			for (const FKConvexElem& Convex : BodySetup->AggGeom.ConvexElems)
+			{
+				const FVector Size = Convex.ElemBox.GetSize();
+				FKBoxElem& Box = BodySetup->AggGeom.BoxElems.Emplace_GetRef(Size.X, Size.Y, Size.Z);
+				Box.SetTransform(FTransform(Convex.ElemBox.GetCenter()) * Convex.GetTransform());
+			}
+			BodySetup->AggGeom.ConvexElems.Reset();
+		}
+		BodySetup->InvalidatePhysicsData();
+		BodySetup->CreatePhysicsMeshes();
+	}
+
+	PhysicsAsset.UpdateBodySetupIndexMap();
+	PhysicsAsset.UpdateBoundsBodiesArray();
+	PhysicsAsset.RefreshPhysicsAssetChange();
+}
@@ -0,0 +1,24 @@
+// Copyright 2022-2023 XiaWen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UPhysicsAnimationAsset;
+class UPhysicsAsset;
+class USkeletalMesh;
+struct FPhysicsAssetLOD;
+
+/**
+ * Generates the reduced physics assets listed in UPhysicsAnimationAsset::PhysicsAssetLODs.
+ * Each LOD is a copy of the source physics asset saved next to it as <Source>_LOD<N>, regenerated in place.
+ */
+class FPhysicsAssetLODGenerator
+{
+public:
+	static bool Generate(UPhysicsAnimationAsset* Asset);
+
+private:
+	static UPhysicsAsset* GenerateLOD(UPhysicsAsset& Source, const USkeletalMesh& Mesh, const FPhysicsAssetLOD& LOD, const FString& AssetName);
+	static void Reduce(UPhysicsAsset& PhysicsAsset, const USkeletalMesh& Mesh, const FPhysicsAssetLOD& LOD);
+};
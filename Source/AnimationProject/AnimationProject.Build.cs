@@ -9,5 +9,7 @@ public class AnimationProject : ModuleRules
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput" });
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "PhysicsCore", "Chaos", "PhysicsAnimationTools" });
 	}
 }
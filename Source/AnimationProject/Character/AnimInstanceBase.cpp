@@ -2,9 +2,19 @@
 
 #include "AnimInstanceBase.h"
 #include "CharacterBase.h"
+#include "CharacterLocomotionConfig.h"
+#include "DynamicMontageCache.h"
+#include "AnimationProject/Locomotion/LocomotionAnimBatch.h"
+#include "Animation/Skeleton.h"
 #include "Components/CapsuleComponent.h"
+#include "AnimationProject/Locomotion/LocomotionFeatures.h"
+#include "AnimationProject/Locomotion/LocomotionMath.h"
+#include "AnimationProject/Locomotion/LocomotionProfiler.h"
+#include "AnimationProject/Locomotion/LocomotionSnapshot.h"
+#include "AnimationProject/Locomotion/LocomotionStateTables.h"
 #include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "KismetTraceUtils.h"
 
 UAnimInstanceBase::UAnimInstanceBase(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -19,10 +29,32 @@ void UAnimInstanceBase::NativeInitializeAnimation()
 	{
 		CharacterBase = Cast<ACharacterBase>(Pawn);
 	}
+	LocomotionConfig = IsValid(CharacterBase) ? &CharacterBase->GetLocomotionConfig() : GetDefault<UCharacterLocomotionConfig>();
+	TraceQueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(LocomotionAnimTrace), false, CharacterBase);
+	UpdateFunction = VisitLocomotionFeatures(LocomotionConfig->FeatureSet, [](auto Features)
+	{
+		return &UAnimInstanceBase::UpdateWithFeatures<decltype(Features)>;
+	});
+
+	if (ULocomotionAnimBatch* AnimBatch = IsValid(CharacterBase) ? GetWorld()->GetSubsystem<ULocomotionAnimBatch>() : nullptr)
+	{
+		AnimBatch->Register(this);
+	}
+}
+
+void UAnimInstanceBase::NativeUninitializeAnimation()
+{
+	if (ULocomotionAnimBatch* AnimBatch = GetWorld() ? GetWorld()->GetSubsystem<ULocomotionAnimBatch>() : nullptr)
+	{
+		AnimBatch->Unregister(this);
+	}
+
+	Super::NativeUninitializeAnimation();
 }
 
 void UAnimInstanceBase::NativeUpdateAnimation(float DeltaSeconds)
 {
+	LOCOMOTION_PROFILE_SCOPE(AnimUpdate);
 	Super::NativeUpdateAnimation(DeltaSeconds);
 
 	DeltaTimeX = DeltaSeconds;
@@ -32,10 +64,16 @@ void UAnimInstanceBase::NativeUpdateAnimation(float DeltaSeconds)
 		return;
 	}
 
+	(this->*UpdateFunction)();
+}
+
+template <typename Features>
+void UAnimInstanceBase::UpdateWithFeatures()
+{
 	UpdateCharacterInfo();
 	UpdateAimingValues();
 	UpdateLayerValues();
-	UpdateFootIK();
+	UpdateFootIK<Features>();
 	switch (MovementState)
 	{
 	case EMovementState::Grounded:
@@ -43,33 +81,39 @@ void UAnimInstanceBase::NativeUpdateAnimation(float DeltaSeconds)
 		// todo, ML DoWhile
 		if (bShouldMove)
 		{
-			UpdateMovementValues();
+			UpdateMovementValues<Features>();
 			UpdateRotationValues();
 		}
 		else
 		{
-			if (CanRotateInPlace())
-			{
-				RotateInPlaceCheck();
-			}
-			else
+			if constexpr (Features::bTurnInPlace)
 			{
-				bRotateL = false;
-				bRotateR = false;
+				if (CanRotateInPlace())
+				{
+					RotateInPlaceCheck();
+				}
+				else
+				{
+					bRotateL = false;
+					bRotateR = false;
+				}
+
+				if (CanTurnInPlace())
+				{
+					TurnInPlaceCheck();
+				}
+				else
+				{
+					ElapsedDelayTime = 0.0f;
+				}
 			}
 
-			if (CanTurnInPlace())
+			if constexpr (Features::bDynamicTransitions)
 			{
-				TurnInPlaceCheck();
-			}
-			else
-			{
-				ElapsedDelayTime = 0.0f;
-			}
-
-			if (CanDynamicTransition())
-			{
-				DynamicTransitionCheck();
+				if (CanDynamicTransition())
+				{
+					DynamicTransitionCheck();
+				}
 			}
 		}
 		// ChangedToTrue
@@ -78,7 +122,7 @@ void UAnimInstanceBase::NativeUpdateAnimation(float DeltaSeconds)
 		bRotateR = false;
 		break;
 	case EMovementState::InAir:
-		UpdateInAirValues();
+		UpdateInAirValues<Features>();
 		break;
 	case EMovementState::Ragdoll:
 		UpdateRagdollValues();
@@ -106,6 +150,90 @@ void UAnimInstanceBase::BPISetOverlayOcerrideState(uint8 NewOverlayOverrideState
 	OverlayOverrideState = NewOverlayOverrideState;
 }
 
+void UAnimInstanceBase::TakeLocomotionSnapshot(FAnimLocomotionSnapshot& OutSnapshot) const
+{
+	OutSnapshot.MovementDirection = MovementDirection;
+	OutSnapshot.TrackedHipsDirection = TrackedHipsDirection;
+	OutSnapshot.GroundEntryState = GroundEntryState;
+	OutSnapshot.bShouldMove = bShouldMove;
+	OutSnapshot.bRotateL = bRotateL;
+	OutSnapshot.bRotateR = bRotateR;
+	OutSnapshot.bPivot = bPivot;
+	OutSnapshot.bJumped = bJumped;
+	OutSnapshot.RotateRate = RotateRate;
+	OutSnapshot.ElapsedDelayTime = ElapsedDelayTime;
+	OutSnapshot.InputYawOffsetTime = InputYawOffsetTime;
+	OutSnapshot.FallSpeed = FallSpeed;
+	OutSnapshot.LandPrediction = LandPrediction;
+	OutSnapshot.FlailRate = FlailRate;
+	OutSnapshot.DiagonalScaleAmount = DiagonalScaleAmount;
+	OutSnapshot.WalkRunBlend = WalkRunBlend;
+	OutSnapshot.StrideBlend = StrideBlend;
+	OutSnapshot.StandingPlayRate = StandingPlayRate;
+	OutSnapshot.CrouchingPlayRate = CrouchingPlayRate;
+	OutSnapshot.RotationScale = RotationScale;
+	OutSnapshot.PelvisAlpha = PelvisAlpha;
+	OutSnapshot.FootLockLAlpha = FootLockLAlpha;
+	OutSnapshot.FootLockRAlpha = FootLockRAlpha;
+	OutSnapshot.VelocityBlend = VelocityBlend;
+	OutSnapshot.LeanAmount = LeanAmount;
+	OutSnapshot.SmoothedAimingRotation = SmoothedAimingRotation;
+	OutSnapshot.RelativeAccelerationAmount = RelativeAccelerationAmount;
+	OutSnapshot.FootLockLLocation = FootLockLLocation;
+	OutSnapshot.FootLockLRotation = FootLockLRotation;
+	OutSnapshot.FootLockRLocation = FootLockRLocation;
+	OutSnapshot.FootLockRRotation = FootLockRRotation;
+	OutSnapshot.FootOffsetLTarget = FootOffsetLTarget;
+	OutSnapshot.FootOffsetLLocation = FootOffsetLLocation;
+	OutSnapshot.FootOffsetLRotation = FootOffsetLRotation;
+	OutSnapshot.FootOffsetRTarget = FootOffsetRTarget;
+	OutSnapshot.FootOffsetRLocation = FootOffsetRLocation;
+	OutSnapshot.FootOffsetRRotation = FootOffsetRRotation;
+	OutSnapshot.PelvisOffset = PelvisOffset;
+}
+
+void UAnimInstanceBase::ApplyLocomotionSnapshot(const FAnimLocomotionSnapshot& Snapshot)
+{
+	MovementDirection = Snapshot.MovementDirection;
+	TrackedHipsDirection = Snapshot.TrackedHipsDirection;
+	GroundEntryState = Snapshot.GroundEntryState;
+	bShouldMove = Snapshot.bShouldMove;
+	bRotateL = Snapshot.bRotateL;
+	bRotateR = Snapshot.bRotateR;
+	bPivot = Snapshot.bPivot;
+	bJumped = Snapshot.bJumped;
+	RotateRate = Snapshot.RotateRate;
+	ElapsedDelayTime = Snapshot.ElapsedDelayTime;
+	InputYawOffsetTime = Snapshot.InputYawOffsetTime;
+	FallSpeed = Snapshot.FallSpeed;
+	LandPrediction = Snapshot.LandPrediction;
+	FlailRate = Snapshot.FlailRate;
+	DiagonalScaleAmount = Snapshot.DiagonalScaleAmount;
+	WalkRunBlend = Snapshot.WalkRunBlend;
+	StrideBlend = Snapshot.StrideBlend;
+	StandingPlayRate = Snapshot.StandingPlayRate;
+	CrouchingPlayRate = Snapshot.CrouchingPlayRate;
+	RotationScale = Snapshot.RotationScale;
+	PelvisAlpha = Snapshot.PelvisAlpha;
+	FootLockLAlpha = Snapshot.FootLockLAlpha;
+	FootLockRAlpha = Snapshot.FootLockRAlpha;
+	VelocityBlend = Snapshot.VelocityBlend;
+	LeanAmount = Snapshot.LeanAmount;
+	SmoothedAimingRotation = Snapshot.SmoothedAimingRotation;
+	RelativeAccelerationAmount = Snapshot.RelativeAccelerationAmount;
+	FootLockLLocation = Snapshot.FootLockLLocation;
+	FootLockLRotation = Snapshot.FootLockLRotation;
+	FootLockRLocation = Snapshot.FootLockRLocation;
+	FootLockRRotation = Snapshot.FootLockRRotation;
+	FootOffsetLTarget = Snapshot.FootOffsetLTarget;
+	FootOffsetLLocation = Snapshot.FootOffsetLLocation;
+	FootOffsetLRotation = Snapshot.FootOffsetLRotation;
+	FootOffsetRTarget = Snapshot.FootOffsetRTarget;
+	FootOffsetRLocation = Snapshot.FootOffsetRLocation;
+	FootOffsetRRotation = Snapshot.FootOffsetRRotation;
+	PelvisOffset = Snapshot.PelvisOffset;
+}
+
 void UAnimInstanceBase::AnimNotify_HResetGroundedEntryState()
 {
 	GroundEntryState = EGroundedEntryState::None;
@@ -113,8 +241,8 @@ void UAnimInstanceBase::AnimNotify_HResetGroundedEntryState()
 
 void UAnimInstanceBase::PlayTransition(FDynamicMontageParams Parameters)
 {
-	PlaySlotAnimationAsDynamicMontage(Parameters.Animation, FName("Grounded Slot"), Parameters.BlendInTime,
-		Parameters.BlendOutTime, Parameters.PlayRate, 1, 0.0f, Parameters.StartTime);
+	PlayCachedSlotAnimation(Parameters.Animation, FName("Grounded Slot"), Parameters.BlendInTime,
+		Parameters.BlendOutTime, Parameters.PlayRate, Parameters.StartTime);
 }
 
 void UAnimInstanceBase::AnimNotify_StopTransition()
@@ -128,8 +256,8 @@ void UAnimInstanceBase::PlayDynamicTransition(float ReTriggerDelay, FDynamicMont
 {
 	// todo delay ReTriggerDelay, use set timer
 	// todo gate
-	PlaySlotAnimationAsDynamicMontage(Parameters.Animation, FName("Grounded Slot"), Parameters.BlendInTime,
-		Parameters.BlendOutTime, Parameters.PlayRate, 1, 0.0f, Parameters.StartTime);
+	PlayCachedSlotAnimation(Parameters.Animation, FName("Grounded Slot"), Parameters.BlendInTime,
+		Parameters.BlendOutTime, Parameters.PlayRate, Parameters.StartTime);
 }
 
 void UAnimInstanceBase::AnimNotify_NStopR()
@@ -223,7 +351,7 @@ void UAnimInstanceBase::AnimNotify_Pistol2HReadyRelaxed()
 
 void UAnimInstanceBase::AnimNotify_Pivot()
 {
-	bPivot = Speed < TriggerRivotSpeedLimit;
+	bPivot = Speed < LocomotionConfig->TriggerRivotSpeedLimit;
 	// todo delay 0.1
 	bPivot = false;
 }
@@ -274,7 +402,7 @@ void UAnimInstanceBase::UpdateCharacterInfo()
 void UAnimInstanceBase::UpdateAimingValues()
 {
 	SmoothedAimingRotation = UKismetMathLibrary::RInterpTo(
-		SmoothedAimingRotation, AimingRotation, DeltaTimeX, SmoothedAimingRotationInterpSpeed);
+		SmoothedAimingRotation, AimingRotation, DeltaTimeX, LocomotionConfig->SmoothedAimingRotationInterpSpeed);
 	
 	FRotator DeltaRotation = AimingRotation - CharacterBase->GetActorRotation();
 	AimingAngle = FVector2d(DeltaRotation.Yaw, DeltaRotation.Pitch);
@@ -299,7 +427,7 @@ void UAnimInstanceBase::UpdateAimingValues()
 		{
 			FRotator DeltaRotation = MovementInput.Rotation() - CharacterBase->GetActorRotation();
 			float ClampedValue = UKismetMathLibrary::MapRangeClamped(DeltaRotation.Yaw, -180.0f, 180.0f, 0.0f, 1.0f);
-			InputYawOffsetTime = UKismetMathLibrary::FInterpTo(InputYawOffsetTime, ClampedValue, DeltaTimeX, InputYawOffsetInterpSpeed);
+			InputYawOffsetTime = UKismetMathLibrary::FInterpTo(InputYawOffsetTime, ClampedValue, DeltaTimeX, LocomotionConfig->InputYawOffsetInterpSpeed);
 		}
 		break;
 	default:
@@ -330,37 +458,52 @@ void UAnimInstanceBase::UpdateLayerValues()
 	ArmRMS = 1 - FMath::Floor(ArmRLS);
 }
 
+template <typename Features>
 void UAnimInstanceBase::UpdateFootIK()
 {
-	SetFootLocking(FName("Enable_FootIK_L"), FName("FootLock_L"), FName("ik_foot_l"),
-		FootLockLAlpha, FootLockLLocation, FootLockLRotation);
-	SetFootLocking(FName("Enable_FootIK_R"), FName("FootLock_R"), FName("ik_foot_r"),
-	FootLockRAlpha, FootLockRLocation, FootLockRRotation);
-	switch (MovementState)
+	LOCOMOTION_PROFILE_SCOPE(FootIK);
+	if constexpr (Features::bFootLocking)
 	{
-	case EMovementState::None:
-	case EMovementState::Grounded:
-	case EMovementState::Mantling:
-		SetFootOffsets(FName("Enable_FootIK_L"), FName("ik_foot_l"), FName("root"),
-			FootOffsetLTarget, FootOffsetLLocation, FootOffsetLRotation);
-		SetFootOffsets(FName("Enable_FootIK_R"), FName("ik_foot_r"), FName("root"),
-			FootOffsetRTarget, FootOffsetRLocation, FootOffsetRRotation);
-		SetPelvisIKOffset(FootOffsetLTarget, FootOffsetRTarget);
-		break;
-	case EMovementState::InAir:
-		SetPelvisIKOffset(FVector::ZeroVector, FVector::ZeroVector);
-		ResetIKOffsets();
-		break;
-	default:
-		break;;
+		SetFootLocking(FName("Enable_FootIK_L"), FName("FootLock_L"), FName("ik_foot_l"),
+			FootLockLAlpha, FootLockLLocation, FootLockLRotation);
+		SetFootLocking(FName("Enable_FootIK_R"), FName("FootLock_R"), FName("ik_foot_r"),
+			FootLockRAlpha, FootLockRLocation, FootLockRRotation);
+	}
+	if constexpr (Features::bFootIK)
+	{
+		switch (MovementState)
+		{
+		case EMovementState::None:
+		case EMovementState::Grounded:
+		case EMovementState::Mantling:
+			SetFootOffsets(FName("Enable_FootIK_L"), FName("ik_foot_l"), FName("root"),
+				FootOffsetLTarget, FootOffsetLLocation, FootOffsetLRotation);
+			SetFootOffsets(FName("Enable_FootIK_R"), FName("ik_foot_r"), FName("root"),
+				FootOffsetRTarget, FootOffsetRLocation, FootOffsetRRotation);
+			SetPelvisIKOffset(FootOffsetLTarget, FootOffsetRTarget);
+			break;
+		case EMovementState::InAir:
+			SetPelvisIKOffset(FVector::ZeroVector, FVector::ZeroVector);
+			ResetIKOffsets();
+			break;
+		default:
+			break;;
+		}
 	}
 }
 
+template <typename Features>
 void UAnimInstanceBase::UpdateInAirValues()
 {
 	FallSpeed = Velocity.Z;
-	LandPrediction = CalculateLandPrediction();
-	LeanAmount = InterpLeanAmount(LeanAmount, CalculateInAirLeanAmount(), InAirLeanInterpSpeed, DeltaTimeX);
+	if constexpr (Features::bLandPrediction)
+	{
+		LandPrediction = CalculateLandPrediction();
+	}
+	if constexpr (Features::bAdditiveLeaning)
+	{
+		LeanAmount = InterpLeanAmount(LeanAmount, CalculateInAirLeanAmount(), LocomotionConfig->InAirLeanInterpSpeed, DeltaTimeX);
+	}
 }
 
 void UAnimInstanceBase::UpdateRagdollValues()
@@ -369,17 +512,40 @@ void UAnimInstanceBase::UpdateRagdollValues()
 		GetOwningComponent()->GetPhysicsLinearVelocity().Size(), 0.0f, 1000.0f, 0.0f, 1.0f);
 }
 
+template <typename Features>
 void UAnimInstanceBase::UpdateMovementValues()
 {
-	VelocityBlend = InterpVelocityBlend(VelocityBlend, CalculateVelocityBlend(), VelocityBlendInterpSpeed, DeltaTimeX);
-	DiagonalScaleAmount = CalculateDiagonalScaleAmount();
-	RelativeAccelerationAmount = CalculateRelativeAccelerationAmount();
-	FLeanAmount TargetLeanAmount;
-	TargetLeanAmount.LR = RelativeAccelerationAmount.Y;
-	TargetLeanAmount.FB = RelativeAccelerationAmount.X;
-	LeanAmount = InterpLeanAmount(LeanAmount, TargetLeanAmount, GroundedLeanInterpSpeed, DeltaTimeX);
+	// 本帧已由ULocomotionAnimBatch批量算好时直接取用，URO等导致DeltaTime不同时仍按标量计算
+	if (BatchedMovementValues.FrameCounter == GFrameCounter && BatchedMovementValues.DeltaSeconds == DeltaTimeX)
+	{
+		if (ULocomotionAnimBatch::ShouldVerify())
+		{
+			VerifyBatchedMovementValues();
+		}
+		VelocityBlend = BatchedMovementValues.VelocityBlend;
+		DiagonalScaleAmount = CalculateDiagonalScaleAmount();
+		RelativeAccelerationAmount = BatchedMovementValues.RelativeAccelerationAmount;
+		if constexpr (Features::bAdditiveLeaning)
+		{
+			LeanAmount = BatchedMovementValues.LeanAmount;
+		}
+	}
+	else
+	{
+		VelocityBlend = InterpVelocityBlend(VelocityBlend, CalculateVelocityBlend(), LocomotionConfig->VelocityBlendInterpSpeed, DeltaTimeX);
+		DiagonalScaleAmount = CalculateDiagonalScaleAmount();
+		RelativeAccelerationAmount = CalculateRelativeAccelerationAmount();
+		if constexpr (Features::bAdditiveLeaning)
+		{
+			FLeanAmount TargetLeanAmount;
+			TargetLeanAmount.LR = RelativeAccelerationAmount.Y;
+			TargetLeanAmount.FB = RelativeAccelerationAmount.X;
+			LeanAmount = InterpLeanAmount(LeanAmount, TargetLeanAmount, LocomotionConfig->GroundedLeanInterpSpeed, DeltaTimeX);
+		}
+	}
 	WalkRunBlend = CalculateWalkRunBlend();
-	StrideBlend = CalculateStrideBlend();
+	// 不做步幅混合时按完整步幅计算播放速率
+	StrideBlend = Features::bStrideBlending ? CalculateStrideBlend() : 1.0f;
 	StandingPlayRate = CalculateStandingPlayRate();
 	CrouchingPlayRate = CalculateCrouchingPlayRate();
 }
@@ -388,8 +554,8 @@ void UAnimInstanceBase::UpdateRotationValues()
 {
 	MovementDirection = CalculateMovementDirection();
 	float DeltaYaw = (Velocity.Rotation() - CharacterBase->GetControlRotation()).Yaw;
-	FVector YawOffsetFBValue = YawOffsetFB->GetVectorValue(DeltaYaw);
-	FVector YawOffsetLRValue = YawOffsetLR->GetVectorValue(DeltaYaw);
+	FVector YawOffsetFBValue = LocomotionConfig->YawOffsetFB->GetVectorValue(DeltaYaw);
+	FVector YawOffsetLRValue = LocomotionConfig->YawOffsetLR->GetVectorValue(DeltaYaw);
 	FYaw = YawOffsetFBValue.X;
 	BYaw = YawOffsetFBValue.Y;
 	LYaw = YawOffsetLRValue.X;
@@ -403,22 +569,22 @@ bool UAnimInstanceBase::ShouldMoveCheck()
 
 void UAnimInstanceBase::RotateInPlaceCheck()
 {
-	bRotateL = AimingAngle.X < RotateMinThreshold;
-	bRotateR = AimingAngle.X < RotateMaxThreshold;
+	bRotateL = AimingAngle.X < LocomotionConfig->RotateMinThreshold;
+	bRotateR = AimingAngle.X < LocomotionConfig->RotateMaxThreshold;
 
 	if (bRotateL || bRotateR)
 	{
-		RotateRate = UKismetMathLibrary::MapRangeClamped(AimYawRate, AimYawRateMinRange, AimYawRateMaxRange, MinPlayRate, MaxPlayRate);
+		RotateRate = UKismetMathLibrary::MapRangeClamped(AimYawRate, LocomotionConfig->AimYawRateMinRange, LocomotionConfig->AimYawRateMaxRange, LocomotionConfig->MinPlayRate, LocomotionConfig->MaxPlayRate);
 	}
 }
 
 void UAnimInstanceBase::TurnInPlaceCheck()
 {
-	bool bCheck = FMath::Abs(AimingAngle.X > TurnCheckMinAngle) && AimYawRate < AimYawRateLimit;
+	bool bCheck = FMath::Abs(AimingAngle.X > LocomotionConfig->TurnCheckMinAngle) && AimYawRate < LocomotionConfig->AimYawRateLimit;
 	if (bCheck)
 	{
 		ElapsedDelayTime += DeltaTimeX;
-		float ClampedValue = UKismetMathLibrary::MapRangeClamped(FMath::Abs(AimingAngle.X), TurnCheckMinAngle, 180.0f, MinAngleDelay, MaxAngleDelay);
+		float ClampedValue = UKismetMathLibrary::MapRangeClamped(FMath::Abs(AimingAngle.X), LocomotionConfig->TurnCheckMinAngle, 180.0f, LocomotionConfig->MinAngleDelay, LocomotionConfig->MaxAngleDelay);
 		if (ElapsedDelayTime > ClampedValue)
 		{
 			TurnInPlace(FRotator(0.0f, 0.0f, AimingRotation.Yaw), 1.0f, 0.0f, false);
@@ -516,12 +682,15 @@ void UAnimInstanceBase::SetFootOffsets(FName EnableFootIKCurve, FName IKFootBone
 		FVector IKFootBoneLocation = GetOwningComponent()->GetSocketLocation(IKFootBone);
 		FVector RootBoneLocation = GetOwningComponent()->GetSocketLocation(RootBone);
 		FVector IKFootFloorLocation = FVector(IKFootBoneLocation.X, IKFootBoneLocation.Y, RootBoneLocation.Z);
-		FVector Start = IKFootFloorLocation + FVector(0.0, 0.0, IKTraceDistanceAboveFoot);
-		FVector End = IKFootFloorLocation - FVector(0.0, 0.0, IKTraceDistanceBelowFoot);
+		FVector Start = IKFootFloorLocation + FVector(0.0, 0.0, LocomotionConfig->IKTraceDistanceAboveFoot);
+		FVector End = IKFootFloorLocation - FVector(0.0, 0.0, LocomotionConfig->IKTraceDistanceBelowFoot);
 		FHitResult HitResult;
-		TArray<AActor*> ActorsToIgnore;
-		UKismetSystemLibrary::LineTraceSingle(this, Start, End, ETraceTypeQuery::TraceTypeQuery1, false, ActorsToIgnore,
-			EDrawDebugTrace::ForOneFrame, HitResult, true, FLinearColor::Red, FLinearColor::Green, 5.0f);
+		const bool bHit = GetWorld()->LineTraceSingleByChannel(HitResult, Start, End,
+			UEngineTypes::ConvertToCollisionChannel(ETraceTypeQuery::TraceTypeQuery1), TraceQueryParams);
+#if ENABLE_DRAW_DEBUG
+		DrawDebugLineTraceSingle(GetWorld(), Start, End, CharacterBase->GetTraceDebugType(EDrawDebugTrace::ForOneFrame),
+			bHit, HitResult, FLinearColor::Red, FLinearColor::Green, 5.0f);
+#endif
 		bool bWalkable = CharacterBase->GetCharacterMovement()->IsWalkable(HitResult);
 		FRotator TargetRotationOffset = FRotator::ZeroRotator;
 		FVector ImpactPoint = FVector::ZeroVector;
@@ -530,7 +699,7 @@ void UAnimInstanceBase::SetFootOffsets(FName EnableFootIKCurve, FName IKFootBone
 		{
 			ImpactPoint = HitResult.ImpactPoint;
 			ImpactNormal = HitResult.ImpactNormal;
-			CurrentLocationTarget = ImpactPoint + ImpactNormal * FootHeight - (IKFootFloorLocation + FootHeight * FVector(0, 0, 1.0f));
+			CurrentLocationTarget = ImpactPoint + ImpactNormal * LocomotionConfig->FootHeight - (IKFootFloorLocation + LocomotionConfig->FootHeight * FVector(0, 0, 1.0f));
 			TargetRotationOffset = FRotator(-FMath::Atan2(ImpactNormal.X, ImpactNormal.X), 0.0f, FMath::Atan2(ImpactNormal.Y, ImpactNormal.Z));
 		}
 		
@@ -581,14 +750,17 @@ float UAnimInstanceBase::CalculateLandPrediction()
 		UKismetMathLibrary::MapRangeClamped(Velocity.Z, 0.0f, -4000.0f, 50.0f, 2000.0f);
 	float Radius = CharacterBase->GetCapsuleComponent()->GetUnscaledCapsuleRadius();
 	float HalfHeight = CharacterBase->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
-	TArray<AActor*> ActorsToIgnore;
 	FHitResult HitResult;
-	UKismetSystemLibrary::CapsuleTraceSingleByProfile(this, Start, End, Radius, HalfHeight, FName("ALS_Character"), false,
-		ActorsToIgnore, EDrawDebugTrace::ForOneFrame, HitResult, true, FColor::Red, FColor::Green, 5.0f);
+	const bool bHit = GetWorld()->SweepSingleByProfile(HitResult, Start, End, FQuat::Identity, FName("ALS_Character"),
+		FCollisionShape::MakeCapsule(Radius, HalfHeight), TraceQueryParams);
+#if ENABLE_DRAW_DEBUG
+	DrawDebugCapsuleTraceSingle(GetWorld(), Start, End, Radius, HalfHeight, CharacterBase->GetTraceDebugType(EDrawDebugTrace::ForOneFrame),
+		bHit, HitResult, FColor::Red, FColor::Green, 5.0f);
+#endif
 	bool bWalkable = CharacterBase->GetCharacterMovement()->IsWalkable(HitResult);
 	if (bWalkable && HitResult.bBlockingHit)
 	{
-		return FMath::Lerp(LandPredictionCurve->GetFloatValue(HitResult.Time), 0.0f, GetCurveValue(FName("Mask_LandPrediction")));
+		return FMath::Lerp(LocomotionConfig->LandPredictionCurve->GetFloatValue(HitResult.Time), 0.0f, GetCurveValue(FName("Mask_LandPrediction")));
 	}
 	else
 	{
@@ -598,10 +770,7 @@ float UAnimInstanceBase::CalculateLandPrediction()
 
 FLeanAmount UAnimInstanceBase::InterpLeanAmount(FLeanAmount Current, FLeanAmount Target, float InterpSpeed, float DeltaTime)
 {
-	FLeanAmount ResultAmount;
-	ResultAmount.LR = FMath::FInterpTo(Current.LR, Target.LR, DeltaTime, InterpSpeed);
-	ResultAmount.FB = FMath::FInterpTo(Current.FB, Target.FB, DeltaTime, InterpSpeed);
-	return ResultAmount;
+	return LocomotionMath::InterpLeanAmount(Current, Target, InterpSpeed, DeltaTime);
 }
 
 FLeanAmount UAnimInstanceBase::CalculateInAirLeanAmount()
@@ -609,7 +778,7 @@ FLeanAmount UAnimInstanceBase::CalculateInAirLeanAmount()
 	FLeanAmount ResultAmount;
 	FVector Lean3d = CharacterBase->GetActorRotation().UnrotateVector(Velocity) / 350.0f;
 	FVector2d Lean2d = FVector2d(Lean3d.Y, Lean3d.X);
-	FVector2d Speed2d = Lean2d * LeanInAirCurve->GetFloatValue(FallSpeed);
+	FVector2d Speed2d = Lean2d * LocomotionConfig->LeanInAirCurve->GetFloatValue(FallSpeed);
 	ResultAmount.LR = Speed2d.X;
 	ResultAmount.FB = Speed2d.Y;
 	return ResultAmount;
@@ -617,46 +786,61 @@ FLeanAmount UAnimInstanceBase::CalculateInAirLeanAmount()
 
 FVelocityBlend UAnimInstanceBase::InterpVelocityBlend(FVelocityBlend Current, FVelocityBlend Target, float InterpSpeed, float DeltaTime)
 {
-	FVelocityBlend ResultBlend;
-	ResultBlend.F = FMath::FInterpTo(Current.F, Target.F, DeltaTime, InterpSpeed);
-	ResultBlend.B = FMath::FInterpTo(Current.B, Target.B, DeltaTime, InterpSpeed);
-	ResultBlend.L = FMath::FInterpTo(Current.L, Target.L, DeltaTime, InterpSpeed);
-	ResultBlend.R = FMath::FInterpTo(Current.R, Target.R, DeltaTime, InterpSpeed);
-	return ResultBlend;
+	return LocomotionMath::InterpVelocityBlend(Current, Target, InterpSpeed, DeltaTime);
 }
 
 FVelocityBlend UAnimInstanceBase::CalculateVelocityBlend()
 {
 	Velocity.Normalize();
-	FVector LocRelativeVelocityDir = CharacterBase->GetActorRotation().UnrotateVector(Velocity);
-	float Sum = FMath::Abs(LocRelativeVelocityDir.X) + FMath::Abs(LocRelativeVelocityDir.Y) + FMath::Abs(LocRelativeVelocityDir.Z);
-	FVector RelativeDirection = LocRelativeVelocityDir / Sum;
-	FVelocityBlend ResultBlend;
-	ResultBlend.F = FMath::Clamp(RelativeDirection.X, 0.0f, 1.0f);
-	ResultBlend.B = FMath::Clamp(RelativeDirection.X, -1.0f, 0.0f);
-	ResultBlend.L = FMath::Clamp(RelativeDirection.Y, -1.0f, 0.0f);
-	ResultBlend.R = FMath::Clamp(RelativeDirection.Y, 0.0f, 1.0f);
-	return ResultBlend;
+	const FVector LocRelativeVelocityDir = CharacterBase->GetActorRotation().UnrotateVector(Velocity);
+	return LocomotionMath::VelocityBlend<FVelocityBlend>(LocRelativeVelocityDir.X, LocRelativeVelocityDir.Y, LocRelativeVelocityDir.Z);
 }
 
 float UAnimInstanceBase::CalculateDiagonalScaleAmount()
 {
-	return DiagonalScaleAmountCurve->GetFloatValue(FMath::Abs(VelocityBlend.F + VelocityBlend.B));
+	return LocomotionConfig->DiagonalScaleAmountCurve->GetFloatValue(FMath::Abs(VelocityBlend.F + VelocityBlend.B));
 }
 
 FVector UAnimInstanceBase::CalculateRelativeAccelerationAmount()
 {
 	UCharacterMovementComponent* MovementComponent = Cast<UCharacterMovementComponent>(CharacterBase->GetMovementComponent());
-	if (FVector::DotProduct(Acceleration, Velocity) > 0.0f)
-	{
-		FVector ClampAcceleration = UKismetMathLibrary::Vector_ClampSizeMax(Acceleration, MovementComponent->GetMaxAcceleration()) / MovementComponent->GetMaxAcceleration();
-		return CharacterBase->GetActorRotation().UnrotateVector(ClampAcceleration);
-	}
-	else
+	const float MaxSize = FVector::DotProduct(Acceleration, Velocity) > 0.0f ? MovementComponent->GetMaxAcceleration() : MovementComponent->GetMaxBrakingDeceleration();
+	// 上限过小时Vector_ClampSizeMax返回0向量，再除以上限会得到NaN，与批量版本一样取0
+	if (MaxSize < KINDA_SMALL_NUMBER)
 	{
-		FVector ClampBrakingAcceleration = UKismetMathLibrary::Vector_ClampSizeMax(Acceleration, MovementComponent->GetMaxBrakingDeceleration()) / MovementComponent->GetMaxBrakingDeceleration();
-		return CharacterBase->GetActorRotation().UnrotateVector(ClampBrakingAcceleration);
+		return FVector::ZeroVector;
 	}
+	const FVector ClampAcceleration = UKismetMathLibrary::Vector_ClampSizeMax(Acceleration, MaxSize) / MaxSize;
+	return CharacterBase->GetActorRotation().UnrotateVector(ClampAcceleration);
+}
+
+void UAnimInstanceBase::VerifyBatchedMovementValues()
+{
+	// 在用批量结果覆盖之前按标量版本再算一次，两者只允许有浮点误差
+	constexpr float Tolerance = 1.e-3f;
+	const FVelocityBlend ScalarVelocityBlend = InterpVelocityBlend(VelocityBlend, CalculateVelocityBlend(), LocomotionConfig->VelocityBlendInterpSpeed, DeltaTimeX);
+	const FVector ScalarRelativeAcceleration = CalculateRelativeAccelerationAmount();
+	FLeanAmount TargetLeanAmount;
+	TargetLeanAmount.LR = ScalarRelativeAcceleration.Y;
+	TargetLeanAmount.FB = ScalarRelativeAcceleration.X;
+	const FLeanAmount ScalarLeanAmount = InterpLeanAmount(LeanAmount, TargetLeanAmount, LocomotionConfig->GroundedLeanInterpSpeed, DeltaTimeX);
+
+	const FVelocityBlend& BatchedVelocityBlend = BatchedMovementValues.VelocityBlend;
+	const FLeanAmount& BatchedLeanAmount = BatchedMovementValues.LeanAmount;
+	ensureMsgf(FMath::IsNearlyEqual(BatchedVelocityBlend.F, ScalarVelocityBlend.F, Tolerance)
+		&& FMath::IsNearlyEqual(BatchedVelocityBlend.B, ScalarVelocityBlend.B, Tolerance)
+		&& FMath::IsNearlyEqual(BatchedVelocityBlend.L, ScalarVelocityBlend.L, Tolerance)
+		&& FMath::IsNearlyEqual(BatchedVelocityBlend.R, ScalarVelocityBlend.R, Tolerance),
+		TEXT("%s batched VelocityBlend (%f, %f, %f, %f) differs from scalar (%f, %f, %f, %f)"), *GetNameSafe(CharacterBase),
+		BatchedVelocityBlend.F, BatchedVelocityBlend.B, BatchedVelocityBlend.L, BatchedVelocityBlend.R,
+		ScalarVelocityBlend.F, ScalarVelocityBlend.B, ScalarVelocityBlend.L, ScalarVelocityBlend.R);
+	ensureMsgf(BatchedMovementValues.RelativeAccelerationAmount.Equals(ScalarRelativeAcceleration, Tolerance),
+		TEXT("%s batched RelativeAccelerationAmount %s differs from scalar %s"), *GetNameSafe(CharacterBase),
+		*BatchedMovementValues.RelativeAccelerationAmount.ToString(), *ScalarRelativeAcceleration.ToString());
+	ensureMsgf(FMath::IsNearlyEqual(BatchedLeanAmount.LR, ScalarLeanAmount.LR, Tolerance)
+		&& FMath::IsNearlyEqual(BatchedLeanAmount.FB, ScalarLeanAmount.FB, Tolerance),
+		TEXT("%s batched LeanAmount (%f, %f) differs from scalar (%f, %f)"), *GetNameSafe(CharacterBase),
+		BatchedLeanAmount.LR, BatchedLeanAmount.FB, ScalarLeanAmount.LR, ScalarLeanAmount.FB);
 }
 
 float UAnimInstanceBase::CalculateWalkRunBlend()
@@ -675,22 +859,22 @@ float UAnimInstanceBase::CalculateWalkRunBlend()
 float UAnimInstanceBase::CalculateStrideBlend()
 {
 	float InterpSpeed = FMath::Clamp(GetCurveValue(FName("Weight_Gait")) - 1.0f, 0.0f, 1.0f);
-	float SpeedLerp = FMath::Lerp(StrideBlendNWalk->GetFloatValue(Speed), StrideBlendNRun->GetFloatValue(Speed), InterpSpeed);
-	return FMath::Lerp(SpeedLerp, StrideBlendCWalk->GetFloatValue(Speed), GetCurveValue(FName("BasePose_CLF")));
+	float SpeedLerp = FMath::Lerp(LocomotionConfig->StrideBlendNWalk->GetFloatValue(Speed), LocomotionConfig->StrideBlendNRun->GetFloatValue(Speed), InterpSpeed);
+	return FMath::Lerp(SpeedLerp, LocomotionConfig->StrideBlendCWalk->GetFloatValue(Speed), GetCurveValue(FName("BasePose_CLF")));
 }
 
 float UAnimInstanceBase::CalculateStandingPlayRate()
 {
 	float InterpSpeed1 = FMath::Clamp(GetCurveValue(FName("Weight_Gait")) - 1.0f, 0.0f, 1.0f);
-	float SpeedLerp = FMath::Lerp(Speed/AnimatedWalkSpeed, Speed/AnimatedRunSpeed, InterpSpeed1);
+	float SpeedLerp = FMath::Lerp(Speed/LocomotionConfig->AnimatedWalkSpeed, Speed/LocomotionConfig->AnimatedRunSpeed, InterpSpeed1);
 	float InterpSpeed2 = FMath::Clamp(GetCurveValue(FName("Weight_Gait")) - 2.0f, 0.0f, 1.0f);
-	float SppedLerp2 = FMath::Lerp(SpeedLerp, Speed/AnimatedSprintSpeed,  InterpSpeed2);
+	float SppedLerp2 = FMath::Lerp(SpeedLerp, Speed/LocomotionConfig->AnimatedSprintSpeed,  InterpSpeed2);
 	return FMath::Clamp((SppedLerp2 / StrideBlend) / GetOwningComponent()->GetComponentScale().Z, 0.0f, 3.0f);
 }
 
 float UAnimInstanceBase::CalculateCrouchingPlayRate()
 {
-	return FMath::Clamp((Speed / AnimatedCrouchSpeed) / StrideBlend / GetOwningComponent()->GetComponentScale().Z, 0.0f, 2.0f);
+	return FMath::Clamp((Speed / LocomotionConfig->AnimatedCrouchSpeed) / StrideBlend / GetOwningComponent()->GetComponentScale().Z, 0.0f, 2.0f);
 }
 
 EMovementDirection UAnimInstanceBase::CalculateMovementDirection()
@@ -713,57 +897,26 @@ EMovementDirection UAnimInstanceBase::CalculateMovementDirection()
 void UAnimInstanceBase::TurnInPlace(FRotator TargetRotation, float PlayRateScale, float StartTime, bool OverrideCurrent)
 {
 	float TurnAngle = (TargetRotation - CharacterBase->GetActorRotation()).Yaw;
-	FTurnInPlaceAsset TargetTurnAsset;
-	if (FMath::Abs(TurnAngle) < Turn180Threshold)
-	{
-		if (TurnAngle < 0.0f)
-		{
-			switch (Stance)
-			{
-			case EStance::Standing:
-				TargetTurnAsset = NTurnIPL90;
-			case EStance::Crouching:
-				TargetTurnAsset = CLFTurnIPL90; 
-			}
-		}
-		else
-		{
-			switch (Stance)
-			{
-			case EStance::Standing:
-				TargetTurnAsset = NTurnIPR90;
-			case EStance::Crouching:
-				TargetTurnAsset = CLFTurnIPR90; 
-			}
-		}
-	}
-	else
+	using FTurnAssetMember = FTurnInPlaceAsset UCharacterLocomotionConfig::*;
+	// [Stance][90/180][左/右]
+	static constexpr FTurnAssetMember TurnInPlaceAssets[LocomotionStateTables::NumStances][2][2] =
 	{
-		if (TurnAngle < 0.0f)
 		{
-			switch (Stance)
-			{
-			case EStance::Standing:
-				TargetTurnAsset = NTurnIPL180;
-			case EStance::Crouching:
-				TargetTurnAsset = CLFTurnIPL180; 
-			}
-		}
-		else
+			{ &UCharacterLocomotionConfig::NTurnIPL90, &UCharacterLocomotionConfig::NTurnIPR90 },
+			{ &UCharacterLocomotionConfig::NTurnIPL180, &UCharacterLocomotionConfig::NTurnIPR180 },
+		},
 		{
-			switch (Stance)
-			{
-			case EStance::Standing:
-				TargetTurnAsset = NTurnIPR180;
-			case EStance::Crouching:
-				TargetTurnAsset = CLFTurnIPR180; 
-			}
-		}
-	}
+			{ &UCharacterLocomotionConfig::CLFTurnIPL90, &UCharacterLocomotionConfig::CLFTurnIPR90 },
+			{ &UCharacterLocomotionConfig::CLFTurnIPL180, &UCharacterLocomotionConfig::CLFTurnIPR180 },
+		},
+	};
+	const int32 AngleIndex = FMath::Abs(TurnAngle) < LocomotionConfig->Turn180Threshold ? 0 : 1;
+	const int32 SideIndex = TurnAngle < 0.0f ? 0 : 1;
+	const FTurnInPlaceAsset& TargetTurnAsset = LocomotionConfig.Get()->*TurnInPlaceAssets[LocomotionStateTables::ToIndex(Stance)][AngleIndex][SideIndex];
 	if (OverrideCurrent || !IsPlayingSlotAnimation(TargetTurnAsset.Animation, TargetTurnAsset.SlotName))
 	{
-		PlaySlotAnimationAsDynamicMontage(TargetTurnAsset.Animation, TargetTurnAsset.SlotName, 0.2f, 0.2,
-			TargetTurnAsset.PlayRate * PlayRateScale, 1, 0.0f, StartTime);
+		PlayCachedSlotAnimation(TargetTurnAsset.Animation, TargetTurnAsset.SlotName, 0.2f, 0.2f,
+			TargetTurnAsset.PlayRate * PlayRateScale, StartTime);
 	}
 	if (TargetTurnAsset.ScaleTurnAngle)
 	{
@@ -775,6 +928,23 @@ void UAnimInstanceBase::TurnInPlace(FRotator TargetRotation, float PlayRateScale
 	}
 }
 
+UAnimMontage* UAnimInstanceBase::PlayCachedSlotAnimation(UAnimSequenceBase* Asset, FName SlotName, float BlendInTime, float BlendOutTime, float PlayRate, float StartTime)
+{
+	// 缓存在世界内所有动画实例间共用，复用前检查动画的骨架与当前骨架兼容；
+	// 不兼容时交给PlaySlotAnimationAsDynamicMontage，由它输出警告并拒绝播放
+	const bool bCompatibleSkeleton = Asset && Asset->GetSkeleton() && CurrentSkeleton && CurrentSkeleton->IsCompatible(Asset->GetSkeleton());
+	UDynamicMontageCache* MontageCache = GetWorld() ? GetWorld()->GetSubsystem<UDynamicMontageCache>() : nullptr;
+	UAnimMontage* Montage = MontageCache && bCompatibleSkeleton ? MontageCache->FindOrCreate(Asset, SlotName, BlendInTime, BlendOutTime, 1, 0.0f) : nullptr;
+	if (Montage == nullptr)
+	{
+		return PlaySlotAnimationAsDynamicMontage(Asset, SlotName, BlendInTime, BlendOutTime, PlayRate, 1, 0.0f, StartTime);
+	}
+
+	// 同一个蒙太奇可以同时有多个实例，重复播放时旧实例正常混出
+	const float PlayLength = Montage_Play(Montage, PlayRate, EMontagePlayReturnType::MontageLength, StartTime);
+	return PlayLength > 0.0f ? Montage : nullptr;
+}
+
 void UAnimInstanceBase::SetFootLockOffsets(FVector& LocalLocation, FRotator& LocalRotation)
 {
 	UCharacterMovementComponent* MovementComponent = Cast<UCharacterMovementComponent>(CharacterBase->GetMovementComponent());
@@ -791,33 +961,10 @@ void UAnimInstanceBase::SetFootLockOffsets(FVector& LocalLocation, FRotator& Loc
 
 EMovementDirection UAnimInstanceBase::CalculateQuadrant(EMovementDirection Current, float FRThreshold, float FLThreshold, float BRThreshold, float BLThreshold, float Buffer, float Angle)
 {
-	bool IncreaseBuffer1 = Current != EMovementDirection::Forward || Current != EMovementDirection::Backward;
-	bool IsInRange1 = AngleInRange(Angle, FLThreshold, FRThreshold, Buffer, IncreaseBuffer1);
-	if (IsInRange1)
-	{
-		return EMovementDirection::Forward;
-	}
-
-	bool IncreaseBuffer2 = Current != EMovementDirection::Right || Current != EMovementDirection::Left;
-	bool IsInRange2 = AngleInRange(Angle, FRThreshold, BRThreshold, Buffer, IncreaseBuffer2);
-	if (IsInRange2)
-	{
-		return EMovementDirection::Right;
-	}
-
-	bool IncreaseBuffer3 = Current != EMovementDirection::Right || Current != EMovementDirection::Left;
-	bool IsInRange3 = AngleInRange(Angle, BLThreshold, FLThreshold, Buffer, IncreaseBuffer3);
-	if (IsInRange3)
-	{
-		return EMovementDirection::Left;
-	}
-
-	return EMovementDirection::Backward;
+	return LocomotionMath::Quadrant(Current, FRThreshold, FLThreshold, BRThreshold, BLThreshold, Buffer, Angle);
 }
 
 bool UAnimInstanceBase::AngleInRange(float Angle, float MinAngle, float MaxAngle, float Buffer, bool IncreaseBuffer)
 {
-	return IncreaseBuffer ?
-				UKismetMathLibrary::InRange_FloatFloat(Angle, MinAngle - Buffer, MaxAngle + Buffer) :
-				UKismetMathLibrary::InRange_FloatFloat(Angle, MinAngle + Buffer, MaxAngle - Buffer);
+	return LocomotionMath::AngleInRange(Angle, MinAngle, MaxAngle, Buffer, IncreaseBuffer);
 }
\ No newline at end of file
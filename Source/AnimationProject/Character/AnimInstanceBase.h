@@ -7,16 +7,23 @@
 #include "AnimationProject/Common/CommonInterfaces.h"
 #include "AnimInstanceBase.generated.h"
 
+struct FAnimLocomotionSnapshot;
+class UCharacterLocomotionConfig;
+class ULocomotionAnimBatch;
+
 UCLASS(Config = Game)
 class UAnimInstanceBase : public UAnimInstance, public IAnimationInterface
 {
 	GENERATED_BODY()
 
+	friend class ULocomotionAnimBatch;
+
 public:
 	UAnimInstanceBase(const FObjectInitializer& ObjectInitializer);
 
 protected:
 	virtual void NativeInitializeAnimation() override;
+	virtual void NativeUninitializeAnimation() override;
 	virtual void NativeUpdateAnimation(float DeltaSeconds) override;
 
 public:
@@ -24,6 +31,9 @@ public:
 	virtual void BPISetGroundEntryState(EGroundedEntryState NewGroundEntryState) override;
 	virtual void BPISetOverlayOcerrideState(uint8 NewOverlayOverrideState) override;
 
+	void TakeLocomotionSnapshot(FAnimLocomotionSnapshot& OutSnapshot) const;
+	void ApplyLocomotionSnapshot(const FAnimLocomotionSnapshot& Snapshot);
+
 protected:
 	// todo event
 	void PlayTransition(FDynamicMontageParams Parameters);
@@ -55,9 +65,15 @@ private:
 	void UpdateCharacterInfo();
 	void UpdateAimingValues();
 	void UpdateLayerValues();
+	// 以下按LocomotionFeatures.h中的特性策略实例化，初始化时按LocomotionConfig->FeatureSet选择
+	template <typename Features>
+	void UpdateWithFeatures();
+	template <typename Features>
 	void UpdateFootIK();
+	template <typename Features>
 	void UpdateInAirValues();
 	void UpdateRagdollValues();
+	template <typename Features>
 	void UpdateMovementValues();
 	void UpdateRotationValues();
 	bool ShouldMoveCheck();
@@ -81,12 +97,15 @@ private:
 	FVelocityBlend CalculateVelocityBlend();
 	float CalculateDiagonalScaleAmount();
 	FVector CalculateRelativeAccelerationAmount();
+	void VerifyBatchedMovementValues();
 	float CalculateWalkRunBlend();
 	float CalculateStrideBlend();
 	float CalculateStandingPlayRate();
 	float CalculateCrouchingPlayRate();
 	EMovementDirection CalculateMovementDirection();
 	void TurnInPlace(FRotator TargetRotation, float PlayRateScale, float StartTime, bool OverrideCurrent);
+	// 与PlaySlotAnimationAsDynamicMontage相同，但蒙太奇从UDynamicMontageCache取，不会每次新建
+	UAnimMontage* PlayCachedSlotAnimation(UAnimSequenceBase* Asset, FName SlotName, float BlendInTime, float BlendOutTime, float PlayRate, float StartTime);
 	void SetFootLockOffsets(FVector& LocalLocation, FRotator& LocalRotation);
 	EMovementDirection CalculateQuadrant(EMovementDirection Current, float FRThreshold, float FLThreshold, float BRThreshold, float BLThreshold, float Buffer, float Angle);
 	bool AngleInRange(float Angle, float MinAngle, float MaxAngle, float Buffer, bool IncreaseBuffer);
@@ -95,6 +114,22 @@ private:
 	float DeltaTimeX = 0.0f;
 	// weakptr
 	ACharacterBase* CharacterBase;
+	// 阈值、曲线、转身动画等只读配置，来自角色的LocomotionConfig，所有实例共享
+	UPROPERTY(Transient)
+	TObjectPtr<const UCharacterLocomotionConfig> LocomotionConfig;
+	// 脚部IK和落地预测每帧复用，忽略角色自身
+	FCollisionQueryParams TraceQueryParams;
+	void (UAnimInstanceBase::*UpdateFunction)() = nullptr;
+	// ULocomotionAnimBatch在动画更新前批量算好的地面移动值，帧号和DeltaTime都对上时代替标量计算
+	struct FBatchedMovementValues
+	{
+		FVelocityBlend VelocityBlend;
+		FVector RelativeAccelerationAmount = FVector::ZeroVector;
+		FLeanAmount LeanAmount;
+		uint64 FrameCounter = 0;
+		float DeltaSeconds = 0.0f;
+	};
+	FBatchedMovementValues BatchedMovementValues;
 	EMovementState MovementState = EMovementState::Grounded;
 	bool bShouldMove = false;
 	bool bRotateL = false;
@@ -103,12 +138,9 @@ private:
 	float ElapsedDelayTime = 0.0f;
 	EHipsDirection TrackedHipsDirection = EHipsDirection::F;
 	float Speed = 0.0f;
-	float TriggerRivotSpeedLimit = 0.0f;
 	bool bPivot = false;
 	bool bJumped = false;
 	float JumpPlayRate = 0.0f;
-	float MinPlayRate = 0.0f;
-	float MaxPlayRate = 0.0f;
 	EGroundedEntryState GroundEntryState = EGroundedEntryState::None;
 	uint8 OverlayOverrideState = 0;
 	
@@ -120,9 +152,6 @@ private:
 	float MovementInputAmount = 0.0f;
 	FRotator AimingRotation = FRotator::ZeroRotator;
 	float AimYawRate = 0.0f;
-	float AimYawRateMinRange = 0.0f;
-	float AimYawRateMaxRange = 0.0f;
-	float AimYawRateLimit = 0.0f;
 	
 	TEnumAsByte<EMovementMode> PawnMovementMode = EMovementMode::MOVE_Walking;
 	EMovementState PrevMovementState = EMovementState::Grounded;
@@ -136,13 +165,11 @@ private:
 	EOverlayState OverlayState = EOverlayState::Pistol1H;
 
 	FRotator SmoothedAimingRotation = FRotator::ZeroRotator;
-	float SmoothedAimingRotationInterpSpeed = 0.0f;
 	FVector2d AimingAngle = FVector2d::ZeroVector;
 	FVector2d SmoothedAimingAngle = FVector2d::ZeroVector;
 	float AimSweepTime = 0.0f;
 	FRotator SpineRotation = FRotator::ZeroRotator;
 	float InputYawOffsetTime = 0.0f;
-	float InputYawOffsetInterpSpeed = 8.0f;
 	float LeftYawTime = 0.0f;
 	float RightYawTime = 0.0f;
 	float ForwardYawTime = 0.0f;
@@ -179,62 +206,27 @@ private:
 	float FallSpeed = 0.0f;
 	float LandPrediction = 0.0f;
 	FLeanAmount LeanAmount;
-	float InAirLeanInterpSpeed = 0.0f;
 
 	float FlailRate = 0.0f;
 
 	FVelocityBlend VelocityBlend;
-	float VelocityBlendInterpSpeed = 0.0f;
 	float DiagonalScaleAmount = 0.0f;
 	FVector RelativeAccelerationAmount = FVector::ZeroVector;
-	float GroundedLeanInterpSpeed = 0.0f;
 	float WalkRunBlend = 0.0f;
 	float StrideBlend = 0.0f;
 	float StandingPlayRate = 0.0f;
 	float CrouchingPlayRate = 0.0f;
 
 	EMovementDirection MovementDirection = EMovementDirection::Forward;
-	UCurveVector* YawOffsetFB = nullptr;
-	UCurveVector* YawOffsetLR = nullptr;
 	float FYaw = 0.0f;
 	float BYaw = 0.0f;
 	float LYaw = 0.0f;
 	float RYaw = 0.0f;
 
-	float RotateMinThreshold = 0.0f;
-	float RotateMaxThreshold = 0.0f;
-	float TurnCheckMinAngle = 0.0f;
-	float MinAngleDelay = 0.0f;
-	float MaxAngleDelay = 0.0f;
-
 	float FootLockCurveValue = 0.0f;
-	float IKTraceDistanceAboveFoot = 0.0f;
-	float IKTraceDistanceBelowFoot = 0.0f;
-	float FootHeight = 0.0f;
 
 	float PelvisAlpha = 0.0f;
 	FVector PelvisOffset = FVector::ZeroVector;
 
-	UCurveFloat* LeanInAirCurve = nullptr;
-	UCurveFloat* DiagonalScaleAmountCurve = nullptr;
-	UCurveFloat* StrideBlendNWalk = nullptr;
-	UCurveFloat* StrideBlendNRun = nullptr;
-	UCurveFloat* StrideBlendCWalk = nullptr;
-	UCurveFloat* LandPredictionCurve = nullptr;
-
-	float AnimatedWalkSpeed = 0.0f;
-	float AnimatedRunSpeed = 0.0f;
-	float AnimatedSprintSpeed = 0.0f;
-	float AnimatedCrouchSpeed = 0.0f;
-
-	float Turn180Threshold = 0.0f;
-	FTurnInPlaceAsset NTurnIPL90;
-	FTurnInPlaceAsset CLFTurnIPL90;
-	FTurnInPlaceAsset NTurnIPR90;
-	FTurnInPlaceAsset CLFTurnIPR90;
-	FTurnInPlaceAsset NTurnIPL180;
-	FTurnInPlaceAsset CLFTurnIPL180;
-	FTurnInPlaceAsset NTurnIPR180;
-	FTurnInPlaceAsset CLFTurnIPR180;
 	float RotationScale = 0.0f;
 };
@@ -0,0 +1,29 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "CharacterArchetype.h"
+#include "CharacterBase.h"
+
+static TAutoConsoleVariable<bool> CVarCharacterArchetypePreloadDebugBundle(
+	TEXT("CharacterArchetype.PreloadDebugBundle"),
+	!UE_BUILD_SHIPPING,
+	TEXT("Also preload the Debug bundle of character archetypes during map load"));
+
+const FPrimaryAssetType UCharacterArchetype::PrimaryAssetType = FName("CharacterArchetype");
+const FName UCharacterArchetype::CoreBundle = FName("Core");
+const FName UCharacterArchetype::OverlaysBundle = FName("Overlays");
+const FName UCharacterArchetype::DebugBundle = FName("Debug");
+
+FPrimaryAssetId UCharacterArchetype::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(PrimaryAssetType, GetFName());
+}
+
+TArray<FName> UCharacterArchetype::GetPreloadBundles()
+{
+	TArray<FName> Bundles = { CoreBundle, OverlaysBundle };
+	if (CVarCharacterArchetypePreloadDebugBundle.GetValueOnGameThread())
+	{
+		Bundles.Add(DebugBundle);
+	}
+	return Bundles;
+}
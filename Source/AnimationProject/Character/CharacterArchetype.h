@@ -0,0 +1,40 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "CharacterArchetype.generated.h"
+
+class ACharacterBase;
+
+/**
+ * 一类角色需要的全部资源，按Bundle分组异步加载。
+ * 角色类本身放在Core中，MovementModelDT、蒙太奇表、曲线、材质等硬引用随角色类一起异步加载；
+ * 角色上的软引用(手持物品网格、起身和翻滚蒙太奇等)需要手动放进Overlays，调试用的资源放进Debug。
+ */
+UCLASS(BlueprintType)
+class UCharacterArchetype : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	static const FPrimaryAssetType PrimaryAssetType;
+	static const FName CoreBundle;
+	static const FName OverlaysBundle;
+	static const FName DebugBundle;
+
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+	/** 地图加载时需要预加载的Bundle，Debug只在CharacterArchetype.PreloadDebugBundle打开时加载 */
+	static TArray<FName> GetPreloadBundles();
+
+	UPROPERTY(EditDefaultsOnly, Category = Archetype, meta = (AssetBundles = "Core"))
+	TSoftClassPtr<ACharacterBase> CharacterClass;
+
+	UPROPERTY(EditDefaultsOnly, Category = Archetype, meta = (AssetBundles = "Overlays"))
+	TArray<TSoftObjectPtr<UObject>> OverlayAssets;
+
+	UPROPERTY(EditDefaultsOnly, Category = Archetype, meta = (AssetBundles = "Debug"))
+	TArray<TSoftObjectPtr<UObject>> DebugAssets;
+};
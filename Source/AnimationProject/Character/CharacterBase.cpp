@@ -5,10 +5,12 @@
 #include "AnimInstanceBase.h"
 #include "Engine/LocalPlayer.h"
 #include "Camera/CameraComponent.h"
+#include "Camera/PlayerCameraManager.h"
 #include "Components/CapsuleComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "GameFramework/Controller.h"
+#include "GameFramework/InputSettings.h"
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "InputActionValue.h"
@@ -16,6 +18,20 @@
 #include "XXCharacterMovementComponent.h"
 #include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "KismetTraceUtils.h"
+#include "EngineUtils.h"
+#include "Misc/Paths.h"
+#include "PhysicsAnimationAsset.h"
+#include "PhysicsAnimationProfileComponent.h"
+#include "AnimationProject/Character/CharacterLocomotionConfig.h"
+#include "AnimationProject/Character/HeldObjectPool.h"
+#include "AnimationProject/Locomotion/LocomotionFeatures.h"
+#include "AnimationProject/Locomotion/LocomotionMath.h"
+#include "AnimationProject/Locomotion/LocomotionMontageResidency.h"
+#include "AnimationProject/Locomotion/LocomotionProfiler.h"
+#include "AnimationProject/Locomotion/LocomotionSnapshot.h"
+#include "AnimationProject/Locomotion/LocomotionStateTables.h"
+#include "AnimationProject/Locomotion/LocomotionStreamingSourceComponent.h"
 #include "AnimationProject/Physics/CollisionChannels.h"
 #include "AnimationProject/Player/PlayerControllerBase.h"
 
@@ -23,6 +39,46 @@ DEFINE_LOG_CATEGORY(LogTemplateCharacter);
 
 const FName MovementModelNormalName = "Normal";
 
+static TAutoConsoleVariable<float> CVarRagdollSettleLinearSpeed(
+	TEXT("Ragdoll.Settle.LinearSpeed"),
+	5.0f,
+	TEXT("Root linear speed (cm/s) below which a grounded ragdoll counts as resting"));
+
+static TAutoConsoleVariable<float> CVarRagdollSettleAngularSpeed(
+	TEXT("Ragdoll.Settle.AngularSpeed"),
+	10.0f,
+	TEXT("Pelvis angular speed (deg/s) below which a grounded ragdoll counts as resting"));
+
+static TAutoConsoleVariable<float> CVarRagdollSettleTime(
+	TEXT("Ragdoll.Settle.Time"),
+	0.5f,
+	TEXT("Seconds a ragdoll must stay at rest before it is frozen, 0 disables settling"));
+
+static TAutoConsoleVariable<float> CVarLocomotionFixedStepHz(
+	TEXT("Locomotion.FixedStepHz"),
+	0.0f,
+	TEXT("Run the locomotion simulation of every ACharacterBase at a fixed rate (e.g. 30 or 60), 0 uses each character's LocomotionFixedStepHz"));
+
+static FAutoConsoleCommandWithWorldAndArgs LocomotionRecordCommand(
+	TEXT("Locomotion.Record"),
+	TEXT("Locomotion.Record Start|Stop: record every ACharacterBase in the world to Saved/Locomotion"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const bool bStart = Args.Num() == 0 || Args[0].Equals(TEXT("Start"), ESearchCase::IgnoreCase);
+		const FString Timestamp = FDateTime::Now().ToString();
+		for (TActorIterator<ACharacterBase> It(World); It; ++It)
+		{
+			if (bStart)
+			{
+				It->StartLocomotionRecording(FPaths::ProjectSavedDir() / TEXT("Locomotion") / FString::Printf(TEXT("%s_%s.locrec"), *It->GetName(), *Timestamp));
+			}
+			else
+			{
+				It->StopLocomotionRecording();
+			}
+		}
+	}));
+
 //////////////////////////////////////////////////////////////////////////
 // ACharacterBase
 
@@ -64,21 +120,35 @@ ACharacterBase::ACharacterBase()
 	// are set in the derived blueprint asset named ThirdPersonCharacter (to avoid direct content references in C++)
 
 	XXCharacterMovement = CastChecked<UXXCharacterMovementComponent>(GetCharacterMovement());
+
+	PhysicalAnimationProfiles = CreateDefaultSubobject<UPhysicsAnimationProfileComponent>(TEXT("PhysicalAnimationProfiles"));
+
+	StreamingSource = CreateDefaultSubobject<ULocomotionStreamingSourceComponent>(TEXT("StreamingSource"));
 }
 
 void ACharacterBase::BeginPlay()
 {
+	// 组件的BeginPlay在Super::BeginPlay中调用，需要先指定网格，否则会找到BodyMesh
+	if (IsValid(PhysicalAnimationProfiles))
+	{
+		PhysicalAnimationProfiles->SetSkeletalMeshComponent(GetMesh());
+	}
+
+	if (UHeldObjectPool* HeldObjectPool = GetWorld()->GetSubsystem<UHeldObjectPool>())
+	{
+		HeldObjectPool->Preload(HeldObjects);
+	}
+
+	TickFunction = VisitLocomotionFeatures(GetLocomotionConfig().FeatureSet, [](auto Features)
+	{
+		return &ACharacterBase::TickWithFeatures<decltype(Features)>;
+	});
+
 	// Call the base class  
 	Super::BeginPlay();
 
 	//Add Input Mapping Context
-	if (APlayerController* PlayerController = Cast<APlayerController>(Controller))
-	{
-		if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(PlayerController->GetLocalPlayer()))
-		{
-			Subsystem->AddMappingContext(DefaultMappingContext, 0);
-		}
-	}
+	AddDefaultMappingContext();
 	
 	if (IsValid(GetMesh()))
 	{
@@ -112,9 +182,57 @@ void ACharacterBase::BeginPlay()
 	}
 
 	// Set default rotation values.
-	TargetRotation = GetActorRotation();
-	LastVelocityRotation = GetActorRotation();
-	LastMovementInputRotation = GetActorRotation();
+	Locomotion.TargetRotation = GetActorRotation();
+	Locomotion.LastVelocityRotation = GetActorRotation();
+	Locomotion.LastMovementInputRotation = GetActorRotation();
+
+	TraceQueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(LocomotionTrace), false, this);
+
+	TakeLocomotionSnapshot(SpawnLocomotionSnapshot);
+}
+
+void ACharacterBase::NotifyControllerChanged()
+{
+	Super::NotifyControllerChanged();
+
+	// 从角色池取出的角色在BeginPlay之后才被控制
+	AddDefaultMappingContext();
+	if (HasActorBegunPlay())
+	{
+		UpdateResidentMontages();
+	}
+}
+
+void ACharacterBase::AddDefaultMappingContext()
+{
+	if (APlayerController* PlayerController = Cast<APlayerController>(Controller))
+	{
+		if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(PlayerController->GetLocalPlayer()))
+		{
+			Subsystem->AddMappingContext(DefaultMappingContext, 0);
+		}
+	}
+}
+
+void ACharacterBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	StopLocomotionRecording();
+	EndHitReaction();
+	ReleaseHeldObject();
+	if (ULocomotionMontageResidency* MontageResidency = GetWorld()->GetSubsystem<ULocomotionMontageResidency>())
+	{
+		MontageResidency->ReleaseResidentMontages(this);
+	}
+	if (Locomotion.MovementState == EMovementState::Ragdoll)
+	{
+		EndRagdollControl();
+		if (URagdollBudgetSubsystem* RagdollBudget = GetWorld()->GetSubsystem<URagdollBudgetSubsystem>())
+		{
+			RagdollBudget->UnregisterRagdoll(this);
+		}
+	}
+	
+	Super::EndPlay(EndPlayReason);
 }
 
 void ACharacterBase::OnConstruction(const FTransform& Transform)
@@ -131,34 +249,155 @@ void ACharacterBase::OnConstruction(const FTransform& Transform)
 
 void ACharacterBase::Tick(float DeltaSeconds)
 {
+	LOCOMOTION_PROFILE_SCOPE(CharacterTick);
 	Super::Tick(DeltaSeconds);
+
+	(this->*TickFunction)(DeltaSeconds);
+}
+
+template <typename Features>
+void ACharacterBase::TickWithFeatures(float DeltaSeconds)
+{
+	const float FixedStepHz = GetLocomotionFixedStepHz();
+	if (FixedStepHz > 0.0f)
+	{
+		TickLocomotionFixedStep<Features>(DeltaSeconds, 1.0f / FixedStepHz);
+	}
+	else
+	{
+		LocomotionStepAlpha = 1.0f;
+		TickLocomotion<Features>(DeltaSeconds, DeltaSeconds, DeltaSeconds);
+	}
+
+	UpdateHitReaction(DeltaSeconds);
+
+	if constexpr (Features::bDebugShapes)
+	{
+		DrawDebugShapes();
+	}
+	if constexpr (Features::bLayeringColors)
+	{
+		UpdateColoringSystem();
+	}
+	if (bHeldObjectPending)
+	{
+		UpdateHeldObject();
+	}
+	UpdateHeldObjectAnimations();
+}
+
+float ACharacterBase::GetLocomotionFixedStepHz() const
+{
+	const float OverrideHz = CVarLocomotionFixedStepHz.GetValueOnGameThread();
+	return OverrideHz > 0.0f ? OverrideHz : LocomotionFixedStepHz;
+}
+
+template <typename Features>
+void ACharacterBase::TickLocomotionFixedStep(float DeltaSeconds, float StepSeconds)
+{
+	// 朝向被其他逻辑修改过(瞬移、移动组件、快照恢复)，以当前朝向为准重新开始插值
+	if (!GetActorQuat().Equals(InterpolatedRotation))
+	{
+		PreviousStepRotation = GetActorQuat();
+		CurrentStepRotation = GetActorQuat();
+	}
+
+	// 卡顿时最多补MaxLocomotionStepsPerFrame步，多出的时间直接丢弃
+	LocomotionStepAccumulator = FMath::Min(LocomotionStepAccumulator + DeltaSeconds, StepSeconds * MaxLocomotionStepsPerFrame);
+	LocomotionRateSeconds += DeltaSeconds;
+	const int32 NumSteps = FMath::FloorToInt32(LocomotionStepAccumulator / StepSeconds);
+	if (NumSteps > 0)
+	{
+		// 模拟从上一步的结果继续，插值出的朝向只用于表现
+		SetActorRotation(CurrentStepRotation);
+		for (int32 Step = 0; Step < NumSteps; ++Step)
+		{
+			PreviousStepRotation = GetActorQuat();
+			PreviousStepAcceleration = Locomotion.Acceleration;
+			PreviousStepSpeed = Locomotion.Speed;
+			PreviousStepMovementInputAmount = Locomotion.MovementInputAmount;
+			PreviousStepAimYawRate = Locomotion.AimYawRate;
+			// 速度和控制朝向在两次模拟之间只变化了一次，第一步按实际经过的时间算出加速度和瞄准转速，
+			// 补的几步沿用，否则第一步会把整段变化算进一步里，后面几步又都是0
+			TickLocomotion<Features>(StepSeconds, Step == 0 ? LocomotionRateSeconds : 0.0f, Step == NumSteps - 1 ? NumSteps * StepSeconds : 0.0f);
+		}
+		LocomotionRateSeconds = 0.0f;
+		CurrentStepRotation = GetActorQuat();
+		LocomotionStepAccumulator -= NumSteps * StepSeconds;
+	}
+
+	// 专用服务器没有表现，保持模拟结果即可
+	if (GetNetMode() == NM_DedicatedServer)
+	{
+		LocomotionStepAlpha = 1.0f;
+		InterpolatedRotation = CurrentStepRotation;
+		return;
+	}
+
+	LocomotionStepAlpha = LocomotionStepAccumulator / StepSeconds;
+	InterpolatedRotation = FQuat::Slerp(PreviousStepRotation, CurrentStepRotation, LocomotionStepAlpha);
+	SetActorRotation(InterpolatedRotation);
+	InterpolatedRotation = GetActorQuat();
+}
+
+template <typename Features>
+void ACharacterBase::TickLocomotion(float StepSeconds, float RateSeconds, float FrameSeconds)
+{
+	const bool bFinalStep = FrameSeconds > 0.0f;
+	LocomotionDeltaSeconds = StepSeconds;
 	
-	SetEssentialValues();
-	switch (MovementState)
+	{
+		LOCOMOTION_PROFILE_SCOPE(EssentialValues);
+		SetEssentialValues(RateSeconds);
+	}
+	switch (Locomotion.MovementState)
 	{
 	case EMovementState::Grounded:
-		UpdateCharacterMovement();
-		UpdateGroundedRotation();
+		{
+			LOCOMOTION_PROFILE_SCOPE(GroundedUpdate);
+			UpdateCharacterMovement();
+			UpdateGroundedRotation();
+		}
 		break;
 	case EMovementState::InAir:
-		UpdateInAirRotation();
-		if (HasMovementInput)
 		{
-			MantleCheck(FallingTraceSettings, EDrawDebugTrace::Type::ForOneFrame);
+			LOCOMOTION_PROFILE_SCOPE(InAirUpdate);
+			UpdateInAirRotation();
+			if constexpr (Features::bInAirMantle)
+			{
+				if (bFinalStep && Locomotion.HasMovementInput)
+				{
+					MantleCheck(FallingTraceSettings, EDrawDebugTrace::Type::ForOneFrame);
+				}
+			}
 		}
 		break;
 	case EMovementState::Ragdoll:
-		RagdollUpdate();
+		if (bFinalStep)
+		{
+			LOCOMOTION_PROFILE_SCOPE(Ragdoll);
+			RagdollUpdate();
+		}
 		break;
 	default:
 		break;
 	}
 	
-	CacheValues();
-	DrawDebugShapes();
-
-	UpdateColoringSystem();
-	UpdateHeldObjectAnimations();
+	if (bFinalStep)
+	{
+		if (LocomotionRecorder.IsValid())
+		{
+			RecordLocomotionFrame(FrameSeconds);
+		}
+		FrameTraceFlags = ELocomotionTraceFlags::None;
+		RecordedMoveInput = FVector2D::ZeroVector;
+		RecordedLookInput = FVector2D::ZeroVector;
+	}
+	
+	{
+		LOCOMOTION_PROFILE_SCOPE(CacheValues);
+		CacheValues();
+	}
 }
 
 void ACharacterBase::UpdateColoringSystem()
@@ -203,95 +442,76 @@ void ACharacterBase::UpdateHeldObjectAnimations()
 
 void ACharacterBase::UpdateHeldObject()
 {
-	switch (OverlayState)
+	const FHeldObjectDefinition* Definition = HeldObjects ? HeldObjects->Items.Find(OverlayState) : nullptr;
+	if (HeldObject != nullptr && (Definition == nullptr || HeldObjectItem != OverlayState))
 	{
-	case EOverlayState::Default:
-	case EOverlayState::Masculine:
-	case EOverlayState::Feminine:
-	case EOverlayState::Injured:
-	case EOverlayState::HandsTied:
-		ClearHeldObject();
-		break;
-	case EOverlayState::Rifle:
-		AttachToHand(nullptr, nullptr, nullptr, false, FVector::ZeroVector);
-		break;
-	case EOverlayState::Pistol1H:
-		AttachToHand(nullptr, nullptr, nullptr, false, FVector::ZeroVector);
-		break;
-	case EOverlayState::Pistol2H:
-		AttachToHand(nullptr, nullptr, nullptr, false, FVector::ZeroVector);
-		break;
-	case EOverlayState::Bow:
-		AttachToHand(nullptr, nullptr, nullptr, true, FVector::ZeroVector);
-		break;
-	case EOverlayState::Torch:
-		AttachToHand(nullptr, nullptr, nullptr, true, FVector::ZeroVector);
-		break;
-	case EOverlayState::Binoculars:
-		AttachToHand(nullptr, nullptr, nullptr, true, FVector::ZeroVector);
-		break;
-	case EOverlayState::Box:
-		AttachToHand(nullptr, nullptr, nullptr, true, FVector::ZeroVector);
-		break;
-	case EOverlayState::Barrel:
-		AttachToHand(nullptr, nullptr, nullptr, true, FVector::ZeroVector);
-		break;
+		ReleaseHeldObject();
+	}
+
+	bHeldObjectPending = false;
+	if (Definition == nullptr)
+	{
+		return;
+	}
+
+	if (HeldObject == nullptr)
+	{
+		UHeldObjectPool* HeldObjectPool = GetWorld()->GetSubsystem<UHeldObjectPool>();
+		const FName SocketName = Definition->bLeftHand ? FName("VB RHS_ik_hand_Gun") : FName("VB LHS_ik_hand_Gun");
+		HeldObject = HeldObjectPool ? HeldObjectPool->Acquire(HeldObjects, OverlayState, GetMesh(), SocketName) : nullptr;
+		HeldObjectItem = OverlayState;
+		// 资源还在加载时在Tick中重试
+		bHeldObjectPending = HeldObjectPool != nullptr && HeldObject == nullptr;
+	}
+	else if (bHeldObjectHidden)
+	{
+		HeldObject->SetVisibility(true);
 	}
+	bHeldObjectHidden = false;
 }
 
 void ACharacterBase::ClearHeldObject()
 {
-	if (IsValid(StaticMeshComponent) && IsValid(SkeletalMeshComponent))
+	// 攀爬和布娃娃期间只隐藏，结束后UpdateHeldObject重新显示同一个组件
+	if (HeldObject != nullptr && !bHeldObjectHidden)
 	{
-		StaticMeshComponent->SetStaticMesh(nullptr);
-		SkeletalMeshComponent->SetSkeletalMesh(nullptr);
-		SkeletalMeshComponent->SetAnimInstanceClass(nullptr);
+		HeldObject->SetVisibility(false);
+		bHeldObjectHidden = true;
 	}
+	bHeldObjectPending = false;
 }
 
-void ACharacterBase::AttachToHand(UStaticMesh* StaticMesh, USkeletalMesh* SkeletalMesh, UClass* NewAnimClass, bool LeftHand, FVector Offset)
+void ACharacterBase::ReleaseHeldObject()
 {
-	ClearHeldObject();
-	
-	if (IsValid(StaticMesh))
-	{
-		StaticMeshComponent->SetStaticMesh(StaticMesh);
-	}
-	
-	if (IsValid(SkeletalMesh))
-	{
-		SkeletalMeshComponent->SetSkeletalMesh(SkeletalMesh);
-	}
-	
-	if (IsValid(NewAnimClass))
+	if (HeldObject == nullptr)
 	{
-		SkeletalMeshComponent->SetAnimInstanceClass(NewAnimClass);
+		return;
 	}
 
-	if (IsValid(HeldObjectRoot))
+	if (UHeldObjectPool* HeldObjectPool = GetWorld()->GetSubsystem<UHeldObjectPool>())
 	{
-		FName SocketName = LeftHand ? FName("VB RHS_ik_hand_Gun") : FName("VB LHS_ik_hand_Gun");
-		HeldObjectRoot->K2_AttachToComponent(GetMesh(), SocketName, EAttachmentRule::SnapToTarget,
-			EAttachmentRule::SnapToTarget, EAttachmentRule::SnapToTarget, true);
-		HeldObjectRoot->SetRelativeLocation(Offset);
+		HeldObjectPool->Release(HeldObjects, HeldObjectItem, HeldObject);
 	}
+	HeldObject = nullptr;
+	bHeldObjectHidden = false;
 }
 
 void ACharacterBase::UpdateLayeringColors()
 {
-	auto SetParameter1 = [this](UMaterialInstanceDynamic* Part, FName AdditiveCurve, FName BaseCurve)
+	const UCharacterLocomotionConfig& Config = GetLocomotionConfig();
+	auto SetParameter1 = [this, &Config](UMaterialInstanceDynamic* Part, FName AdditiveCurve, FName BaseCurve)
 	{
 		FLinearColor AdditiveColor = UKismetMathLibrary::LinearColorLerp(
-			OverlayLayerColor, AdditiveAmountColor, GetAnimCurveValue(AdditiveCurve));
+			Config.OverlayLayerColor, Config.AdditiveAmountColor, GetAnimCurveValue(AdditiveCurve));
 		FLinearColor BaseColor = UKismetMathLibrary::LinearColorLerp(
-			BaseLayerColor, AdditiveColor, GetAnimCurveValue(BaseCurve));
+			Config.BaseLayerColor, AdditiveColor, GetAnimCurveValue(BaseCurve));
 		Part->SetVectorParameterValue(FName("BaseColor"), BaseColor);
 	};
 
-	auto SetParameter2 = [this](UMaterialInstanceDynamic* Part, FName Curve)
+	auto SetParameter2 = [this, &Config](UMaterialInstanceDynamic* Part, FName Curve)
 	{
 		FLinearColor Color = UKismetMathLibrary::LinearColorLerp(
-			BaseLayerColor, AdditiveAmountColor, GetAnimCurveValue(Curve));
+			Config.BaseLayerColor, Config.AdditiveAmountColor, GetAnimCurveValue(Curve));
 		Part->SetVectorParameterValue(FName("BaseColor"), Color);
 	};
 	
@@ -308,9 +528,9 @@ void ACharacterBase::UpdateLayeringColors()
 	FLinearColor ArmLColor;
 	LowerArmL->GetVectorParameterValue(FName("BaseColor"), ArmLColor);
 	FLinearColor AdditiveColor = UKismetMathLibrary::LinearColorLerp(
-			ArmLColor, HandColor, GetAnimCurveValue(FName("Layering_Hand_L")));
+			ArmLColor, Config.HandColor, GetAnimCurveValue(FName("Layering_Hand_L")));
 	FLinearColor HandLColor = UKismetMathLibrary::LinearColorLerp(
-			AdditiveColor, HandIKColor, GetAnimCurveValue(FName("Enable_HandIK_L")));
+			AdditiveColor, Config.HandIKColor, GetAnimCurveValue(FName("Enable_HandIK_L")));
 	HandL->GetVectorParameterValue(FName("BaseColor"), HandLColor);
 	
 	SetParameter1(ShoulderR, FName("Layering_Arm_R_Add"), FName("Layering_Arm_R"));
@@ -319,9 +539,9 @@ void ACharacterBase::UpdateLayeringColors()
 	FLinearColor ArmRColor;
 	LowerArmR->GetVectorParameterValue(FName("BaseColor"), ArmRColor);
 	FLinearColor AdditiveRColor = UKismetMathLibrary::LinearColorLerp(
-			ArmRColor, HandColor, GetAnimCurveValue(FName("Layering_Hand_L")));
+			ArmRColor, Config.HandColor, GetAnimCurveValue(FName("Layering_Hand_L")));
 	FLinearColor HandRColor = UKismetMathLibrary::LinearColorLerp(
-			AdditiveRColor, HandIKColor, GetAnimCurveValue(FName("Enable_HandIK_L")));
+			AdditiveRColor, Config.HandIKColor, GetAnimCurveValue(FName("Enable_HandIK_L")));
 	HandR->GetVectorParameterValue(FName("BaseColor"), HandRColor);
 }
 
@@ -343,108 +563,109 @@ void ACharacterBase::SetDynamicMaterials()
 
 void ACharacterBase::SetAndResetColors()
 {
-	if (SolidColor)
-	{
-		Head->SetVectorParameterValue(FName("BaseColor"), DefaultColor);
-		Torso->SetVectorParameterValue(FName("BaseColor"), DefaultColor);
-		Pelvis->SetVectorParameterValue(FName("BaseColor"), DefaultColor);
-		ShoulderL->SetVectorParameterValue(FName("BaseColor"), DefaultColor);
-		UpperArmL->SetVectorParameterValue(FName("BaseColor"), DefaultColor);
-		LowerArmL->SetVectorParameterValue(FName("BaseColor"), DefaultColor);
-		HandL->SetVectorParameterValue(FName("BaseColor"), DefaultColor);
-		ShoulderR->SetVectorParameterValue(FName("BaseColor"), DefaultColor);
-		UpperArmR->SetVectorParameterValue(FName("BaseColor"), DefaultColor);
-		LowerArmR->SetVectorParameterValue(FName("BaseColor"), DefaultColor);
-		HandR->SetVectorParameterValue(FName("BaseColor"), DefaultColor);
-		UpperLegs->SetVectorParameterValue(FName("BaseColor"), DefaultColor);
-		LowerLegs->SetVectorParameterValue(FName("BaseColor"), DefaultColor);
-		Feet->SetVectorParameterValue(FName("BaseColor"), DefaultColor);
-		Head->SetVectorParameterValue(FName("BaseColor"), DefaultColor);
+	const UCharacterLocomotionConfig& Config = GetLocomotionConfig();
+	if (Config.SolidColor)
+	{
+		Head->SetVectorParameterValue(FName("BaseColor"), Config.DefaultColor);
+		Torso->SetVectorParameterValue(FName("BaseColor"), Config.DefaultColor);
+		Pelvis->SetVectorParameterValue(FName("BaseColor"), Config.DefaultColor);
+		ShoulderL->SetVectorParameterValue(FName("BaseColor"), Config.DefaultColor);
+		UpperArmL->SetVectorParameterValue(FName("BaseColor"), Config.DefaultColor);
+		LowerArmL->SetVectorParameterValue(FName("BaseColor"), Config.DefaultColor);
+		HandL->SetVectorParameterValue(FName("BaseColor"), Config.DefaultColor);
+		ShoulderR->SetVectorParameterValue(FName("BaseColor"), Config.DefaultColor);
+		UpperArmR->SetVectorParameterValue(FName("BaseColor"), Config.DefaultColor);
+		LowerArmR->SetVectorParameterValue(FName("BaseColor"), Config.DefaultColor);
+		HandR->SetVectorParameterValue(FName("BaseColor"), Config.DefaultColor);
+		UpperLegs->SetVectorParameterValue(FName("BaseColor"), Config.DefaultColor);
+		LowerLegs->SetVectorParameterValue(FName("BaseColor"), Config.DefaultColor);
+		Feet->SetVectorParameterValue(FName("BaseColor"), Config.DefaultColor);
+		Head->SetVectorParameterValue(FName("BaseColor"), Config.DefaultColor);
 	}
 	else
 	{
-		Head->SetVectorParameterValue(FName("BaseColor"), SkinColor);
-		switch (ShirtType)
+		Head->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
+		switch (Config.ShirtType)
 		{
 		case 0:
-			Torso->SetVectorParameterValue(FName("BaseColor"), SkinColor);
-			ShoulderL->SetVectorParameterValue(FName("BaseColor"), SkinColor);
-			ShoulderR->SetVectorParameterValue(FName("BaseColor"), SkinColor);
-			UpperArmL->SetVectorParameterValue(FName("BaseColor"), SkinColor);
-			UpperArmR->SetVectorParameterValue(FName("BaseColor"), SkinColor);
-			LowerArmL->SetVectorParameterValue(FName("BaseColor"), SkinColor);
-			LowerArmR->SetVectorParameterValue(FName("BaseColor"), SkinColor);
+			Torso->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
+			ShoulderL->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
+			ShoulderR->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
+			UpperArmL->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
+			UpperArmR->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
+			LowerArmL->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
+			LowerArmR->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
 			break;
 		case 1:
-			Torso->SetVectorParameterValue(FName("BaseColor"), ShirtColor);
-			ShoulderL->SetVectorParameterValue(FName("BaseColor"), ShirtColor);
-			ShoulderR->SetVectorParameterValue(FName("BaseColor"), ShirtColor);
-			UpperArmL->SetVectorParameterValue(FName("BaseColor"), SkinColor);
-			UpperArmR->SetVectorParameterValue(FName("BaseColor"), SkinColor);
-			LowerArmL->SetVectorParameterValue(FName("BaseColor"), SkinColor);
-			LowerArmR->SetVectorParameterValue(FName("BaseColor"), SkinColor);
+			Torso->SetVectorParameterValue(FName("BaseColor"), Config.ShirtColor);
+			ShoulderL->SetVectorParameterValue(FName("BaseColor"), Config.ShirtColor);
+			ShoulderR->SetVectorParameterValue(FName("BaseColor"), Config.ShirtColor);
+			UpperArmL->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
+			UpperArmR->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
+			LowerArmL->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
+			LowerArmR->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
 			break;
 		case 2:
-			Torso->SetVectorParameterValue(FName("BaseColor"), ShirtColor);
-			ShoulderL->SetVectorParameterValue(FName("BaseColor"), ShirtColor);
-			ShoulderR->SetVectorParameterValue(FName("BaseColor"), ShirtColor);
-			UpperArmL->SetVectorParameterValue(FName("BaseColor"), ShirtColor);
-			UpperArmR->SetVectorParameterValue(FName("BaseColor"), ShirtColor);
-			LowerArmL->SetVectorParameterValue(FName("BaseColor"), SkinColor);
-			LowerArmR->SetVectorParameterValue(FName("BaseColor"), SkinColor);
+			Torso->SetVectorParameterValue(FName("BaseColor"), Config.ShirtColor);
+			ShoulderL->SetVectorParameterValue(FName("BaseColor"), Config.ShirtColor);
+			ShoulderR->SetVectorParameterValue(FName("BaseColor"), Config.ShirtColor);
+			UpperArmL->SetVectorParameterValue(FName("BaseColor"), Config.ShirtColor);
+			UpperArmR->SetVectorParameterValue(FName("BaseColor"), Config.ShirtColor);
+			LowerArmL->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
+			LowerArmR->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
 			break;
 		case 3:
-			Torso->SetVectorParameterValue(FName("BaseColor"), ShirtColor);
-			ShoulderL->SetVectorParameterValue(FName("BaseColor"), ShirtColor);
-			ShoulderR->SetVectorParameterValue(FName("BaseColor"), ShirtColor);
-			UpperArmL->SetVectorParameterValue(FName("BaseColor"), ShirtColor);
-			UpperArmR->SetVectorParameterValue(FName("BaseColor"), ShirtColor);
-			LowerArmL->SetVectorParameterValue(FName("BaseColor"), ShirtColor);
-			LowerArmR->SetVectorParameterValue(FName("BaseColor"), ShirtColor);
+			Torso->SetVectorParameterValue(FName("BaseColor"), Config.ShirtColor);
+			ShoulderL->SetVectorParameterValue(FName("BaseColor"), Config.ShirtColor);
+			ShoulderR->SetVectorParameterValue(FName("BaseColor"), Config.ShirtColor);
+			UpperArmL->SetVectorParameterValue(FName("BaseColor"), Config.ShirtColor);
+			UpperArmR->SetVectorParameterValue(FName("BaseColor"), Config.ShirtColor);
+			LowerArmL->SetVectorParameterValue(FName("BaseColor"), Config.ShirtColor);
+			LowerArmR->SetVectorParameterValue(FName("BaseColor"), Config.ShirtColor);
 			break;
 		default:
 			break;
 		}
 
-		switch (PantsType)
+		switch (Config.PantsType)
 		{
 		case 0:
-			Pelvis->SetVectorParameterValue(FName("BaseColor"), PantsColor);
-			UpperLegs->SetVectorParameterValue(FName("BaseColor"), SkinColor);
-			LowerLegs->SetVectorParameterValue(FName("BaseColor"), SkinColor);
+			Pelvis->SetVectorParameterValue(FName("BaseColor"), Config.PantsColor);
+			UpperLegs->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
+			LowerLegs->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
 			break;
 		case 1:
-			Pelvis->SetVectorParameterValue(FName("BaseColor"), PantsColor);
-			UpperLegs->SetVectorParameterValue(FName("BaseColor"), PantsColor);
-			LowerLegs->SetVectorParameterValue(FName("BaseColor"), SkinColor);
+			Pelvis->SetVectorParameterValue(FName("BaseColor"), Config.PantsColor);
+			UpperLegs->SetVectorParameterValue(FName("BaseColor"), Config.PantsColor);
+			LowerLegs->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
 			break;
 		case 2:
-			Pelvis->SetVectorParameterValue(FName("BaseColor"), PantsColor);
-			UpperLegs->SetVectorParameterValue(FName("BaseColor"), PantsColor);
-			LowerLegs->SetVectorParameterValue(FName("BaseColor"), PantsColor);
+			Pelvis->SetVectorParameterValue(FName("BaseColor"), Config.PantsColor);
+			UpperLegs->SetVectorParameterValue(FName("BaseColor"), Config.PantsColor);
+			LowerLegs->SetVectorParameterValue(FName("BaseColor"), Config.PantsColor);
 			break;
 		default:
 			break;
 		}
 
-		if (Shoes)
+		if (Config.Shoes)
 		{
-			Feet->SetVectorParameterValue(FName("BaseColor"), ShoesColor);
+			Feet->SetVectorParameterValue(FName("BaseColor"), Config.ShoesColor);
 		}
 		else
 		{
-			Feet->SetVectorParameterValue(FName("BaseColor"), SkinColor);
+			Feet->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
 		}
 
-		if (Gloves)
+		if (Config.Gloves)
 		{
-			HandL->SetVectorParameterValue(FName("BaseColor"), GlovesColor);
-			HandR->SetVectorParameterValue(FName("BaseColor"), GlovesColor);
+			HandL->SetVectorParameterValue(FName("BaseColor"), Config.GlovesColor);
+			HandR->SetVectorParameterValue(FName("BaseColor"), Config.GlovesColor);
 		}
 		else
 		{
-			HandL->SetVectorParameterValue(FName("BaseColor"), SkinColor);
-			HandR->SetVectorParameterValue(FName("BaseColor"), SkinColor);
+			HandL->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
+			HandR->SetVectorParameterValue(FName("BaseColor"), Config.SkinColor);
 		}
 	}
 }
@@ -481,24 +702,24 @@ void ACharacterBase::SetupPlayerInputComponent(UInputComponent* PlayerInputCompo
 
 		// JumpAction
 		// Pressed
-		// if (MovementAction == EMovementAction::None)
+		// if (Locomotion.MovementAction == EMovementAction::None)
 		// {
-		// 	switch (MovementState)
+		// 	switch (Locomotion.MovementState)
 		// 	{
 		// 	case EMovementState::None:
 		// 	case EMovementState::Grounded:
 		// 	case EMovementState::InAir:
-		// 		if (MovementState == EMovementState::Grounded)
+		// 		if (Locomotion.MovementState == EMovementState::Grounded)
 		// 		{
 		// 			bool bCanClimb =
-		// 				HasMovementInput ? MantleCheck(GroundedTraceSettings, EDrawDebugTrace::Type::ForDuration) : false;
-		// 			if (bCanClimb == false || !HasMovementInput)
+		// 				Locomotion.HasMovementInput ? MantleCheck(GroundedTraceSettings, EDrawDebugTrace::Type::ForDuration) : false;
+		// 			if (bCanClimb == false || !Locomotion.HasMovementInput)
 		// 			{
-		// 				if (Stance == EStance::Standing)
+		// 				if (Locomotion.Stance == EStance::Standing)
 		// 				{
 		// 					Jump();
 		// 				}
-		// 				else if (Stance == EStance::Crouching)
+		// 				else if (Locomotion.Stance == EStance::Crouching)
 		// 				{
 		// 					UnCrouch();
 		// 				}
@@ -519,36 +740,36 @@ void ACharacterBase::SetupPlayerInputComponent(UInputComponent* PlayerInputCompo
 		// StopJumping();
 
 		// StanceAction
-		// if (MovementAction == EMovementAction::None)
+		// if (Locomotion.MovementAction == EMovementAction::None)
 		// {
 		// 	// todo1, Multi Tap Input, 判断按压次数
 		// 	// First Press
-		// 	if (MovementState == EMovementState::Grounded)
+		// 	if (Locomotion.MovementState == EMovementState::Grounded)
 		// 	{
-		// 		if (Stance == EStance::Standing)
+		// 		if (Locomotion.Stance == EStance::Standing)
 		// 		{
 		// 			DesiredStance = EStance::Crouching;
 		// 			Crouch();
 		// 		}
-		// 		else if (Stance == EStance::Crouching)
+		// 		else if (Locomotion.Stance == EStance::Crouching)
 		// 		{
 		// 			DesiredStance = EStance::Standing;
 		// 			UnCrouch();
 		// 		}
 		// 	}
-		// 	else if (MovementState == EMovementState::InAir)
+		// 	else if (Locomotion.MovementState == EMovementState::InAir)
 		// 	{
-		// 		BreakFall = true;
+		// 		Locomotion.BreakFall = true;
 		// 		// todo1, Retriggerable Delay
-		// 		BreakFall = false;
+		// 		Locomotion.BreakFall = false;
 		// 	}
 		// 	// multi press
 		// 	RollEvent();
-		// 	if (Stance == EStance::Standing)
+		// 	if (Locomotion.Stance == EStance::Standing)
 		// 	{
 		// 		DesiredStance = EStance::Crouching;
 		// 	}
-		// 	else if (Stance == EStance::Crouching)
+		// 	else if (Locomotion.Stance == EStance::Crouching)
 		// 	{
 		// 		DesiredStance = EStance::Standing;
 		// 	}
@@ -604,10 +825,10 @@ void ACharacterBase::SetupPlayerInputComponent(UInputComponent* PlayerInputCompo
 		// 	BPISetViewMode(EViewMode::ThirdPerson);
 		// }
 		// Tapped
-		// RightShoulder = !RightShoulder;
+		// Locomotion.RightShoulder = !Locomotion.RightShoulder;
 
 		// RagdollAction
-		// switch (MovementState)
+		// switch (Locomotion.MovementState)
 		// {
 		// case EMovementState::None:
 		// case EMovementState::Grounded:
@@ -638,8 +859,8 @@ void ACharacterBase::SetupPlayerInputComponent(UInputComponent* PlayerInputCompo
 
 void ACharacterBase::PlayerMovementInput(bool IsForwardAxis)
 {
-	if (MovementState == EMovementState::Grounded ||
-		MovementState == EMovementState::InAir)
+	if (Locomotion.MovementState == EMovementState::Grounded ||
+		Locomotion.MovementState == EMovementState::InAir)
 	{
 		FVector ForwardVector;
 		FVector RightVector;
@@ -660,18 +881,14 @@ void ACharacterBase::PlayerMovementInput(bool IsForwardAxis)
 
 void ACharacterBase::FixDiagonalGamepadValues(float InX, float InY, float& OutX, float& OutY)
 {
-	float ClampX = UKismetMathLibrary::MapRangeClamped(
-		FMath::Abs(InX), 0.0f, 0.6f, 1.0f, 1.2f);
-	float ClampY = UKismetMathLibrary::MapRangeClamped(
-		FMath::Abs(InY), 0.0f, 0.6f, 1.0f, 1.2f);
-	OutX = UKismetMathLibrary::FClamp(InX * ClampY, -1.0f, 1.0f);
-	OutY = UKismetMathLibrary::FClamp(InY * ClampX, -1.0f, 1.0f);
+	LocomotionMath::FixDiagonalGamepadValues(InX, InY, OutX, OutY);
 }
 
 void ACharacterBase::Move(const FInputActionValue& Value)
 {
 	// input is a Vector2D
 	FVector2D MovementVector = Value.Get<FVector2D>();
+	RecordedMoveInput = MovementVector;
 
 	if (Controller != nullptr)
 	{
@@ -695,6 +912,7 @@ void ACharacterBase::Look(const FInputActionValue& Value)
 {
 	// input is a Vector2D
 	FVector2D LookAxisVector = Value.Get<FVector2D>();
+	RecordedLookInput += LookAxisVector;
 
 	if (Controller != nullptr)
 	{
@@ -708,12 +926,13 @@ void ACharacterBase::OnOverlayStateChanged(EOverlayState NewOverlayState)
 {
 	OverlayState = NewOverlayState;
 	UpdateHeldObject();
+	UpdateResidentMontages();
 }
 
 void ACharacterBase::OnRotationModeChanged(ERotationMode NewRotationMode)
 {
-	RotationMode = NewRotationMode;
-	if (RotationMode == ERotationMode::VelocityDirection
+	Locomotion.RotationMode = NewRotationMode;
+	if (Locomotion.RotationMode == ERotationMode::VelocityDirection
 		&& ViewMode == EViewMode::FirstPerson)
 	{
 		SetViewMode(EViewMode::ThirdPerson);
@@ -722,7 +941,7 @@ void ACharacterBase::OnRotationModeChanged(ERotationMode NewRotationMode)
 
 void ACharacterBase::SetRotationMode(ERotationMode NewRotationMode)
 {
-	if (NewRotationMode != RotationMode)
+	if (NewRotationMode != Locomotion.RotationMode)
 	{
 		OnRotationModeChanged(NewRotationMode);
 	}
@@ -733,15 +952,15 @@ void ACharacterBase::OnViewModeChanged(EViewMode NewViewMode)
 	ViewMode = NewViewMode;
 	if (ViewMode == EViewMode::ThirdPerson)
 	{
-		if (RotationMode == ERotationMode::VelocityDirection
-			|| RotationMode == ERotationMode::LookingDirection)
+		if (Locomotion.RotationMode == ERotationMode::VelocityDirection
+			|| Locomotion.RotationMode == ERotationMode::LookingDirection)
 		{
 			SetRotationMode(DesiredRotationMode);
 		}
 	}
 	else if (ViewMode == EViewMode::FirstPerson)
 	{
-		if (RotationMode == ERotationMode::VelocityDirection)
+		if (Locomotion.RotationMode == ERotationMode::VelocityDirection)
 		{
 			SetRotationMode(ERotationMode::LookingDirection);
 		}
@@ -756,35 +975,141 @@ void ACharacterBase::SetViewMode(EViewMode NewViewMode)
 	}
 }
 
-void ACharacterBase::SetEssentialValues()
+void ACharacterBase::SetEssentialValues(float RateSeconds)
 {
 	// How the capsule is Moving
 	// Function: CalculateAcceleration
-	Acceleration = (GetVelocity() - PreviousVelocity)/UGameplayStatics::GetWorldDeltaSeconds(this);
-	Speed = GetVelocity().Size2D();
-	IsMoving = Speed > 1.0;
-	if (IsMoving)
+	if (RateSeconds > 0.0f)
+	{
+		Locomotion.Acceleration = (GetVelocity() - Locomotion.PreviousVelocity) / RateSeconds;
+		Locomotion.AimYawRate = FMath::Abs((GetControlRotation().Yaw - Locomotion.PreviousAimYaw) / RateSeconds);
+	}
+	Locomotion.Speed = GetVelocity().Size2D();
+	Locomotion.IsMoving = Locomotion.Speed > 1.0;
+	if (Locomotion.IsMoving)
 	{
-		LastVelocityRotation = GetVelocity().Rotation();
+		Locomotion.LastVelocityRotation = GetVelocity().Rotation();
 	}
 
 	if(IsValid(XXCharacterMovement))
 	{
-		MovementInputAmount = XXCharacterMovement->GetCurrentAcceleration().Length() /  XXCharacterMovement->MaxAcceleration;
-		HasMovementInput = MovementInputAmount > 0.0;
-		if (HasMovementInput)
+		Locomotion.MovementInputAmount = XXCharacterMovement->GetCurrentAcceleration().Length() /  XXCharacterMovement->MaxAcceleration;
+		Locomotion.HasMovementInput = Locomotion.MovementInputAmount > 0.0;
+		if (Locomotion.HasMovementInput)
+		{
+			Locomotion.LastMovementInputRotation = XXCharacterMovement->GetCurrentAcceleration().Rotation();
+		}
+	}
+}
+
+void ACharacterBase::RecordLocomotionFrame(float DeltaSeconds)
+{
+	FLocomotionRecordFrame Frame;
+	Frame.WorldTime = GetWorld()->GetTimeSeconds();
+	Frame.DeltaSeconds = DeltaSeconds;
+	Frame.Location = FVector3f(GetActorLocation());
+	Frame.Velocity = FVector3f(GetVelocity());
+	Frame.Acceleration = FVector3f(Locomotion.Acceleration);
+	Frame.MovementInput = FVector3f(XXCharacterMovement->GetCurrentAcceleration());
+	Frame.MoveInput = FVector2f(RecordedMoveInput);
+	Frame.LookInput = FVector2f(RecordedLookInput);
+	Frame.ActorYaw = GetActorRotation().Yaw;
+	Frame.ControlYaw = GetControlRotation().Yaw;
+	Frame.ControlPitch = GetControlRotation().Pitch;
+	Frame.Speed = Locomotion.Speed;
+	Frame.MovementInputAmount = Locomotion.MovementInputAmount;
+	Frame.AimYawRate = Locomotion.AimYawRate;
+	for (int32 CurveIndex = 0; CurveIndex < FLocomotionRecordFrame::NumCurves; ++CurveIndex)
+	{
+		Frame.Curves[CurveIndex] = GetAnimCurveValue(FLocomotionRecordFrame::CurveNames[CurveIndex]);
+	}
+	Frame.MovementMode = XXCharacterMovement->MovementMode;
+	Frame.MovementState = static_cast<uint8>(Locomotion.MovementState);
+	Frame.MovementAction = static_cast<uint8>(Locomotion.MovementAction);
+	Frame.Gait = static_cast<uint8>(Locomotion.Gait);
+	Frame.Stance = static_cast<uint8>(Locomotion.Stance);
+	Frame.RotationMode = static_cast<uint8>(Locomotion.RotationMode);
+	Frame.ViewMode = static_cast<uint8>(ViewMode);
+	Frame.OverlayState = static_cast<uint8>(OverlayState);
+	Frame.TraceFlags = FrameTraceFlags;
+	if (Locomotion.IsMoving)
+	{
+		Frame.StateFlags |= ELocomotionStateFlags::IsMoving;
+	}
+	if (Locomotion.HasMovementInput)
+	{
+		Frame.StateFlags |= ELocomotionStateFlags::HasMovementInput;
+	}
+	if (RagdollFaceUp)
+	{
+		Frame.StateFlags |= ELocomotionStateFlags::RagdollFaceUp;
+	}
+	if (RagdollOnGround)
+	{
+		Frame.StateFlags |= ELocomotionStateFlags::RagdollOnGround;
+	}
+	if (bPressedJump)
+	{
+		Frame.StateFlags |= ELocomotionStateFlags::JumpPressed;
+	}
+	LocomotionRecorder->RecordFrame(Frame);
+}
+
+void ACharacterBase::StartLocomotionRecording(const FString& Filename)
+{
+	StopLocomotionRecording();
+	LocomotionRecorder = FLocomotionRecorder::Start(Filename, GetName());
+}
+
+void ACharacterBase::ReplayLocomotionInput(const FVector2D& MoveValue, const FVector2D& LookValue, bool bJumpPressed)
+{
+	Move(FInputActionValue(MoveValue));
+
+	// 回放时没有本地玩家，PlayerController不会处理RotationInput，直接累加到控制器朝向
+	if (Controller != nullptr && !LookValue.IsZero() && !Controller->IsLookInputIgnored())
+	{
+		RecordedLookInput += LookValue;
+
+		// 与APlayerController::AddYawInput/AddPitchInput和UpdateRotation相同的缩放和俯仰限制，否则回放转向与录制时不同
+		FRotator DeltaRotation(LookValue.Y, LookValue.X, 0.0f);
+		FRotator ViewRotation = Controller->GetControlRotation();
+		const APlayerController* PlayerController = Cast<APlayerController>(Controller);
+		if (PlayerController != nullptr && GetDefault<UInputSettings>()->bEnableLegacyInputScales)
 		{
-			LastMovementInputRotation = XXCharacterMovement->GetCurrentAcceleration().Rotation();
+			DeltaRotation.Pitch *= PlayerController->InputPitchScale_DEPRECATED;
+			DeltaRotation.Yaw *= PlayerController->InputYawScale_DEPRECATED;
 		}
+		if (PlayerController != nullptr && PlayerController->PlayerCameraManager != nullptr)
+		{
+			// 会把DeltaRotation加到ViewRotation上并清零
+			PlayerController->PlayerCameraManager->ProcessViewRotation(GetWorld()->GetDeltaSeconds(), ViewRotation, DeltaRotation);
+		}
+		Controller->SetControlRotation((ViewRotation + DeltaRotation).GetNormalized());
+	}
+
+	if (bJumpPressed && !bPressedJump)
+	{
+		Jump();
+	}
+	else if (!bJumpPressed && bPressedJump)
+	{
+		StopJumping();
 	}
+}
 
-	AimYawRate = FMath::Abs((GetControlRotation().Yaw - PreviousAimYaw) / UGameplayStatics::GetWorldDeltaSeconds(this));
+void ACharacterBase::StopLocomotionRecording()
+{
+	if (LocomotionRecorder.IsValid())
+	{
+		LocomotionRecorder->Stop();
+		LocomotionRecorder.Reset();
+	}
 }
 
 void ACharacterBase::CacheValues()
 {
-	PreviousVelocity = GetVelocity();
-	PreviousAimYaw = GetControlRotation().Yaw;
+	Locomotion.PreviousVelocity = GetVelocity();
+	Locomotion.PreviousAimYaw = GetControlRotation().Yaw;
 }
 
 void ACharacterBase::DrawDebugShapes()
@@ -812,7 +1137,7 @@ void ACharacterBase::DrawDebugShapes()
 				// todo, 区分不同颜色
 				// Velocity Arrow
 				FVector CurrentVelocity = GetVelocity();
-				FVector SelectVelocity = CurrentVelocity.IsNearlyZero() ? LastVelocityRotation.Vector() : CurrentVelocity;
+				FVector SelectVelocity = CurrentVelocity.IsNearlyZero() ? Locomotion.LastVelocityRotation.Vector() : CurrentVelocity;
 				FVector OffsetVelocity = SelectVelocity.GetUnsafeNormal() * UKismetMathLibrary::MapRangeClamped(
 					CurrentVelocity.Length(), 0.0f, XXCharacterMovement->MaxWalkSpeed, 50.0f, 75.0f);
 				FVector LineStart = GetActorLocation() - FVector(0.0f, 0.0f, GetCapsuleComponent()->GetScaledCapsuleHalfHeight());
@@ -822,7 +1147,7 @@ void ACharacterBase::DrawDebugShapes()
 
 				// Movement Input Arrow
 				FVector CurrentAcceleration = XXCharacterMovement->GetCurrentAcceleration();
-				FVector SelectAcceleration = CurrentAcceleration.IsNearlyZero() ? LastMovementInputRotation.Vector() : CurrentAcceleration;
+				FVector SelectAcceleration = CurrentAcceleration.IsNearlyZero() ? Locomotion.LastMovementInputRotation.Vector() : CurrentAcceleration;
 				FVector OffsetAcceleration = SelectAcceleration.GetUnsafeNormal() * UKismetMathLibrary::MapRangeClamped(
 					CurrentVelocity.Length() / XXCharacterMovement->GetMaxAcceleration(),
 					0.0f, 1.0f, 50.0f, 75.0f);
@@ -833,7 +1158,7 @@ void ACharacterBase::DrawDebugShapes()
 
 				// Target Rotation Arrow
 				FVector TargetRotationStart = GetActorLocation() - FVector(0.0f, 0.0f, GetCapsuleComponent()->GetScaledCapsuleHalfHeight() - 7.0f);
-				FVector TargetRotationEnd = TargetRotationStart + TargetRotation.Vector().GetUnsafeNormal() * 50.0f;
+				FVector TargetRotationEnd = TargetRotationStart + Locomotion.TargetRotation.Vector().GetUnsafeNormal() * 50.0f;
 				UKismetSystemLibrary::DrawDebugArrow(
 					this, TargetRotationStart, TargetRotationEnd, 50.0f, FColor::Blue, 0.0f, 3.0f);
 
@@ -857,33 +1182,41 @@ void ACharacterBase::DrawDebugShapes()
 
 void ACharacterBase::UpdateCharacterMovement()
 {
-	AllowedGait = GetAllowedGait();
+	Locomotion.AllowedGait = GetAllowedGait();
 	
-	ActualGait = GetActualGait(AllowedGait);
-	if (ActualGait != Gait)
+	Locomotion.ActualGait = GetActualGait(Locomotion.AllowedGait);
+	if (Locomotion.ActualGait != Locomotion.Gait)
 	{
-		BPISetGait(ActualGait);
+		BPISetGait(Locomotion.ActualGait);
 	}
 
-	UpdateDynamicMovementSettings(AllowedGait);
+	UpdateDynamicMovementSettings(Locomotion.AllowedGait);
 }
 
 void ACharacterBase::UpdateInAirRotation()
 {
-	// 优化，根据模式提供接口，抽象主要接口，不要在每个函数里都调用判断
-	if (RotationMode == ERotationMode::VelocityDirection ||
-		RotationMode == ERotationMode::LookingDirection)
-	{
-		SmoothCharacterRotation(FRotator(0.0f, InAirRotation.Yaw, 0.0f), 0.0f, 5.0f);
-	}
-	else if (RotationMode == ERotationMode::Aiming)
+	using FRotationHandler = void (ACharacterBase::*)();
+	static constexpr FRotationHandler InAirRotationHandlers[LocomotionStateTables::NumRotationModes] =
 	{
-		SmoothCharacterRotation(FRotator(0.0f, GetControlRotation().Yaw, 0.0f), 0.0f, 15.0f);
-		InAirRotation = GetActorRotation();
-	}
+		&ACharacterBase::UpdateInAirVelocityRotation,	// VelocityDirection
+		&ACharacterBase::UpdateInAirVelocityRotation,	// LookingDirection
+		&ACharacterBase::UpdateInAirAimingRotation,		// Aiming
+	};
+	(this->*InAirRotationHandlers[LocomotionStateTables::ToIndex(Locomotion.RotationMode)])();
+}
+
+void ACharacterBase::UpdateInAirVelocityRotation()
+{
+	SmoothCharacterRotation(FRotator(0.0f, Locomotion.InAirRotation.Yaw, 0.0f), 0.0f, 5.0f);
+}
+
+void ACharacterBase::UpdateInAirAimingRotation()
+{
+	SmoothCharacterRotation(FRotator(0.0f, GetControlRotation().Yaw, 0.0f), 0.0f, 15.0f);
+	Locomotion.InAirRotation = GetActorRotation();
 }
 
-bool ACharacterBase::MantleCheck(FMantleTraceSettings TraceSettings, EDrawDebugTrace::Type DebugType)
+bool ACharacterBase::MantleCheck(const FMantleTraceSettings& TraceSettings, EDrawDebugTrace::Type DebugType)
 {
 	// Can Climb/Vault
 	// Step 1, 向前追踪以找到角色无法行走的墙/对象。
@@ -895,19 +1228,21 @@ bool ACharacterBase::MantleCheck(FMantleTraceSettings TraceSettings, EDrawDebugT
 	FVector BlockEnd = BlockStart + GetPlayerMovementInput() * TraceSettings.ReachDistance;
 	float HalfHeight = (TraceSettings.MaxLedgeHeight - TraceSettings.MinLedgeHeight) / 2.0f + 1.0f;
 	FHitResult BlockHitResult;
-	TArray<AActor*> ActorsToIgnore;
 	// Todo, TraceChannel -> Climbable
-	UKismetSystemLibrary::CapsuleTraceSingle(
-		this, BlockStart, BlockEnd, TraceSettings.ForwardTraceRadius,
-		HalfHeight, TraceTypeQuery1,false, ActorsToIgnore,
-		GetTraceDebugType(DebugType), BlockHitResult, true,
-		FLinearColor::Black, FLinearColor::Black, 1.0f);
+	const bool bBlockHit = GetWorld()->SweepSingleByChannel(BlockHitResult, BlockStart, BlockEnd, FQuat::Identity,
+		UEngineTypes::ConvertToCollisionChannel(TraceTypeQuery1),
+		FCollisionShape::MakeCapsule(TraceSettings.ForwardTraceRadius, HalfHeight), TraceQueryParams);
+#if ENABLE_DRAW_DEBUG
+	DrawDebugCapsuleTraceSingle(GetWorld(), BlockStart, BlockEnd, TraceSettings.ForwardTraceRadius, HalfHeight,
+		GetTraceDebugType(DebugType), bBlockHit, BlockHitResult, FLinearColor::Black, FLinearColor::Black, 1.0f);
+#endif
 	if (!XXCharacterMovement->IsWalkable(BlockHitResult)
 		&& BlockHitResult.bBlockingHit
 		&& !BlockHitResult.bStartPenetrating)
 	{
 		InitialTraceImpactPoint = BlockHitResult.ImpactPoint;
 		InitialTraceNormal = BlockHitResult.Normal;
+		FrameTraceFlags |= ELocomotionTraceFlags::MantleForwardHit;
 	}
 	else
 	{
@@ -921,18 +1256,20 @@ bool ACharacterBase::MantleCheck(FMantleTraceSettings TraceSettings, EDrawDebugT
 	FVector CanWalkableStart = CanWalkableEnd +
 		FVector(0.0f, 0.0f, TraceSettings.MaxLedgeHeight + TraceSettings.DownwardTraceRadius + 1.0f);
 	FHitResult Step2HitResult;
-    TArray<AActor*> Step2ActorsToIgnore;
 	UPrimitiveComponent* HitComponent = nullptr;
     // Todo, TraceChannel -> Climbable
-	UKismetSystemLibrary::CapsuleTraceSingle(
-		this, CanWalkableStart, CanWalkableEnd, TraceSettings.DownwardTraceRadius,
-		HalfHeight, TraceTypeQuery1,false, Step2ActorsToIgnore,
-		GetTraceDebugType(DebugType), Step2HitResult, true,
-		FLinearColor::Yellow, FLinearColor::Red, 1.0f);
+	const bool bStep2Hit = GetWorld()->SweepSingleByChannel(Step2HitResult, CanWalkableStart, CanWalkableEnd, FQuat::Identity,
+		UEngineTypes::ConvertToCollisionChannel(TraceTypeQuery1),
+		FCollisionShape::MakeCapsule(TraceSettings.DownwardTraceRadius, HalfHeight), TraceQueryParams);
+#if ENABLE_DRAW_DEBUG
+	DrawDebugCapsuleTraceSingle(GetWorld(), CanWalkableStart, CanWalkableEnd, TraceSettings.DownwardTraceRadius, HalfHeight,
+		GetTraceDebugType(DebugType), bStep2Hit, Step2HitResult, FLinearColor::Yellow, FLinearColor::Red, 1.0f);
+#endif
 	if (XXCharacterMovement->IsWalkable(Step2HitResult) && Step2HitResult.bBlockingHit)
 	{
 		DownTraceLocation = FVector(Step2HitResult.Location.X, Step2HitResult.Location.Y, Step2HitResult.ImpactPoint.Z);
 		HitComponent = Step2HitResult.Component.Get();
+		FrameTraceFlags |= ELocomotionTraceFlags::MantleWalkableHit;
 	}
 	else
 	{
@@ -953,6 +1290,7 @@ bool ACharacterBase::MantleCheck(FMantleTraceSettings TraceSettings, EDrawDebugT
 		FRotator BaseRotation = (InitialTraceNormal * FVector(-1.0f, -1.0f, 0.0f)).Rotation();
 		TargetTransform = FTransform(Rotation, BaseLocation, FVector::OneVector);
 		MantleHeight = (TargetTransform.GetLocation() - GetActorLocation()).Z;
+		FrameTraceFlags |= ELocomotionTraceFlags::MantleHasRoom;
 	}
 	else
 	{
@@ -961,7 +1299,7 @@ bool ACharacterBase::MantleCheck(FMantleTraceSettings TraceSettings, EDrawDebugT
 
 	// Step4, 通过检查移动模式和攀爬高度来确定攀爬类型。
 	EMantleType MantleType = EMantleType::HighMantle;
-	switch (MovementState)
+	switch (Locomotion.MovementState)
 	{
 	case EMovementState::None:
 	case EMovementState::Grounded:
@@ -994,8 +1332,8 @@ bool ACharacterBase::MantleCheck(FMantleTraceSettings TraceSettings, EDrawDebugT
 void ACharacterBase::MantleStart(float MantleHeight, FComponentAndTransform MantleLedgeWS, EMantleType MantleType)
 {
 	// Step1, 获取攀爬资源并使用它来设置新的攀爬参数。
-	FMantleAsset MantleAsset = GetMantleAsset(MantleType);
-	MantleParams.AnimMontage = MantleAsset.AnimMontage;
+	const FMantleAsset& MantleAsset = GetMantleAsset(MantleType);
+	MantleParams.AnimMontage = ResolveResidentMontage(MantleAsset.AnimMontage);
 	MantleParams.PositionCurve = MantleAsset.PositionCurve;
 	MantleParams.PlayRate = UKismetMathLibrary::MapRangeClamped(MantleHeight, MantleAsset.LowHeight,
 		MantleAsset.HighHeight, MantleAsset.LowPlayRate, MantleAsset.HighPlayRate);
@@ -1038,11 +1376,7 @@ void ACharacterBase::MantleStart(float MantleHeight, FComponentAndTransform Mant
 	}
 
 	// step7, 如果有效，播放动画蒙太奇。
-	if (IsValid(MantleParams.AnimMontage) && IsValid(MainAnimInstance))
-	{
-		MainAnimInstance->Montage_Play(MantleParams.AnimMontage, MantleParams.PlayRate,
-			EMontagePlayReturnType::MontageLength, MantleParams.StartingPosition, false);
-	}
+	PlayLocomotionMontage(MantleParams.AnimMontage, MantleParams.PlayRate, MantleParams.StartingPosition);
 
 	if (MantleType == EMantleType::HighMantle ||
 		MantleType == EMantleType::FallingCatch)
@@ -1057,8 +1391,9 @@ void ACharacterBase::MantleEnd()
 	UpdateHeldObject();
 }
 
-FMantleAsset ACharacterBase::GetMantleAsset(EMantleType MantleType)
+const FMantleAsset& ACharacterBase::GetMantleAsset(EMantleType MantleType) const
 {
+	const UCharacterLocomotionConfig& Config = GetLocomotionConfig();
 	// // Todo, 创建初始化结构体，直接初始化
 	// FMantleAsset MantleAsset;
 	// switch (MantleType)
@@ -1096,42 +1431,58 @@ FMantleAsset ACharacterBase::GetMantleAsset(EMantleType MantleType)
 	// }
 	// return MantleAsset;
 
-	FMantleAsset ResultAsset;
-	if (MantleType == EMantleType::HighMantle ||
-		MantleType == EMantleType::FallingCatch)
+	using FMantleAssetMember = FMantleAsset UCharacterLocomotionConfig::*;
+	static constexpr FMantleAssetMember LowMantleAssets[LocomotionStateTables::NumOverlayHandGroups] =
+	{
+		&UCharacterLocomotionConfig::Mantle1mDefault,
+		&UCharacterLocomotionConfig::Mantle1mLH,
+		&UCharacterLocomotionConfig::Mantle1m2H,
+		&UCharacterLocomotionConfig::Mantle1mRH,
+		&UCharacterLocomotionConfig::Mantle1mBox,
+	};
+	if (MantleType == EMantleType::LowMantle)
 	{
-		ResultAsset = Mantle2mDefault;
+		return Config.*LowMantleAssets[LocomotionStateTables::GetOverlayHandGroupIndex(OverlayState)];
 	}
-	else if (MantleType == EMantleType::LowMantle)
+	return Config.Mantle2mDefault;
+}
+
+void ACharacterBase::UpdateResidentMontages()
+{
+	ULocomotionMontageResidency* MontageResidency = GetWorld() && GetWorld()->IsGameWorld() ? GetWorld()->GetSubsystem<ULocomotionMontageResidency>() : nullptr;
+	if (MontageResidency == nullptr)
 	{
-		switch (OverlayState)
-		{
-		case EOverlayState::Default:
-		case EOverlayState::Masculine:
-		case EOverlayState::Feminine:
-			ResultAsset = Mantle1mDefault;
-			break;
-		case EOverlayState::Injured:
-		case EOverlayState::Bow:
-		case EOverlayState::Torch:
-		case EOverlayState::Barrel:
-			ResultAsset = Mantle1mLH;
-			break;
-		case EOverlayState::HandsTied:
-			ResultAsset = Mantle1m2H;
-			break;
-		case EOverlayState::Rifle:
-		case EOverlayState::Pistol1H:
-		case EOverlayState::Pistol2H:
-		case EOverlayState::Binoculars:
-			ResultAsset = Mantle1mRH;
-			break;
-		case EOverlayState::Box:
-			ResultAsset = Mantle1mBox;
-			break;
-		}
+		return;
+	}
+
+	// 任何姿态都可能进入布娃娃，翻滚和攀爬只会在站立时发生
+	TArray<TSoftObjectPtr<UAnimMontage>, TInlineAllocator<5>> Montages;
+	Montages.Add(SelectGetUpMontage(true));
+	Montages.Add(SelectGetUpMontage(false));
+	if (Locomotion.Stance == EStance::Standing)
+	{
+		Montages.Add(SelectRollMontage());
+		Montages.Add(GetMantleAsset(EMantleType::HighMantle).AnimMontage);
+		Montages.Add(GetMantleAsset(EMantleType::LowMantle).AnimMontage);
+	}
+	// 模拟代理和服务器上的远端玩家播放的蒙太奇按发送端的状态选择，与本地的OverlayState和姿态无关，表里的蒙太奇整体常驻。
+	// 同样登记在角色自己名下，EndPlay时一起释放，最后一个代理离开后可以被回收
+	if (IsMontageSelectedRemotely() && IsValid(MontageRegistry))
+	{
+		Montages.Append(MontageRegistry->Montages);
 	}
-	return ResultAsset;
+	MontageResidency->SetResidentMontages(this, Montages);
+}
+
+bool ACharacterBase::IsMontageSelectedRemotely() const
+{
+	return GetLocalRole() == ROLE_SimulatedProxy || (HasAuthority() && IsPlayerControlled() && !IsLocallyControlled());
+}
+
+UAnimMontage* ACharacterBase::ResolveResidentMontage(const TSoftObjectPtr<UAnimMontage>& Montage)
+{
+	ULocomotionMontageResidency* MontageResidency = GetWorld()->GetSubsystem<ULocomotionMontageResidency>();
+	return MontageResidency ? MontageResidency->GetResidentMontage(Montage) : Montage.Get();
 }
 
 EDrawDebugTrace::Type ACharacterBase::GetTraceDebugType(EDrawDebugTrace::Type ShowTraceType)
@@ -1187,18 +1538,26 @@ bool ACharacterBase::CapsuleHasRoomCheck(
 		FVector End = TargetLocation - FVector(0.0f, 0.0f, Z);
 		float Radius = CapsuleComp->GetUnscaledCapsuleRadius() + RadiusOffset;
 		FHitResult HitResult;
-		TArray<AActor*> ActorsToIgnore;
-		UKismetSystemLibrary::SphereTraceSingleByProfile(this, Start, End, Radius,
-			FName("ALS_Character"), false, ActorsToIgnore, GetTraceDebugType(DebugTye),
-			HitResult, true, FLinearColor::Green, FLinearColor::Blue, 1.0f);
+		const bool bHit = GetWorld()->SweepSingleByProfile(HitResult, Start, End, FQuat::Identity,
+			FName("ALS_Character"), FCollisionShape::MakeSphere(Radius), TraceQueryParams);
+#if ENABLE_DRAW_DEBUG
+		DrawDebugSphereTraceSingle(GetWorld(), Start, End, Radius, GetTraceDebugType(DebugTye),
+			bHit, HitResult, FLinearColor::Green, FLinearColor::Blue, 1.0f);
+#endif
 		return !(HitResult.bBlockingHit || HitResult.bStartPenetrating);
 	}
 	return false;
 }
 
+const UCharacterLocomotionConfig& ACharacterBase::GetLocomotionConfig() const
+{
+	return LocomotionConfig ? *LocomotionConfig : *GetDefault<UCharacterLocomotionConfig>();
+}
+
 void ACharacterBase::RagdollStart()
 {
 	ClearHeldObject();
+	EndHitReaction();
 	
 	// Step1, 清除角色移动模式并将移动状态设置为碎布玩偶
 	XXCharacterMovement->SetMovementMode(EMovementMode::MOVE_None);
@@ -1212,6 +1571,7 @@ void ACharacterBase::RagdollStart()
 		{
 			GetMesh()->SetCollisionObjectType(ECollisionChannel::ECC_PhysicsBody);
 			GetMesh()->SetCollisionEnabled(ECollisionEnabled::Type::QueryAndPhysics);
+			SelectRagdollPhysicsAsset();
 			GetMesh()->SetAllBodiesBelowSimulatePhysics(UKismetSystemLibrary::MakeLiteralName(FName("pelvis")), true, true);
 		}
 	}
@@ -1221,90 +1581,582 @@ void ACharacterBase::RagdollStart()
 	{
 		MainAnimInstance->Montage_Stop(0.2f);
 	}
-}
 
-void ACharacterBase::RagdollUpdate()
-{
-	if (!IsValid(GetMesh()))
+	// step4, 申请模拟预算，超出预算时会立即降级
+	RagdollTier = ERagdollSimulationTier::Full;
+	RagdollUpdateCounter = 0;
+	RagdollMotorDrive.Initialize(GetMesh(), RagdollMaxMotorSpring);
+	bRagdollSettled = false;
+	RagdollSettleStartTime = -1.0;
+	BeginRagdollControl();
+	if (URagdollBudgetSubsystem* RagdollBudget = GetWorld()->GetSubsystem<URagdollBudgetSubsystem>())
 	{
-		return;
+		RagdollBudget->RegisterRagdoll(this);
 	}
-	
-	LastRagdollVelocity = GetMesh()->GetPhysicsLinearVelocity(FName("root"));
-	
-	float Spring = UKismetMathLibrary::MapRangeClamped(LastRagdollVelocity.Length(),
-		0.0f, 1000.0f, 0.0f, 25000.0f);
-	GetMesh()->SetAllMotorsAngularDriveParams(Spring, 0.0f, 0.0f, false);
-
-	GetMesh()->SetEnableGravity(LastRagdollVelocity.Z > -4000.0f);
-
-	SetActorLocationDuringRagdoll();
 }
 
-void ACharacterBase::RagdollEnd()
+void ACharacterBase::SetRagdollSimulationTier(ERagdollSimulationTier NewTier)
 {
-	// step1
-	if (IsValid(MainAnimInstance))
+	if (NewTier == RagdollTier || Locomotion.MovementState != EMovementState::Ragdoll || !IsValid(GetMesh()))
 	{
-		MainAnimInstance->SavePoseSnapshot(FName("RagdollPose"));
+		return;
 	}
 
-	// step2
-	if (IsValid(XXCharacterMovement))
+	RagdollTier = NewTier;
+	switch (NewTier)
 	{
-		if (RagdollOnGround)
+	case ERagdollSimulationTier::Full:
+	case ERagdollSimulationTier::Simplified:
+		// 已经静止的布娃娃保持定格，直到被唤醒
+		if (!bRagdollSettled)
 		{
-			XXCharacterMovement->SetMovementMode(EMovementMode::MOVE_Walking);
-			MainAnimInstance->Montage_Play(GetGetUpAnimation(RagdollFaceUp));
+			ThawRagdollPose();
 		}
-		else
+		if (RagdollMailbox.IsValid())
 		{
-			XXCharacterMovement->SetMovementMode(EMovementMode::MOVE_Falling);
-			XXCharacterMovement->Velocity = LastRagdollVelocity;
+			if (URagdollBudgetSubsystem* RagdollBudget = GetWorld()->GetSubsystem<URagdollBudgetSubsystem>())
+			{
+				RagdollBudget->SetAsyncMotorsEnabled(this, NewTier == ERagdollSimulationTier::Full);
+			}
+		}
+		else if (NewTier == ERagdollSimulationTier::Simplified)
+		{
+			RagdollMotorDrive.SetSpring(0.0f);
 		}
+		break;
+	case ERagdollSimulationTier::Frozen:
+		FreezeRagdollPose();
+		break;
+	default:
+		break;
 	}
+}
 
-	// step3
-	if (IsValid(GetCapsuleComponent()) && IsValid(GetMesh()))
+void ACharacterBase::WakeRagdoll()
+{
+	if (Locomotion.MovementState != EMovementState::Ragdoll || !bRagdollSettled)
 	{
-		GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::Type::QueryAndPhysics);
-		GetMesh()->SetCollisionObjectType(ECollisionChannel::ECC_Pawn);
-		GetMesh()->SetCollisionEnabled(ECollisionEnabled::Type::PhysicsOnly);
-		GetMesh()->SetAllBodiesSimulatePhysics(false);
+		return;
+	}
+
+	bRagdollSettled = false;
+	RagdollSettleStartTime = -1.0;
+	RagdollUpdateCounter = 0;
+	if (IsValid(GetMesh()))
+	{
+		GetMesh()->SetNotifyRigidBodyCollision(bMeshNotifiedRigidBodyCollision);
+		GetMesh()->OnComponentHit.RemoveDynamic(this, &ACharacterBase::OnRagdollMeshHit);
+	}
+	if (RagdollTier != ERagdollSimulationTier::Frozen)
+	{
+		ThawRagdollPose();
+	}
+}
+
+void ACharacterBase::BeginRagdollControl()
+{
+	bHasRagdollAsyncState = false;
+	URagdollBudgetSubsystem* RagdollBudget = GetWorld()->GetSubsystem<URagdollBudgetSubsystem>();
+	if (RagdollBudget == nullptr || !RagdollBudget->BeginAsyncControl(this, GetMesh(), RagdollMaxMotorSpring, RagdollMailbox))
+	{
+		RagdollMailbox.Reset();
+		return;
+	}
+	if (RagdollTier == ERagdollSimulationTier::Simplified)
+	{
+		RagdollBudget->SetAsyncMotorsEnabled(this, false);
+	}
+	if (!RagdollPhysicsCreatedHandle.IsValid())
+	{
+		RagdollPhysicsCreatedHandle = GetMesh()->RegisterOnPhysicsCreatedDelegate(
+			FOnSkelMeshPhysicsCreated::CreateUObject(this, &ACharacterBase::OnRagdollPhysicsCreated));
+	}
+}
+
+void ACharacterBase::EndRagdollControl()
+{
+	if (RagdollPhysicsCreatedHandle.IsValid())
+	{
+		if (IsValid(GetMesh()))
+		{
+			GetMesh()->UnregisterOnPhysicsCreatedDelegate(RagdollPhysicsCreatedHandle);
+		}
+		RagdollPhysicsCreatedHandle.Reset();
+	}
+	if (!RagdollMailbox.IsValid())
+	{
+		return;
+	}
+
+	if (URagdollBudgetSubsystem* RagdollBudget = GetWorld()->GetSubsystem<URagdollBudgetSubsystem>())
+	{
+		RagdollBudget->EndAsyncControl(this);
+	}
+	RagdollMailbox.Reset();
+	bHasRagdollAsyncState = false;
+}
+
+void ACharacterBase::OnRagdollPhysicsCreated()
+{
+	// 刚体重建后物理线程保存的代理已经失效，先移除旧的再用新的代理重新交给物理线程
+	if (!RagdollMailbox.IsValid())
+	{
+		return;
+	}
+	if (URagdollBudgetSubsystem* RagdollBudget = GetWorld()->GetSubsystem<URagdollBudgetSubsystem>())
+	{
+		RagdollBudget->EndAsyncControl(this);
+	}
+	BeginRagdollControl();
+}
+
+bool ACharacterBase::CheckRagdollSettled()
+{
+	const float SettleTime = CVarRagdollSettleTime.GetValueOnGameThread();
+	if (SettleTime <= 0.0f
+		|| !RagdollOnGround
+		|| LastRagdollVelocity.Size() > CVarRagdollSettleLinearSpeed.GetValueOnGameThread()
+		|| GetMesh()->GetPhysicsAngularVelocityInDegrees(FName("pelvis")).Size() > CVarRagdollSettleAngularSpeed.GetValueOnGameThread())
+	{
+		RagdollSettleStartTime = -1.0;
+		return false;
+	}
+
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+	if (RagdollSettleStartTime < 0.0)
+	{
+		RagdollSettleStartTime = CurrentTime;
+	}
+	return CurrentTime - RagdollSettleStartTime >= SettleTime;
+}
+
+void ACharacterBase::FreezeRagdollPose()
+{
+	if (bRagdollPoseFrozen)
+	{
+		return;
+	}
+
+	// 保存起身用的姿势快照，再停止骨骼更新和模拟，网格定格在最后一帧的物理姿势
+	bRagdollPoseFrozen = true;
+	if (IsValid(MainAnimInstance))
+	{
+		MainAnimInstance->SavePoseSnapshot(FName("RagdollPose"));
+	}
+	EndRagdollControl();
+	GetMesh()->bNoSkeletonUpdate = true;
+	GetMesh()->SetAllBodiesSimulatePhysics(false);
+}
+
+void ACharacterBase::ThawRagdollPose()
+{
+	if (!bRagdollPoseFrozen)
+	{
+		return;
+	}
+
+	bRagdollPoseFrozen = false;
+	GetMesh()->bNoSkeletonUpdate = false;
+	GetMesh()->SetAllBodiesBelowSimulatePhysics(FName("pelvis"), true, true);
+	BeginRagdollControl();
+}
+
+void ACharacterBase::OnRagdollMeshHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
+{
+	// 定格后只有被其他模拟物体或角色撞到才恢复
+	if ((IsValid(OtherComp) && OtherComp->IsSimulatingPhysics()) || Cast<APawn>(OtherActor) != nullptr)
+	{
+		WakeRagdoll();
+	}
+}
+
+void ACharacterBase::SelectRagdollPhysicsAsset()
+{
+	// 按离最近视点的距离选择物理资源LOD，远处的布娃娃用更少的刚体和约束
+	const UPhysicsAnimationAsset* ProfileAsset = IsValid(PhysicalAnimationProfiles) ? PhysicalAnimationProfiles->ProfileAsset.Get() : nullptr;
+	const URagdollBudgetSubsystem* RagdollBudget = GetWorld()->GetSubsystem<URagdollBudgetSubsystem>();
+	if (ProfileAsset == nullptr || RagdollBudget == nullptr || GetMesh()->GetPhysicsAsset() != ProfileAsset->PhysicsAsset)
+	{
+		return;
+	}
+
+	UPhysicsAsset* PhysicsAssetLOD = ProfileAsset->SelectPhysicsAssetLOD(RagdollBudget->GetViewDistance(this), WasRecentlyRendered(0.2f));
+	if (PhysicsAssetLOD != nullptr && PhysicsAssetLOD != GetMesh()->GetPhysicsAsset())
+	{
+		RagdollDefaultPhysicsAsset = GetMesh()->GetPhysicsAsset();
+		GetMesh()->SetPhysicsAsset(PhysicsAssetLOD);
+		// 约束按新资源的默认驱动重建，之前应用的配置已经不在了
+		PhysicalAnimationProfiles->InvalidateAppliedProfile();
+	}
+}
+
+void ACharacterBase::RestoreRagdollPhysicsAsset()
+{
+	if (RagdollDefaultPhysicsAsset != nullptr)
+	{
+		GetMesh()->SetPhysicsAsset(RagdollDefaultPhysicsAsset);
+		RagdollDefaultPhysicsAsset = nullptr;
+		if (IsValid(PhysicalAnimationProfiles))
+		{
+			PhysicalAnimationProfiles->InvalidateAppliedProfile();
+		}
+	}
+}
+
+bool ACharacterBase::PlayHitReaction(FName HitBoneName, FVector Impulse)
+{
+	USkeletalMeshComponent* MeshComponent = GetMesh();
+	if (!IsValid(MeshComponent))
+	{
+		return false;
+	}
+
+	// 已经是布娃娃时冲量直接作用在全身模拟上
+	if (Locomotion.MovementState == EMovementState::Ragdoll)
+	{
+		WakeRagdoll();
+		if (bRagdollPoseFrozen)
+		{
+			return false;
+		}
+		MeshComponent->AddImpulse(Impulse, HitBoneName);
+		return true;
+	}
+
+	const FName ChainRoot = FindHitReactionChainRoot(HitBoneName);
+	if (ChainRoot.IsNone())
+	{
+		return false;
+	}
+
+	if (ChainRoot != HitReactionChainRoot)
+	{
+		int32 NumBodies = 0;
+		for (const FBodyInstance* Body : MeshComponent->Bodies)
+		{
+			const FName BodyName = Body && Body->BodySetup.IsValid() ? Body->BodySetup->BoneName : NAME_None;
+			if (!BodyName.IsNone() && (BodyName == ChainRoot || MeshComponent->BoneIsChildOf(BodyName, ChainRoot)))
+			{
+				++NumBodies;
+			}
+		}
+
+		// 同一角色再次申请时替换之前的数量，失败时保留正在进行的受击反应
+		URagdollBudgetSubsystem* RagdollBudget = GetWorld()->GetSubsystem<URagdollBudgetSubsystem>();
+		if (RagdollBudget != nullptr && !RagdollBudget->AcquireHitReactionBodies(this, NumBodies))
+		{
+			return false;
+		}
+
+		if (IsPlayingHitReaction())
+		{
+			MeshComponent->SetAllBodiesBelowSimulatePhysics(HitReactionChainRoot, false, true);
+			MeshComponent->SetAllBodiesBelowPhysicsBlendWeight(HitReactionChainRoot, 1.0f, false, true);
+		}
+		if (IsValid(PhysicalAnimationProfiles))
+		{
+			PhysicalAnimationProfiles->ApplyProfile(HitReactionProfileName);
+		}
+		MeshComponent->SetAllBodiesBelowSimulatePhysics(ChainRoot, true, true);
+		HitReactionChainRoot = ChainRoot;
+	}
+
+	HitReactionElapsedTime = 0.0f;
+	MeshComponent->SetAllBodiesBelowPhysicsBlendWeight(ChainRoot, 1.0f, false, true);
+	// 受击骨骼没有刚体时作用在链根上
+	MeshComponent->AddImpulse(Impulse, MeshComponent->GetBodyInstance(HitBoneName) ? HitBoneName : ChainRoot);
+	return true;
+}
+
+FName ACharacterBase::FindHitReactionChainRoot(FName BoneName) const
+{
+	for (; !BoneName.IsNone(); BoneName = GetMesh()->GetParentBone(BoneName))
+	{
+		if (HitReactionChainRoots.Contains(BoneName))
+		{
+			return BoneName;
+		}
+	}
+	return NAME_None;
+}
+
+void ACharacterBase::UpdateHitReaction(float DeltaSeconds)
+{
+	if (!IsPlayingHitReaction())
+	{
+		return;
 	}
 
+	HitReactionElapsedTime += DeltaSeconds;
+	const float BlendOutAlpha = (HitReactionElapsedTime - HitReactionHoldTime) / FMath::Max(HitReactionBlendOutTime, KINDA_SMALL_NUMBER);
+	if (BlendOutAlpha >= 1.0f)
+	{
+		EndHitReaction();
+	}
+	else if (BlendOutAlpha > 0.0f)
+	{
+		GetMesh()->SetAllBodiesBelowPhysicsBlendWeight(HitReactionChainRoot, 1.0f - BlendOutAlpha, false, true);
+	}
+}
+
+void ACharacterBase::EndHitReaction()
+{
+	if (!IsPlayingHitReaction())
+	{
+		return;
+	}
+
+	// 混合权重恢复为1，之后进入布娃娃时整条链都完全由物理驱动
+	if (IsValid(GetMesh()))
+	{
+		GetMesh()->SetAllBodiesBelowSimulatePhysics(HitReactionChainRoot, false, true);
+		GetMesh()->SetAllBodiesBelowPhysicsBlendWeight(HitReactionChainRoot, 1.0f, false, true);
+	}
+	// 受击配置写的驱动不能留到布娃娃里，否则马达和异步控制驱动哪些关节取决于之前有没有受击
+	if (IsValid(PhysicalAnimationProfiles))
+	{
+		PhysicalAnimationProfiles->RestoreDefaultDrives();
+	}
+	if (URagdollBudgetSubsystem* RagdollBudget = GetWorld()->GetSubsystem<URagdollBudgetSubsystem>())
+	{
+		RagdollBudget->ReleaseHitReactionBodies(this);
+	}
+	HitReactionChainRoot = NAME_None;
+	HitReactionElapsedTime = 0.0f;
+}
+
+void ACharacterBase::RagdollUpdate()
+{
+	if (!IsValid(GetMesh()) || bRagdollPoseFrozen)
+	{
+		return;
+	}
+
+	// 简化模拟不驱动电机，并降低更新频率
+	if (RagdollTier == ERagdollSimulationTier::Simplified
+		&& (RagdollUpdateCounter++ % SimplifiedRagdollUpdateInterval) != 0)
+	{
+		return;
+	}
+	
+	if (RagdollMailbox.IsValid())
+	{
+		// 电机和重力已经在物理线程按子步更新，这里只取回最新的结果
+		bHasRagdollAsyncState |= RagdollMailbox->Consume(RagdollAsyncState);
+		LastRagdollVelocity = bHasRagdollAsyncState ? RagdollAsyncState.RootVelocity : GetMesh()->GetPhysicsLinearVelocity(FName("root"));
+	}
+	else
+	{
+		LastRagdollVelocity = GetMesh()->GetPhysicsLinearVelocity(FName("root"));
+		
+		if (RagdollTier == ERagdollSimulationTier::Full)
+		{
+			float Spring = UKismetMathLibrary::MapRangeClamped(LastRagdollVelocity.Length(),
+				0.0f, 1000.0f, 0.0f, RagdollMaxMotorSpring);
+			RagdollMotorDrive.SetSpring(Spring);
+		}
+
+		RagdollMotorDrive.SetGravityEnabled(LastRagdollVelocity.Z > -4000.0f);
+	}
+
+	SetActorLocationDuringRagdoll();
+
+	if (CheckRagdollSettled())
+	{
+		bRagdollSettled = true;
+		LastRagdollVelocity = FVector::ZeroVector;
+		FreezeRagdollPose();
+		bMeshNotifiedRigidBodyCollision = GetMesh()->BodyInstance.bNotifyRigidBodyCollision;
+		GetMesh()->SetNotifyRigidBodyCollision(true);
+		GetMesh()->OnComponentHit.AddUniqueDynamic(this, &ACharacterBase::OnRagdollMeshHit);
+	}
+}
+
+void ACharacterBase::RagdollEnd()
+{
+	ReleaseRagdoll();
+	
+	// step1, 定格时已经保存过姿势
+	if (IsValid(MainAnimInstance) && !bRagdollPoseFrozen)
+	{
+		MainAnimInstance->SavePoseSnapshot(FName("RagdollPose"));
+	}
+
+	// step2
+	if (IsValid(XXCharacterMovement))
+	{
+		if (RagdollOnGround)
+		{
+			XXCharacterMovement->SetMovementMode(EMovementMode::MOVE_Walking);
+			PlayLocomotionMontage(GetGetUpAnimation(RagdollFaceUp), 1.0f, 0.0f);
+		}
+		else
+		{
+			XXCharacterMovement->SetMovementMode(EMovementMode::MOVE_Falling);
+			XXCharacterMovement->Velocity = LastRagdollVelocity;
+		}
+	}
+
+	// step3
+	RestoreRagdollCollision();
+
 	UpdateHeldObject();
 }
 
+void ACharacterBase::ReleaseRagdoll()
+{
+	EndRagdollControl();
+	if (URagdollBudgetSubsystem* RagdollBudget = GetWorld()->GetSubsystem<URagdollBudgetSubsystem>())
+	{
+		RagdollBudget->UnregisterRagdoll(this);
+	}
+	
+	if (bRagdollSettled && IsValid(GetMesh()))
+	{
+		GetMesh()->SetNotifyRigidBodyCollision(bMeshNotifiedRigidBodyCollision);
+		GetMesh()->OnComponentHit.RemoveDynamic(this, &ACharacterBase::OnRagdollMeshHit);
+	}
+}
+
+void ACharacterBase::RestoreRagdollCollision()
+{
+	if (IsValid(GetCapsuleComponent()) && IsValid(GetMesh()))
+	{
+		GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::Type::QueryAndPhysics);
+		GetMesh()->SetCollisionObjectType(ECollisionChannel::ECC_Pawn);
+		GetMesh()->SetCollisionEnabled(ECollisionEnabled::Type::PhysicsOnly);
+		GetMesh()->SetAllBodiesSimulatePhysics(false);
+		GetMesh()->bNoSkeletonUpdate = false;
+		RestoreRagdollPhysicsAsset();
+	}
+	RagdollTier = ERagdollSimulationTier::Full;
+	RagdollMotorDrive.Reset();
+	bRagdollPoseFrozen = false;
+	bRagdollSettled = false;
+}
+
+void ACharacterBase::AbortRagdoll()
+{
+	// 不保存姿势也不播放起身蒙太奇，运动状态由调用方重置
+	if (Locomotion.MovementState != EMovementState::Ragdoll)
+	{
+		return;
+	}
+
+	ReleaseRagdoll();
+	RestoreRagdollCollision();
+	if (IsValid(GetMesh()))
+	{
+		GetMesh()->SetRelativeLocationAndRotation(GetBaseTranslationOffset(), GetBaseRotationOffset());
+	}
+	Locomotion.PreviousMovementState = Locomotion.MovementState;
+	Locomotion.MovementState = EMovementState::None;
+}
+
 UAnimMontage* ACharacterBase::GetGetUpAnimation(bool bRagdollFaceUp)
 {
-	UAnimMontage* ResultAnimMontage = nullptr;
-	switch (OverlayState)
+	return ResolveResidentMontage(SelectGetUpMontage(bRagdollFaceUp));
+}
+
+const TSoftObjectPtr<UAnimMontage>& ACharacterBase::SelectGetUpMontage(bool bRagdollFaceUp) const
+{
+	using FMontageMember = TSoftObjectPtr<UAnimMontage> UCharacterLocomotionConfig::*;
+	// [脸朝下, 脸朝上][手持类别]，箱子和双手被绑共用双手的起身动画
+	static constexpr FMontageMember GetUpMontages[2][LocomotionStateTables::NumOverlayHandGroups] =
 	{
-		// todo ,需要加载
-	case EOverlayState::Default:
-	case EOverlayState::Masculine:
-	case EOverlayState::Feminine:
-		ResultAnimMontage = bRagdollFaceUp ? GetUpBackDefault.Get() : GetUpFrontDefault.Get();
-		break;
-	case EOverlayState::Injured:
-	case EOverlayState::Bow:
-	case EOverlayState::Torch:
-	case EOverlayState::Barrel:
-		ResultAnimMontage = bRagdollFaceUp ? GetUpBackLH.Get() : GetUpFrontLH.Get();
-		break;
-	case EOverlayState::HandsTied:
-	case EOverlayState::Box:
-		ResultAnimMontage = bRagdollFaceUp ? GetUpBack2H.Get() : GetUpFront2H.Get();
-		break;
-	case EOverlayState::Rifle:
-	case EOverlayState::Pistol1H:
-	case EOverlayState::Pistol2H:
-	case EOverlayState::Binoculars:
-		ResultAnimMontage = bRagdollFaceUp ? GetUpBackRH.Get() : GetUpFrontRH.Get();
-		break;
+		{
+			&UCharacterLocomotionConfig::GetUpFrontDefault,
+			&UCharacterLocomotionConfig::GetUpFrontLH,
+			&UCharacterLocomotionConfig::GetUpFront2H,
+			&UCharacterLocomotionConfig::GetUpFrontRH,
+			&UCharacterLocomotionConfig::GetUpFront2H,
+		},
+		{
+			&UCharacterLocomotionConfig::GetUpBackDefault,
+			&UCharacterLocomotionConfig::GetUpBackLH,
+			&UCharacterLocomotionConfig::GetUpBack2H,
+			&UCharacterLocomotionConfig::GetUpBackRH,
+			&UCharacterLocomotionConfig::GetUpBack2H,
+		},
+	};
+	return GetLocomotionConfig().*GetUpMontages[bRagdollFaceUp ? 1 : 0][LocomotionStateTables::GetOverlayHandGroupIndex(OverlayState)];
+}
+
+void ACharacterBase::PlayLocomotionMontage(UAnimMontage* Montage, float PlayRate, float StartPosition)
+{
+	if (!IsValid(Montage) || !IsValid(MainAnimInstance))
+	{
+		return;
+	}
+
+	// 本地立即播放，其他端只收到ID，由共享的蒙太奇表解析
+	MainAnimInstance->Montage_Play(Montage, PlayRate, EMontagePlayReturnType::MontageLength, StartPosition);
+
+	const uint8 MontageId = IsValid(MontageRegistry) ? MontageRegistry->GetMontageId(Montage) : ULocomotionMontageRegistry::InvalidMontageId;
+	if (MontageId == ULocomotionMontageRegistry::InvalidMontageId)
+	{
+		UE_LOG(LogTemplateCharacter, Verbose, TEXT("'%s' montage %s is not registered and will not replicate"), *GetNameSafe(this), *GetNameSafe(Montage));
+		return;
+	}
+
+	const FLocomotionMontageStart MontageStart = FLocomotionMontageStart::Make(MontageId, PlayRate, StartPosition);
+	if (HasAuthority())
+	{
+		// 远端玩家控制的角色由其客户端上报后再转发(Landed等事件两端都会触发)，服务器这边只在本地播放
+		if (IsLocallyControlled() || !IsPlayerControlled())
+		{
+			MulticastPlayLocomotionMontage(MontageStart);
+		}
+	}
+	else if (IsLocallyControlled())
+	{
+		ServerPlayLocomotionMontage(MontageStart);
 	}
-	return ResultAnimMontage;
+}
+
+void ACharacterBase::PlayLocomotionMontageStart(const FLocomotionMontageStart& MontageStart)
+{
+	if (!MontageStart.IsValid() || !IsValid(MontageRegistry) || !IsValid(MainAnimInstance))
+	{
+		return;
+	}
+
+	// 还没加载完时计为一次未命中并跳过，不在收包时同步加载
+	UAnimMontage* Montage = ResolveResidentMontage(MontageRegistry->GetMontage(MontageStart.MontageId));
+	if (IsValid(Montage))
+	{
+		MainAnimInstance->Montage_Play(Montage, MontageStart.GetPlayRate(),
+			EMontagePlayReturnType::MontageLength, MontageStart.GetStartPosition());
+	}
+}
+
+bool ACharacterBase::ServerPlayLocomotionMontage_Validate(FLocomotionMontageStart MontageStart)
+{
+	// ID必须在共享表内，播放速率必须为正且不超过上限
+	return IsValid(MontageRegistry) && !MontageRegistry->GetMontage(MontageStart.MontageId).IsNull()
+		&& MontageStart.GetPlayRate() > 0.0f && MontageStart.GetPlayRate() <= FLocomotionMontageStart::MaxPlayRate;
+}
+
+void ACharacterBase::ServerPlayLocomotionMontage_Implementation(FLocomotionMontageStart MontageStart)
+{
+	// 客户端输入触发的翻滚和攀爬，服务器也要播放，根运动和移动才与客户端一致。
+	// Landed等两端都会触发的事件服务器已经自己播放过，不重新开始
+	const UAnimMontage* PlayingMontage = MontageRegistry->GetMontage(MontageStart.MontageId).Get();
+	if (!IsValid(MainAnimInstance) || !IsValid(PlayingMontage) || !MainAnimInstance->Montage_IsPlaying(PlayingMontage))
+	{
+		PlayLocomotionMontageStart(MontageStart);
+	}
+	MulticastPlayLocomotionMontage(MontageStart);
+}
+
+void ACharacterBase::MulticastPlayLocomotionMontage_Implementation(FLocomotionMontageStart MontageStart)
+{
+	// 服务器和本地控制端都已经自己播放过
+	if (HasAuthority() || GetLocalRole() == ROLE_AutonomousProxy)
+	{
+		return;
+	}
+	PlayLocomotionMontageStart(MontageStart);
 }
 
 void ACharacterBase::SetActorLocationDuringRagdoll()
@@ -1314,7 +2166,7 @@ void ACharacterBase::SetActorLocationDuringRagdoll()
 		return;
 	}
 
-	FVector TargetRagdollLocation = GetMesh()->GetSocketLocation(FName("pelvis"));
+	FVector TargetRagdollLocation = bHasRagdollAsyncState ? RagdollAsyncState.PelvisLocation : GetMesh()->GetSocketLocation(FName("pelvis"));
 	RagdollFaceUp = TargetRagdollLocation.X < 0.0f;
 	float Yaw = RagdollFaceUp ? TargetRagdollLocation.Z - 180.0f: TargetRagdollLocation.Z;
 	FRotator TargetRagdollRotation = FRotator(0.0, Yaw, 0.0f);
@@ -1325,6 +2177,11 @@ void ACharacterBase::SetActorLocationDuringRagdoll()
 		TargetRagdollLocation.Z - GetCapsuleComponent()->GetScaledCapsuleHalfHeight());
 	FHitResult HitResult;
 	GetWorld()->LineTraceSingleByChannel(HitResult, TargetRagdollLocation, TraceEnd, ECC_Visibility);
+	RagdollOnGround = HitResult.bBlockingHit;
+	if (HitResult.bBlockingHit)
+	{
+		FrameTraceFlags |= ELocomotionTraceFlags::RagdollGroundHit;
+	}
 	if (RagdollOnGround)
 	{
 		float NewLocationZ = GetCapsuleComponent()->GetScaledCapsuleHalfHeight() - 
@@ -1349,7 +2206,7 @@ bool ACharacterBase::SetLocationAndRotation(
 	bool bTeleport,
 	struct FHitResult& SweepHitResult)
 {
-	TargetRotation = NewRotation;
+	Locomotion.TargetRotation = NewRotation;
 	return K2_SetActorLocationAndRotation(NewLocation, NewRotation, bSweep, SweepHitResult, bTeleport);
 }
 
@@ -1387,43 +2244,18 @@ void ACharacterBase::GetControlVector(FVector& ForwardVector, FVector& RightVect
 
 void ACharacterBase::UpdateGroundedRotation()
 {
-	if (MovementAction == EMovementAction::None)
+	if (Locomotion.MovementAction == EMovementAction::None)
 	{
 		if (CanUpdateMovingRotation())
 		{
-			switch (RotationMode)
+			using FRotationHandler = void (ACharacterBase::*)();
+			static constexpr FRotationHandler MovingRotationHandlers[LocomotionStateTables::NumRotationModes] =
 			{
-			case ERotationMode::VelocityDirection:
-				SmoothCharacterRotation(
-					FRotator(0.0f, LastVelocityRotation.Yaw, 0.0f),
-					800,
-					CalculateGroundedRotationRate());
-				break;
-			case ERotationMode::LookingDirection:
-				if (Gait == EGait::Running || Gait == EGait::Walking)
-				{
-					float TargetYaw = GetControlRotation().Yaw + GetAnimCurveValue(FName("YawOffset"));
-					SmoothCharacterRotation(
-						FRotator(0, TargetYaw, 0),
-						500.0f,
-						CalculateGroundedRotationRate());
-				}
-				else if (Gait == EGait::Sprinting)
-				{
-					SmoothCharacterRotation(
-						FRotator(0, LastVelocityRotation.Yaw, 0),
-						500.0f,
-						CalculateGroundedRotationRate());
-				}
-				break;
-			case ERotationMode::Aiming:
-				SmoothCharacterRotation(
-						FRotator(0, GetControlRotation().Yaw, 0),
-						1000.0f,
-						20.0f);
-			default:
-				break;
-			}
+				&ACharacterBase::UpdateVelocityDirectionRotation,
+				&ACharacterBase::UpdateLookingDirectionRotation,
+				&ACharacterBase::UpdateAimingRotation,
+			};
+			(this->*MovingRotationHandlers[LocomotionStateTables::ToIndex(Locomotion.RotationMode)])();
 		}
 		else
 		{
@@ -1432,35 +2264,70 @@ void ACharacterBase::UpdateGroundedRotation()
 				float AnimCurve = GetAnimCurveValue(FName("RotationAmount"));
 				if (FMath::Abs(AnimCurve) > 0.001f)
 				{
-					float DeltaRotationYaw = UGameplayStatics::GetWorldDeltaSeconds(this) / (1.0f / 30.0f) * AnimCurve;
+					float DeltaRotationYaw = LocomotionDeltaSeconds / (1.0f / 30.0f) * AnimCurve;
 					AddActorWorldRotation(FRotator(0, DeltaRotationYaw, 0));
-					TargetRotation = GetActorRotation();
+					Locomotion.TargetRotation = GetActorRotation();
 				}
 			};
 			
 			if ((ViewMode == EViewMode::ThirdPerson &&
-				(RotationMode == ERotationMode::VelocityDirection || RotationMode == ERotationMode::LookingDirection)))
+				(Locomotion.RotationMode == ERotationMode::VelocityDirection || Locomotion.RotationMode == ERotationMode::LookingDirection)))
 			{
 				ApplyRotation();
 			}
 			
 			if (ViewMode == EViewMode::FirstPerson ||
-				(ViewMode == EViewMode::ThirdPerson && RotationMode == ERotationMode::Aiming))
+				(ViewMode == EViewMode::ThirdPerson && Locomotion.RotationMode == ERotationMode::Aiming))
 			{
 				LimitRotation(-100.0f, 100.0f, 20.0f);
 				ApplyRotation();
 			}
 		}
 	}
-	else if (MovementAction == EMovementAction::Rolling)
+	else if (Locomotion.MovementAction == EMovementAction::Rolling)
 	{
-		if (HasMovementInput)
+		if (Locomotion.HasMovementInput)
 		{
-			SmoothCharacterRotation(FRotator(0, LastMovementInputRotation.Yaw, 0), 0.0f, 2.0f);
+			SmoothCharacterRotation(FRotator(0, Locomotion.LastMovementInputRotation.Yaw, 0), 0.0f, 2.0f);
 		}
 	}
 }
 
+void ACharacterBase::UpdateVelocityDirectionRotation()
+{
+	SmoothCharacterRotation(
+		FRotator(0.0f, Locomotion.LastVelocityRotation.Yaw, 0.0f),
+		800,
+		CalculateGroundedRotationRate());
+}
+
+void ACharacterBase::UpdateLookingDirectionRotation()
+{
+	if (Locomotion.Gait == EGait::Sprinting)
+	{
+		SmoothCharacterRotation(
+			FRotator(0, Locomotion.LastVelocityRotation.Yaw, 0),
+			500.0f,
+			CalculateGroundedRotationRate());
+	}
+	else
+	{
+		float TargetYaw = GetControlRotation().Yaw + GetAnimCurveValue(FName("YawOffset"));
+		SmoothCharacterRotation(
+			FRotator(0, TargetYaw, 0),
+			500.0f,
+			CalculateGroundedRotationRate());
+	}
+}
+
+void ACharacterBase::UpdateAimingRotation()
+{
+	SmoothCharacterRotation(
+		FRotator(0, GetControlRotation().Yaw, 0),
+		1000.0f,
+		20.0f);
+}
+
 float ACharacterBase::GetAnimCurveValue(FName CurveName)
 {
 	if (IsValid(MainAnimInstance))
@@ -1484,99 +2351,35 @@ void ACharacterBase::LimitRotation(float AimYawMin, float AimYawMax, float Inter
 
 void ACharacterBase::SmoothCharacterRotation(FRotator InTargetRotation, float TargetInterpSpeed, float ActorInterpSpeed)
 {
-	TargetRotation = UKismetMathLibrary::RInterpTo_Constant(
-		TargetRotation, InTargetRotation, UGameplayStatics::GetWorldDeltaSeconds(this), TargetInterpSpeed);
+	Locomotion.TargetRotation = UKismetMathLibrary::RInterpTo_Constant(
+		Locomotion.TargetRotation, InTargetRotation, LocomotionDeltaSeconds, TargetInterpSpeed);
 	FRotator ActorRotation = UKismetMathLibrary::RInterpTo(
-		GetActorRotation(), TargetRotation, UGameplayStatics::GetWorldDeltaSeconds(this), ActorInterpSpeed);
+		GetActorRotation(), Locomotion.TargetRotation, LocomotionDeltaSeconds, ActorInterpSpeed);
 	SetActorRotation(ActorRotation);
 }
 
 float ACharacterBase::CalculateGroundedRotationRate()
 {
 	return CurrentMovementSettings.RotationRateCurve->GetFloatValue(GetMappedSpeed()) *
-		UKismetMathLibrary::MapRangeClamped(AimYawRate, 0.0f, 300.0f, 1.0f, 3.0f);
+		UKismetMathLibrary::MapRangeClamped(Locomotion.AimYawRate, 0.0f, 300.0f, 1.0f, 3.0f);
 }
 
 EGait ACharacterBase::GetAllowedGait() const
 {
-	if (Stance == EStance::Standing &&
-		(RotationMode == ERotationMode::LookingDirection || RotationMode == ERotationMode::VelocityDirection))
-	{
-		switch (DesiredGait)
-		{
-		case EGait::Walking:
-		case EGait::Running:
-			return EGait::Running;
-		case EGait::Sprinting:
-			return CanSprint() ? EGait::Sprinting : EGait::Running;
-		default:
-			break;
-		}
-	}
-
-	if ((Stance == EStance::Standing && RotationMode == ERotationMode::Aiming) ||
-		(Stance == EStance::Crouching))
-	{
-		switch (DesiredGait)
-		{
-		case EGait::Walking:
-		case EGait::Running:
-			return EGait::Running;
-		case EGait::Sprinting:
-			return EGait::Running;
-		default:
-			break;
-		}
-	}
-	return EGait::Walking;
+	const EGait AllowedGait = LocomotionStateTables::GetAllowedGait(Locomotion.Stance, Locomotion.RotationMode, DesiredGait);
+	return AllowedGait == EGait::Sprinting && !CanSprint() ? EGait::Running : AllowedGait;
 }
 
 EGait ACharacterBase::GetActualGait(EGait InAllowedGait) const
 {
-	if (Speed >= CurrentMovementSettings.RunSpeed + 10.0f)
-	{
-		switch (InAllowedGait)
-		{
-		case EGait::Walking:
-		case EGait::Running:
-			return EGait::Running;
-		case EGait::Sprinting:
-			return EGait::Sprinting;
-		default:
-			break;
-		}
-	}
-	else
-	{
-		if (Speed >= CurrentMovementSettings.WalkSpeed + 10)
-		{
-			return EGait::Running;
-		}
-		else
-		{
-			return EGait::Walking;
-		}
-	}
-	return EGait::Walking;
+	return LocomotionMath::ActualGait(Locomotion.Speed, CurrentMovementSettings.WalkSpeed, CurrentMovementSettings.RunSpeed, InAllowedGait);
 }
 
 void ACharacterBase::UpdateDynamicMovementSettings(EGait InAllowedGait)
 {
 	CurrentMovementSettings = GetTargetMovementSettings();
 	
-	float DesiredWalkSpeed = 0.0;
-	switch (InAllowedGait)
-	{
-	case EGait::Walking:
-		DesiredWalkSpeed = CurrentMovementSettings.WalkSpeed;
-		break;
-	case EGait::Running:
-		DesiredWalkSpeed = CurrentMovementSettings.RunSpeed;
-		break;
-	case EGait::Sprinting:
-		DesiredWalkSpeed = CurrentMovementSettings.SprintSpeed;
-		break;
-	}
+	const float DesiredWalkSpeed = CurrentMovementSettings.*LocomotionStateTables::GaitSpeeds[LocomotionStateTables::ToIndex(InAllowedGait)];
 	XXCharacterMovement->MaxWalkSpeed = DesiredWalkSpeed;
 	XXCharacterMovement->MaxWalkSpeedCrouched = DesiredWalkSpeed;
 	
@@ -1586,75 +2389,35 @@ void ACharacterBase::UpdateDynamicMovementSettings(EGait InAllowedGait)
 	XXCharacterMovement->GroundFriction = CurveValue.Z;
 }
 
-FMovementSettings ACharacterBase::GetTargetMovementSettings() const
+const FMovementSettings& ACharacterBase::GetTargetMovementSettings() const
 {
-	switch (RotationMode)
-	{
-	case ERotationMode::VelocityDirection:
-		switch (Stance)
-		{
-		case EStance::Standing:
-			return MovementData.VelocityDirection.Standing;
-		case EStance::Crouching:
-			return MovementData.VelocityDirection.Standing;
-		default:
-			break;
-		}
-	case ERotationMode::LookingDirection:
-		switch (Stance)
-		{
-		case EStance::Standing:
-			return MovementData.LookingDirection.Standing;
-		case EStance::Crouching:
-			return MovementData.LookingDirection.Standing;
-		default:
-			break;
-		}
-	case ERotationMode::Aiming:
-		switch (Stance)
-		{
-		case EStance::Standing:
-			return MovementData.LookingDirection.Standing;
-		case EStance::Crouching:
-			return MovementData.LookingDirection.Standing;
-		default:
-			break;
-		}
-	}
+	using namespace LocomotionStateTables;
+	return MovementData.*RotationModeSettings[ToIndex(Locomotion.RotationMode)].*StanceSettings[ToIndex(Locomotion.Stance)];
 }
 
 float ACharacterBase::GetMappedSpeed() const
 {
-	float ClampedWalkSpeed = UKismetMathLibrary::MapRangeClamped(
-		Speed, 0.0f, CurrentMovementSettings.WalkSpeed,0.0, 1.0);
-	float ClampedRunSpeed = UKismetMathLibrary::MapRangeClamped(
-		Speed, CurrentMovementSettings.WalkSpeed, CurrentMovementSettings.RunSpeed,1.0, 2.0);
-	float ClampedSprintSpeed = UKismetMathLibrary::MapRangeClamped(
-		Speed, CurrentMovementSettings.RunSpeed, CurrentMovementSettings.SprintSpeed, 2.0, 3.0);
-
-	float MappedSpeed = Speed > CurrentMovementSettings.WalkSpeed ? ClampedRunSpeed : ClampedWalkSpeed;
-	MappedSpeed =  Speed > CurrentMovementSettings.RunSpeed ? ClampedSprintSpeed : MappedSpeed;
-	return MappedSpeed;
+	return LocomotionMath::MappedSpeed(Locomotion.Speed, CurrentMovementSettings.WalkSpeed, CurrentMovementSettings.RunSpeed, CurrentMovementSettings.SprintSpeed);
 }
 
 bool ACharacterBase::CanUpdateMovingRotation()
 {
-	return ((IsMoving && HasMovementInput) || (Speed > 150.0)) && !HasAnyRootMotion(); 
+	return ((Locomotion.IsMoving && Locomotion.HasMovementInput) || (Locomotion.Speed > 150.0)) && !HasAnyRootMotion(); 
 }
 
 bool ACharacterBase::CanSprint() const
 {
-	if (HasMovementInput)
+	if (Locomotion.HasMovementInput)
 	{
-		switch (RotationMode)
+		switch (Locomotion.RotationMode)
 		{
 		case ERotationMode::VelocityDirection:
-			return MovementInputAmount > 0.9f;
+			return Locomotion.MovementInputAmount > 0.9f;
 		case ERotationMode::LookingDirection:
 			{
 				FRotator Rotator = XXCharacterMovement->GetCurrentAcceleration().Rotation() - GetControlRotation();
 				Rotator.Normalize();
-				return MovementInputAmount > 0.9f && FMath::Abs(Rotator.Yaw) < 50;
+				return Locomotion.MovementInputAmount > 0.9f && FMath::Abs(Rotator.Yaw) < 50;
 			}
 		case ERotationMode::Aiming:
 			return false;
@@ -1667,33 +2430,33 @@ bool ACharacterBase::CanSprint() const
 
 void ACharacterBase::OnGaitChanged(EGait NewGait)
 {
-	PreviousActualGait = Gait;
-	Gait = NewGait;
+	Locomotion.PreviousActualGait = Locomotion.Gait;
+	Locomotion.Gait = NewGait;
 }
 
 void ACharacterBase::OnMovementStateChanged(EMovementState NewMovementState)
 {
-	PreviousMovementState = MovementState;
-	MovementState = NewMovementState;
+	Locomotion.PreviousMovementState = Locomotion.MovementState;
+	Locomotion.MovementState = NewMovementState;
 	
-	if (MovementState == EMovementState::InAir)
+	if (Locomotion.MovementState == EMovementState::InAir)
 	{
-		if (MovementAction == EMovementAction::None)
+		if (Locomotion.MovementAction == EMovementAction::None)
 		{
-			InAirRotation = GetActorRotation();
-			if (Stance == EStance::Crouching)
+			Locomotion.InAirRotation = GetActorRotation();
+			if (Locomotion.Stance == EStance::Crouching)
 			{
 				UnCrouch();
 			}
 		}
-		else if (MovementAction == EMovementAction::Rolling)
+		else if (Locomotion.MovementAction == EMovementAction::Rolling)
 		{
 			RagdollStart();
 		}
 	}
-	else if (MovementState == EMovementState::Ragdoll)
+	else if (Locomotion.MovementState == EMovementState::Ragdoll)
 	{
-		if (PreviousMovementState == EMovementState::Mantling)
+		if (Locomotion.PreviousMovementState == EMovementState::Mantling)
 		{
 			if (IsValid(MantleTimeline))
 			{
@@ -1705,15 +2468,15 @@ void ACharacterBase::OnMovementStateChanged(EMovementState NewMovementState)
 
 void ACharacterBase::OnMovementActionChanged(EMovementAction NewMovementAction)
 {
-	PreviousMovementAction = MovementAction;
-	MovementAction = NewMovementAction;
+	Locomotion.PreviousMovementAction = Locomotion.MovementAction;
+	Locomotion.MovementAction = NewMovementAction;
 
-	if (MovementAction == EMovementAction::Rolling)
+	if (Locomotion.MovementAction == EMovementAction::Rolling)
 	{
 		Crouch();
 	}
 	
-	if (PreviousMovementAction == EMovementAction::Rolling)
+	if (Locomotion.PreviousMovementAction == EMovementAction::Rolling)
 	{
 		if (DesiredStance == EStance::Standing)
 		{
@@ -1738,12 +2501,12 @@ void ACharacterBase::BPIGetCurrentStates(
 	EOverlayState& OutOverlayState)
 {
 	OutPawnMovementMode = XXCharacterMovement->MovementMode;
-	OutMovementState = MovementState;
-	OutPrevMovementState = PreviousMovementState;
-	OutMovementAction = MovementAction;
-	OutRotationMode = RotationMode;
-	OutActualGait = Gait;
-	OutActualStance = Stance,
+	OutMovementState = Locomotion.MovementState;
+	OutPrevMovementState = Locomotion.PreviousMovementState;
+	OutMovementAction = Locomotion.MovementAction;
+	OutRotationMode = Locomotion.RotationMode;
+	OutActualGait = Locomotion.Gait;
+	OutActualStance = Locomotion.Stance,
 	OutViewMode = ViewMode;
 	OutOverlayState = OverlayState;
 }
@@ -1760,19 +2523,30 @@ void ACharacterBase::BPIGetEssentialValues(
 	float& OutAimYawRate)
 {
 	OutVelocity = GetVelocity();
-	OutAcceleration = Acceleration;
 	OutMovementInput = XXCharacterMovement->GetCurrentAcceleration();
-	OutIsMoving = IsMoving;
-	OutHasMovementInput = HasMovementInput;
-	OutSpeed = Speed;
-	OutMovementInputAmount = MovementInputAmount;
+	OutIsMoving = Locomotion.IsMoving;
+	OutHasMovementInput = Locomotion.HasMovementInput;
 	OutAimingRotation = GetControlRotation();
-	OutAimYawRate = AimYawRate;
+	// 固定步长模拟时在最近两步之间插值，避免动画混合值按模拟频率跳变
+	if (LocomotionStepAlpha < 1.0f)
+	{
+		OutAcceleration = FMath::Lerp(PreviousStepAcceleration, Locomotion.Acceleration, LocomotionStepAlpha);
+		OutSpeed = FMath::Lerp(PreviousStepSpeed, Locomotion.Speed, LocomotionStepAlpha);
+		OutMovementInputAmount = FMath::Lerp(PreviousStepMovementInputAmount, Locomotion.MovementInputAmount, LocomotionStepAlpha);
+		OutAimYawRate = FMath::Lerp(PreviousStepAimYawRate, Locomotion.AimYawRate, LocomotionStepAlpha);
+	}
+	else
+	{
+		OutAcceleration = Locomotion.Acceleration;
+		OutSpeed = Locomotion.Speed;
+		OutMovementInputAmount = Locomotion.MovementInputAmount;
+		OutAimYawRate = Locomotion.AimYawRate;
+	}
 }
 
 void ACharacterBase::BPISetMovementState(EMovementState NewMovementState)
 {
-	if (NewMovementState != MovementState)
+	if (NewMovementState != Locomotion.MovementState)
 	{
 		OnMovementStateChanged(NewMovementState);
 	}
@@ -1780,7 +2554,7 @@ void ACharacterBase::BPISetMovementState(EMovementState NewMovementState)
 
 void ACharacterBase::BPISetMovementAction(EMovementAction NewMovementAction)
 {
-	if (NewMovementAction != MovementAction)
+	if (NewMovementAction != Locomotion.MovementAction)
 	{
 		OnMovementActionChanged(NewMovementAction);
 	}
@@ -1788,7 +2562,7 @@ void ACharacterBase::BPISetMovementAction(EMovementAction NewMovementAction)
 
 void ACharacterBase::BPISetRotationMode(ERotationMode NewRotationMode)
 {
-	if (NewRotationMode != RotationMode)
+	if (NewRotationMode != Locomotion.RotationMode)
 	{
 		OnRotationModeChanged(NewRotationMode);
 	}
@@ -1796,7 +2570,7 @@ void ACharacterBase::BPISetRotationMode(ERotationMode NewRotationMode)
 
 void ACharacterBase::BPISetGait(EGait NewGait)
 {
-	if (NewGait != Gait)
+	if (NewGait != Locomotion.Gait)
 	{
 		OnGaitChanged(NewGait);
 	}
@@ -1832,10 +2606,7 @@ FTransform ACharacterBase::BPIGet3PPivotTarget()
 	FTransform ResultTransform;
 	if (IsValid(GetMesh()))
 	{
-		TArray<FVector> Locations;
-		Locations.Add(GetMesh()->GetSocketLocation(FName("head")));
-		Locations.Add(GetMesh()->GetSocketLocation(FName("root")));
-		FVector AverageLocation = UKismetMathLibrary::GetVectorArrayAverage(Locations);
+		FVector AverageLocation = (GetMesh()->GetSocketLocation(FName("head")) + GetMesh()->GetSocketLocation(FName("root"))) * 0.5f;
 		ResultTransform = FTransform(GetActorRotation(), AverageLocation, FVector::OneVector);
 	}
 	return ResultTransform;
@@ -1845,7 +2616,7 @@ void ACharacterBase::BPIGet3PTraceParams(FVector& TraceOrigin, float& TraceRadiu
 {
 	if (IsValid(GetMesh()))
 	{
-		if (RightShoulder)
+		if (Locomotion.RightShoulder)
 		{
 			TraceOrigin = GetMesh()->GetSocketLocation(FName("TP_CameraTrace_R"));
 		}
@@ -1858,37 +2629,286 @@ void ACharacterBase::BPIGet3PTraceParams(FVector& TraceOrigin, float& TraceRadiu
 	TraceChannel = ETraceTypeQuery::TraceTypeQuery1;
 }
 
+void ACharacterBase::TakeLocomotionSnapshot(FLocomotionSnapshot& OutSnapshot) const
+{
+	FCharacterLocomotionSnapshot& Snapshot = OutSnapshot.Character;
+	Snapshot.MovementMode = XXCharacterMovement->MovementMode;
+	Snapshot.MovementState = Locomotion.MovementState;
+	Snapshot.PreviousMovementState = Locomotion.PreviousMovementState;
+	Snapshot.MovementAction = Locomotion.MovementAction;
+	Snapshot.PreviousMovementAction = Locomotion.PreviousMovementAction;
+	Snapshot.RotationMode = Locomotion.RotationMode;
+	Snapshot.DesiredRotationMode = DesiredRotationMode;
+	Snapshot.Gait = Locomotion.Gait;
+	Snapshot.AllowedGait = Locomotion.AllowedGait;
+	Snapshot.ActualGait = Locomotion.ActualGait;
+	Snapshot.PreviousActualGait = Locomotion.PreviousActualGait;
+	Snapshot.DesiredGait = DesiredGait;
+	Snapshot.Stance = Locomotion.Stance;
+	Snapshot.PreviousStance = Locomotion.PreviousStance;
+	Snapshot.DesiredStance = DesiredStance;
+	Snapshot.ViewMode = ViewMode;
+	Snapshot.OverlayState = OverlayState;
+	Snapshot.RightShoulder = Locomotion.RightShoulder;
+	Snapshot.IsMoving = Locomotion.IsMoving;
+	Snapshot.HasMovementInput = Locomotion.HasMovementInput;
+	Snapshot.RagdollFaceUp = RagdollFaceUp;
+	Snapshot.RagdollOnGround = RagdollOnGround;
+	Snapshot.BreakFall = Locomotion.BreakFall;
+	Snapshot.Speed = Locomotion.Speed;
+	Snapshot.MovementInputAmount = Locomotion.MovementInputAmount;
+	Snapshot.PreviousAimYaw = Locomotion.PreviousAimYaw;
+	Snapshot.AimYawRate = Locomotion.AimYawRate;
+	Snapshot.Velocity = XXCharacterMovement->Velocity;
+	Snapshot.Acceleration = Locomotion.Acceleration;
+	Snapshot.PreviousVelocity = Locomotion.PreviousVelocity;
+	Snapshot.LastRagdollVelocity = LastRagdollVelocity;
+	Snapshot.TargetRotation = Locomotion.TargetRotation;
+	Snapshot.LastVelocityRotation = Locomotion.LastVelocityRotation;
+	Snapshot.LastMovementInputRotation = Locomotion.LastMovementInputRotation;
+	Snapshot.InAirRotation = Locomotion.InAirRotation;
+
+	Snapshot.MantleMontageId = IsValid(MontageRegistry) ? MontageRegistry->GetMontageId(MantleParams.AnimMontage) : ULocomotionMontageRegistry::InvalidMontageId;
+	Snapshot.MantleStartingPosition = MantleParams.StartingPosition;
+	Snapshot.MantlePlayRate = MantleParams.PlayRate;
+	Snapshot.MantleLowHeight = MantleParams.LowHeight;
+	Snapshot.MantleStartingOffset = MantleParams.StartingOffset;
+	Snapshot.MantleTarget = MantleTarget;
+	Snapshot.MantleActualStartOffset = MantleActualStartOffset;
+	Snapshot.MantleAnimatedStartOffset = MantleAnimatedStartOffset;
+	Snapshot.MantleLedgeComponent = MantleLedgeLS.Component;
+	Snapshot.MantleTimelineLength = IsValid(TimelineComponent) ? TimelineComponent->GetTimelineLength() : 0.0f;
+	Snapshot.MantleTimelinePosition = IsValid(TimelineComponent) ? TimelineComponent->GetPlaybackPosition() : 0.0f;
+	Snapshot.MantleMontagePosition = IsValid(MainAnimInstance) && IsValid(MantleParams.AnimMontage)
+		? MainAnimInstance->Montage_GetPosition(MantleParams.AnimMontage) : MantleParams.StartingPosition;
+
+	OutSnapshot.bHasAnimSnapshot = IsValid(MainAnimInstance);
+	if (OutSnapshot.bHasAnimSnapshot)
+	{
+		MainAnimInstance->TakeLocomotionSnapshot(OutSnapshot.Anim);
+	}
+}
+
+void ACharacterBase::ApplyLocomotionSnapshot(const FLocomotionSnapshot& InSnapshot)
+{
+	const UCharacterLocomotionConfig& Config = GetLocomotionConfig();
+	const FCharacterLocomotionSnapshot& Snapshot = InSnapshot.Character;
+
+	// 姿态需要走Crouch/UnCrouch调整胶囊体，下面再直接覆盖状态值
+	if (Snapshot.Stance != Locomotion.Stance)
+	{
+		if (Snapshot.Stance == EStance::Crouching)
+		{
+			Crouch();
+		}
+		else
+		{
+			UnCrouch();
+		}
+	}
+
+	if (XXCharacterMovement->MovementMode != Snapshot.MovementMode)
+	{
+		XXCharacterMovement->SetMovementMode(Snapshot.MovementMode);
+	}
+	XXCharacterMovement->Velocity = Snapshot.Velocity;
+
+	Locomotion.MovementState = Snapshot.MovementState;
+	Locomotion.PreviousMovementState = Snapshot.PreviousMovementState;
+	Locomotion.MovementAction = Snapshot.MovementAction;
+	Locomotion.PreviousMovementAction = Snapshot.PreviousMovementAction;
+	Locomotion.RotationMode = Snapshot.RotationMode;
+	DesiredRotationMode = Snapshot.DesiredRotationMode;
+	Locomotion.Gait = Snapshot.Gait;
+	Locomotion.AllowedGait = Snapshot.AllowedGait;
+	Locomotion.ActualGait = Snapshot.ActualGait;
+	Locomotion.PreviousActualGait = Snapshot.PreviousActualGait;
+	DesiredGait = Snapshot.DesiredGait;
+	Locomotion.Stance = Snapshot.Stance;
+	Locomotion.PreviousStance = Snapshot.PreviousStance;
+	DesiredStance = Snapshot.DesiredStance;
+	ViewMode = Snapshot.ViewMode;
+	Locomotion.RightShoulder = Snapshot.RightShoulder;
+	Locomotion.IsMoving = Snapshot.IsMoving;
+	Locomotion.HasMovementInput = Snapshot.HasMovementInput;
+	RagdollFaceUp = Snapshot.RagdollFaceUp;
+	RagdollOnGround = Snapshot.RagdollOnGround;
+	Locomotion.BreakFall = Snapshot.BreakFall;
+	Locomotion.Speed = Snapshot.Speed;
+	Locomotion.MovementInputAmount = Snapshot.MovementInputAmount;
+	Locomotion.PreviousAimYaw = Snapshot.PreviousAimYaw;
+	Locomotion.AimYawRate = Snapshot.AimYawRate;
+	Locomotion.Acceleration = Snapshot.Acceleration;
+	Locomotion.PreviousVelocity = Snapshot.PreviousVelocity;
+	LastRagdollVelocity = Snapshot.LastRagdollVelocity;
+	Locomotion.TargetRotation = Snapshot.TargetRotation;
+	Locomotion.LastVelocityRotation = Snapshot.LastVelocityRotation;
+	Locomotion.LastMovementInputRotation = Snapshot.LastMovementInputRotation;
+	Locomotion.InAirRotation = Snapshot.InAirRotation;
+
+	if (OverlayState != Snapshot.OverlayState)
+	{
+		OnOverlayStateChanged(Snapshot.OverlayState);
+	}
+
+	if (Locomotion.MovementState == EMovementState::Mantling)
+	{
+		MantleParams.AnimMontage = IsValid(MontageRegistry) ? ResolveResidentMontage(MontageRegistry->GetMontage(Snapshot.MantleMontageId)) : nullptr;
+		for (const FMantleAsset* MantleAsset : { &Config.Mantle2mDefault, &Config.Mantle1mDefault, &Config.Mantle1mLH, &Config.Mantle1m2H, &Config.Mantle1mRH, &Config.Mantle1mBox })
+		{
+			if (MantleAsset->AnimMontage == MantleParams.AnimMontage)
+			{
+				MantleParams.PositionCurve = MantleAsset->PositionCurve;
+				break;
+			}
+		}
+		MantleParams.StartingPosition = Snapshot.MantleStartingPosition;
+		MantleParams.PlayRate = Snapshot.MantlePlayRate;
+		MantleParams.LowHeight = Snapshot.MantleLowHeight;
+		MantleParams.StartingOffset = Snapshot.MantleStartingOffset;
+		MantleTarget = Snapshot.MantleTarget;
+		MantleActualStartOffset = Snapshot.MantleActualStartOffset;
+		MantleAnimatedStartOffset = Snapshot.MantleAnimatedStartOffset;
+		MantleLedgeLS.Transform = MantleTarget;
+		MantleLedgeLS.Component = Snapshot.MantleLedgeComponent.Get();
+
+		// 时间线和蒙太奇从保存时的位置继续，否则角色停在攀爬状态却没有东西推动
+		if (IsValid(TimelineComponent))
+		{
+			TimelineComponent->SetTimelineLength(Snapshot.MantleTimelineLength);
+			TimelineComponent->SetPlayRate(MantleParams.PlayRate);
+			TimelineComponent->SetPlaybackPosition(Snapshot.MantleTimelinePosition, false);
+			TimelineComponent->Play();
+		}
+		// 回滚只恢复本地状态，不再同步给其他端
+		if (IsValid(MainAnimInstance) && IsValid(MantleParams.AnimMontage))
+		{
+			MainAnimInstance->Montage_Play(MantleParams.AnimMontage, MantleParams.PlayRate,
+				EMontagePlayReturnType::MontageLength, Snapshot.MantleMontagePosition);
+		}
+	}
+	else
+	{
+		// 从攀爬中途回滚到攀爬之前
+		if (IsValid(TimelineComponent))
+		{
+			TimelineComponent->Stop();
+		}
+		if (IsValid(MainAnimInstance) && IsValid(MantleParams.AnimMontage) && MainAnimInstance->Montage_IsPlaying(MantleParams.AnimMontage))
+		{
+			MainAnimInstance->Montage_Stop(0.0f, MantleParams.AnimMontage);
+		}
+	}
+
+	if (InSnapshot.bHasAnimSnapshot && IsValid(MainAnimInstance))
+	{
+		MainAnimInstance->ApplyLocomotionSnapshot(InSnapshot.Anim);
+	}
+}
+
+void ACharacterBase::ResetForReuse(const FTransform& SpawnTransform)
+{
+	AbortRagdoll();
+	EndHitReaction();
+	// 攀爬由TimelineComponent驱动
+	if (IsValid(TimelineComponent))
+	{
+		TimelineComponent->Stop();
+	}
+	if (IsValid(MainAnimInstance))
+	{
+		MainAnimInstance->Montage_Stop(0.0f);
+	}
+
+	SetActorLocationAndRotation(SpawnTransform.GetLocation(), SpawnTransform.Rotator(), false, nullptr, ETeleportType::ResetPhysics);
+	XXCharacterMovement->StopMovementImmediately();
+
+	// 生成时的朝向取自当时的位置，换成新的出生点
+	FLocomotionSnapshot Snapshot = SpawnLocomotionSnapshot;
+	const FRotator SpawnRotation = SpawnTransform.Rotator();
+	Snapshot.Character.TargetRotation = SpawnRotation;
+	Snapshot.Character.LastVelocityRotation = SpawnRotation;
+	Snapshot.Character.LastMovementInputRotation = SpawnRotation;
+	Snapshot.Character.InAirRotation = SpawnRotation;
+	ApplyLocomotionSnapshot(Snapshot);
+	XXCharacterMovement->SetDefaultMovementMode();
+
+	LocomotionStepAccumulator = 0.0f;
+	LocomotionRateSeconds = 0.0f;
+	LocomotionStepAlpha = 1.0f;
+	PreviousStepRotation = SpawnTransform.GetRotation();
+	CurrentStepRotation = PreviousStepRotation;
+	InterpolatedRotation = PreviousStepRotation;
+	PreviousStepAcceleration = FVector::ZeroVector;
+	PreviousStepSpeed = 0.0f;
+	PreviousStepMovementInputAmount = 0.0f;
+	PreviousStepAimYawRate = 0.0f;
+	RecordedMoveInput = FVector2D::ZeroVector;
+	RecordedLookInput = FVector2D::ZeroVector;
+
+	if (IsValid(GetMesh()))
+	{
+		GetMesh()->ResetAnimInstanceDynamics(ETeleportType::ResetPhysics);
+	}
+	UpdateHeldObject();
+}
+
+void ACharacterBase::SetPooledActive(bool bActive)
+{
+	if (!bActive)
+	{
+		StopLocomotionRecording();
+		AbortRagdoll();
+		EndHitReaction();
+		ReleaseHeldObject();
+		bHeldObjectPending = false;
+		XXCharacterMovement->StopMovementImmediately();
+	}
+
+	SetActorHiddenInGame(!bActive);
+	SetActorEnableCollision(bActive);
+	SetActorTickEnabled(bActive);
+	XXCharacterMovement->SetComponentTickEnabled(bActive);
+	if (IsValid(GetMesh()))
+	{
+		GetMesh()->SetComponentTickEnabled(bActive);
+	}
+	if (IsValid(BodyMesh))
+	{
+		BodyMesh->SetComponentTickEnabled(bActive);
+	}
+}
+
 void ACharacterBase::OnStartCrouch(float HalfHeightAdjust, float ScaledHalfHeightAdjust)
 {
 	Super::OnStartCrouch(HalfHeightAdjust, ScaledHalfHeightAdjust);
 	
-	PreviousStance = Stance;
-	Stance = EStance::Crouching;
+	Locomotion.PreviousStance = Locomotion.Stance;
+	Locomotion.Stance = EStance::Crouching;
+	UpdateResidentMontages();
 }
 
 void ACharacterBase::OnEndCrouch(float HalfHeightAdjust, float ScaledHalfHeightAdjust)
 {
 	Super::OnEndCrouch(HalfHeightAdjust, ScaledHalfHeightAdjust);
 	
-	PreviousStance = Stance;
-	Stance = EStance::Standing;
+	Locomotion.PreviousStance = Locomotion.Stance;
+	Locomotion.Stance = EStance::Standing;
+	UpdateResidentMontages();
 }
 
 void ACharacterBase::Landed(const FHitResult& Hit)
 {
 	Super::Landed(Hit);
 
-	if (BreakFall)
+	if (Locomotion.BreakFall)
 	{
 		// Breakfall Event
-		if (IsValid(MainAnimInstance))
-		{
-			MainAnimInstance->Montage_Play(GetRollAnimation(), 1.35f);
-		}
+		PlayLocomotionMontage(GetRollAnimation(), 1.35f, 0.0f);
 	}
 	else
 	{
-		XXCharacterMovement->BrakingFrictionFactor = HasMovementInput ? 0.5f : 3.0f;
+		XXCharacterMovement->BrakingFrictionFactor = Locomotion.HasMovementInput ? 0.5f : 3.0f;
 		FLatentActionInfo LatentInfo;
 		UKismetSystemLibrary::RetriggerableDelay(this, 0.5f, LatentInfo);
 		// todo, 上面的函数完成后才执行下面的内容
@@ -1898,7 +2918,7 @@ void ACharacterBase::Landed(const FHitResult& Hit)
 
 void ACharacterBase::OnJumped_Implementation()
 {
-	InAirRotation = Speed > 100.0f ? LastVelocityRotation : GetActorRotation();
+	Locomotion.InAirRotation = Locomotion.Speed > 100.0f ? Locomotion.LastVelocityRotation : GetActorRotation();
 	if (IsValid(MainAnimInstance))
 	{
 		MainAnimInstance->BPIJumped();
@@ -1907,39 +2927,25 @@ void ACharacterBase::OnJumped_Implementation()
 
 UAnimMontage* ACharacterBase::GetRollAnimation()
 {
-	UAnimMontage* ResultAnimMontage = nullptr;
-	switch (OverlayState)
-	{
-	// todo ,需要加载
-	case EOverlayState::Default:
-	case EOverlayState::Masculine:
-	case EOverlayState::Feminine:
-		ResultAnimMontage = LandRollDefault.Get();
-	break;
-	case EOverlayState::Injured:
-	case EOverlayState::Bow:
-	case EOverlayState::Torch:
-	case EOverlayState::Barrel:
-		ResultAnimMontage = LandRollLH.Get();
-		break;
-	case EOverlayState::HandsTied:
-	case EOverlayState::Box:
-		ResultAnimMontage = LandRollRH.Get();
-		break;
-	case EOverlayState::Rifle:
-	case EOverlayState::Pistol1H:
-	case EOverlayState::Pistol2H:
-	case EOverlayState::Binoculars:
-		ResultAnimMontage = LandRollRH.Get();
-		break;
-	}
-	return ResultAnimMontage;
+	return ResolveResidentMontage(SelectRollMontage());
 }
 
-void ACharacterBase::RollEvent()
+const TSoftObjectPtr<UAnimMontage>& ACharacterBase::SelectRollMontage() const
 {
-	if (IsValid(MainAnimInstance))
+	using FMontageMember = TSoftObjectPtr<UAnimMontage> UCharacterLocomotionConfig::*;
+	// 翻滚没有双手和箱子的版本，用右手的
+	static constexpr FMontageMember RollMontages[LocomotionStateTables::NumOverlayHandGroups] =
 	{
-		MainAnimInstance->Montage_Play(GetRollAnimation(), 1.15f);
-	}
+		&UCharacterLocomotionConfig::LandRollDefault,
+		&UCharacterLocomotionConfig::LandRollLH,
+		&UCharacterLocomotionConfig::LandRollRH,
+		&UCharacterLocomotionConfig::LandRollRH,
+		&UCharacterLocomotionConfig::LandRollRH,
+	};
+	return GetLocomotionConfig().*RollMontages[LocomotionStateTables::GetOverlayHandGroupIndex(OverlayState)];
+}
+
+void ACharacterBase::RollEvent()
+{
+	PlayLocomotionMontage(GetRollAnimation(), 1.15f, 0.0f);
 }
\ No newline at end of file
@@ -6,6 +6,11 @@
 #include "XXCharacterMovementComponent.h"
 #include "AnimationProject/Common/CommonInterfaces.h"
 #include "AnimationProject/Locomotion/LocomotionDefine.h"
+#include "AnimationProject/Locomotion/LocomotionMontageRegistry.h"
+#include "AnimationProject/Locomotion/LocomotionRecorder.h"
+#include "AnimationProject/Locomotion/LocomotionSnapshot.h"
+#include "AnimationProject/Physics/RagdollBudgetSubsystem.h"
+#include "AnimationProject/Physics/RagdollMotorDrive.h"
 #include "Components/TimelineComponent.h"
 #include "GameFramework/Character.h"
 #include "Kismet/KismetSystemLibrary.h"
@@ -17,11 +22,55 @@ class UCameraComponent;
 class UInputMappingContext;
 class UInputAction;
 class UTimelineComponent;
+class UPhysicsAnimationProfileComponent;
+class ULocomotionStreamingSourceComponent;
+class UPhysicsAsset;
+class UHeldObjectSet;
+class UCharacterLocomotionConfig;
 struct FInputActionValue;
 class UAnimInstanceBase;
+struct FFullLocomotionFeatures;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTemplateCharacter, Log, All);
 
+/**
+ * ACharacterBase每帧读写的运动状态，按成员大小排列避免填充，并按缓存行对齐。
+ * 添加成员时注意不要超出下面static_assert限制的大小，不常用的数据放在ACharacterBase或UCharacterLocomotionConfig中。
+ */
+struct alignas(PLATFORM_CACHE_LINE_SIZE) FCharacterLocomotionState
+{
+	FVector Acceleration = FVector::ZeroVector;
+	FVector PreviousVelocity = FVector::ZeroVector;
+	FRotator TargetRotation = FRotator::ZeroRotator;
+	FRotator LastVelocityRotation = FRotator::ZeroRotator;
+	FRotator LastMovementInputRotation = FRotator::ZeroRotator;
+	FRotator InAirRotation = FRotator::ZeroRotator;
+
+	float Speed = 0.0f;
+	float MovementInputAmount = 0.0f;
+	float PreviousAimYaw = 0.0f;
+	float AimYawRate = 0.0f;
+
+	EMovementState MovementState = EMovementState::None;
+	EMovementState PreviousMovementState = EMovementState::None;
+	EMovementAction MovementAction = EMovementAction::None;
+	EMovementAction PreviousMovementAction = EMovementAction::None;
+	ERotationMode RotationMode = ERotationMode::VelocityDirection;
+	EStance Stance = EStance::Standing;
+	EStance PreviousStance = EStance::Standing;
+	EGait AllowedGait = EGait::Walking;
+	EGait ActualGait = EGait::Walking;
+	EGait PreviousActualGait = EGait::Running;
+	EGait Gait = EGait::Walking;
+
+	bool IsMoving = false;
+	bool HasMovementInput = false;
+	bool RightShoulder = false;
+	bool BreakFall = false;
+};
+static_assert(sizeof(FCharacterLocomotionState) <= 3 * PLATFORM_CACHE_LINE_SIZE, "FCharacterLocomotionState is read every tick and must stay within three cache lines");
+static_assert(alignof(FCharacterLocomotionState) == PLATFORM_CACHE_LINE_SIZE, "FCharacterLocomotionState must start on a cache line");
+
 UCLASS(config=Game)
 class ACharacterBase : public ACharacter, public ICharacterInterface, public ICameraInterface
 {
@@ -74,9 +123,27 @@ protected:
 	// To add mapping context
 	virtual void BeginPlay();
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void NotifyControllerChanged() override;
+
+	void AddDefaultMappingContext();
+
 private:
 	UPROPERTY(Category=Character, VisibleAnywhere, BlueprintReadOnly, meta=(AllowPrivateAccess = "true"))
 	TObjectPtr<USkeletalMeshComponent> BodyMesh;
+
+	// 受击反应用的物理动画配置，配置资源在蓝图中设置
+	UPROPERTY(Category=Character, VisibleAnywhere, BlueprintReadOnly, meta=(AllowPrivateAccess = "true"))
+	TObjectPtr<UPhysicsAnimationProfileComponent> PhysicalAnimationProfiles;
+
+	// 按预测轨迹提前请求World Partition单元格
+	UPROPERTY(Category=Character, VisibleAnywhere, BlueprintReadOnly, meta=(AllowPrivateAccess = "true"))
+	TObjectPtr<ULocomotionStreamingSourceComponent> StreamingSource;
+
+	// 布娃娃期间换成的简化物理资源，结束时恢复
+	UPROPERTY(Transient)
+	TObjectPtr<UPhysicsAsset> RagdollDefaultPhysicsAsset;
 	
 public:
 	virtual void Tick(float DeltaSeconds) override;
@@ -108,43 +175,69 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	EOverlayState OverlayState = EOverlayState::Default;
 
+	// 运动模拟的固定频率，0表示每帧更新。朝向和动画用到的值在两步之间插值
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (ClampMin = "0"))
+	float LocomotionFixedStepHz = 0.0f;
+
+	// 攀爬、翻滚、起身蒙太奇的ID表，所有端必须使用同一份
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	TObjectPtr<ULocomotionMontageRegistry> MontageRegistry = nullptr;
+
+	// 攀爬参数、起身和翻滚蒙太奇、着色等同一类角色共享的配置，为空时使用默认值
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	TObjectPtr<const UCharacterLocomotionConfig> LocomotionConfig = nullptr;
+
+	// 每个OverlayState手持的物品，资源和组件由UHeldObjectPool在所有角色间共享
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	TObjectPtr<UHeldObjectSet> HeldObjects = nullptr;
+
+	// 局部受击反应可以模拟的骨骼链，从受击骨骼向上找到的第一个链根骨骼以下的刚体参与模拟
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = HitReaction)
+	TArray<FName> HitReactionChainRoots = { FName("spine_02"), FName("upperarm_l"), FName("upperarm_r") };
+
+	// PhysicalAnimationProfiles中受击反应使用的配置
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = HitReaction)
+	FName HitReactionProfileName = FName("HitReaction");
+
+	// 完全由物理驱动的时间，之后在HitReactionBlendOutTime内混合回动画姿势
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = HitReaction, meta = (ClampMin = "0"))
+	float HitReactionHoldTime = 0.1f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = HitReaction, meta = (ClampMin = "0.01"))
+	float HitReactionBlendOutTime = 0.4f;
+
 protected:
 	UPROPERTY(BlueprintReadOnly)
 	TObjectPtr<UXXCharacterMovementComponent> XXCharacterMovement;
 	
 private:
+	// 每帧更新的运动状态放在一起，其余成员只在状态切换、攀爬、布娃娃时访问
+	FCharacterLocomotionState Locomotion;
+
 	FMovementSettingsState MovementData;
 	FMovementSettings CurrentMovementSettings;
-	ERotationMode RotationMode = ERotationMode::VelocityDirection;
-	FRotator TargetRotation = FRotator::ZeroRotator;
-	FRotator LastVelocityRotation = FRotator::ZeroRotator;
-	FRotator LastMovementInputRotation = FRotator::ZeroRotator;
-	FRotator InAirRotation = FRotator::ZeroRotator;
-	EMovementState MovementState = EMovementState::None;
-	EMovementState  PreviousMovementState = EMovementState::None;
-	EStance Stance = EStance::Standing;
-	EStance PreviousStance = EStance::Standing;
-	EGait AllowedGait = EGait::Walking;
-	EGait ActualGait = EGait::Walking;
-	EGait PreviousActualGait = EGait::Running;
-	EGait Gait = EGait::Walking;
-	EMovementAction MovementAction = EMovementAction::None;
-	EMovementAction PreviousMovementAction = EMovementAction::None;
 	FMantleTraceSettings FallingTraceSettings;
 	FMantleTraceSettings GroundedTraceSettings;
-	bool RightShoulder = false;
-
-	FVector Acceleration = FVector::ZeroVector;
-	FVector PreviousVelocity = FVector::ZeroVector;
-	float Speed = 0.0f;
-	bool IsMoving = false;
-	float MovementInputAmount = 0.0f;
-	bool HasMovementInput = false;
-	float PreviousAimYaw = 0.0f;
-	float AimYawRate = 0.0f;
 	FVector LastRagdollVelocity = FVector::ZeroVector;
 	bool RagdollFaceUp = false;
 	bool RagdollOnGround = false;
+	ERagdollSimulationTier RagdollTier = ERagdollSimulationTier::Full;
+	uint32 RagdollUpdateCounter = 0;
+	FRagdollMotorDrive RagdollMotorDrive;
+	// 物理线程控制布娃娃时的结果信箱，为空表示由游戏线程控制
+	TSharedPtr<FRagdollAsyncMailbox, ESPMode::ThreadSafe> RagdollMailbox;
+	FRagdollAsyncState RagdollAsyncState;
+	bool bHasRagdollAsyncState = false;
+	// 物理线程控制期间网格刚体重建时重新发送刚体代理
+	FDelegateHandle RagdollPhysicsCreatedHandle;
+	bool bRagdollPoseFrozen = false;
+	bool bRagdollSettled = false;
+	bool bMeshNotifiedRigidBodyCollision = false;
+	double RagdollSettleStartTime = -1.0;
+	static constexpr uint32 SimplifiedRagdollUpdateInterval = 4;
+	static constexpr float RagdollMaxMotorSpring = 25000.0f;
+	FName HitReactionChainRoot = NAME_None;
+	float HitReactionElapsedTime = 0.0f;
 	FMantleParams MantleParams;
 	FComponentAndTransform MantleLedgeLS;
 	FTransform MantleTarget;
@@ -152,25 +245,35 @@ private:
 	FTransform MantleAnimatedStartOffset;
 	UTimelineComponent* TimelineComponent = nullptr;
 	UTimelineComponent* MantleTimeline = nullptr;
-	bool BreakFall = false;
 	float LookUpDownRate = 0.0f;
 	float LookLeftRightRate = 0.0f;
 
-private:
-	TSoftObjectPtr<UAnimMontage> GetUpBackDefault;
-	TSoftObjectPtr<UAnimMontage> GetUpBackLH;
-	TSoftObjectPtr<UAnimMontage> GetUpBack2H;
-	TSoftObjectPtr<UAnimMontage> GetUpBackRH;
-	
-	TSoftObjectPtr<UAnimMontage> GetUpFrontDefault;
-	TSoftObjectPtr<UAnimMontage> GetUpFrontLH;
-	TSoftObjectPtr<UAnimMontage> GetUpFrontRH;
-	TSoftObjectPtr<UAnimMontage> GetUpFront2H;
-
-	TSoftObjectPtr<UAnimMontage> LandRollDefault;
-	TSoftObjectPtr<UAnimMontage> LandRollLH;
-	TSoftObjectPtr<UAnimMontage> LandRollRH;
-	TSoftObjectPtr<UAnimMontage> LandRoll2H;
+	// BeginPlay结束时的运动状态，角色池重置时使用
+	FLocomotionSnapshot SpawnLocomotionSnapshot;
+
+	TSharedPtr<FLocomotionRecorder, ESPMode::ThreadSafe> LocomotionRecorder;
+	ELocomotionTraceFlags FrameTraceFlags = ELocomotionTraceFlags::None;
+	// 攀爬检测和空间检测每帧复用，忽略自身
+	FCollisionQueryParams TraceQueryParams;
+	FVector2D RecordedMoveInput = FVector2D::ZeroVector;
+	FVector2D RecordedLookInput = FVector2D::ZeroVector;
+
+	// BeginPlay按配置重新选择，在那之前Tick(如基准测试或子类先于Super::BeginPlay驱动)使用完整特性
+	void (ACharacterBase::*TickFunction)(float) = &ACharacterBase::TickWithFeatures<FFullLocomotionFeatures>;
+
+	static constexpr int32 MaxLocomotionStepsPerFrame = 4;
+	float LocomotionDeltaSeconds = 0.0f;
+	float LocomotionStepAccumulator = 0.0f;
+	// 距上一次模拟步的实际时间，加速度和瞄准转速按它计算
+	float LocomotionRateSeconds = 0.0f;
+	float LocomotionStepAlpha = 1.0f;
+	FQuat PreviousStepRotation = FQuat::Identity;
+	FQuat CurrentStepRotation = FQuat::Identity;
+	FQuat InterpolatedRotation = FQuat::Identity;
+	FVector PreviousStepAcceleration = FVector::ZeroVector;
+	float PreviousStepSpeed = 0.0f;
+	float PreviousStepMovementInputAmount = 0.0f;
+	float PreviousStepAimYawRate = 0.0f;
 
 public:
 	virtual void BPIGetCurrentStates(
@@ -203,6 +306,42 @@ public:
 	virtual FTransform BPIGet3PPivotTarget() override;
 	virtual void BPIGet3PTraceParams(FVector& TraceOrigin, float& TraceRadius, TEnumAsByte<ETraceTypeQuery>& TraceChannel) override;
 
+	// 运动状态快照，用于回滚、快速重生和回放跳转
+	void TakeLocomotionSnapshot(FLocomotionSnapshot& OutSnapshot) const;
+	void ApplyLocomotionSnapshot(const FLocomotionSnapshot& Snapshot);
+
+	// LocomotionConfig为空时返回类默认对象
+	const UCharacterLocomotionConfig& GetLocomotionConfig() const;
+	// 调试界面打开ShowTraces时返回ShowTraceType，否则为None
+	EDrawDebugTrace::Type GetTraceDebugType(EDrawDebugTrace::Type ShowTraceType);
+
+	// 由UCharacterPool调用：回到BeginPlay结束时的运动状态并移动到SpawnTransform，不重建组件
+	void ResetForReuse(const FTransform& SpawnTransform);
+	// 放回角色池时停止更新、隐藏并关闭碰撞，布娃娃、受击反应和手持物品直接结束
+	void SetPooledActive(bool bActive);
+
+	// 逐帧录制运动数据到二进制文件，见FLocomotionRecordReader
+	void StartLocomotionRecording(const FString& Filename);
+	void StopLocomotionRecording();
+	bool IsRecordingLocomotion() const { return LocomotionRecorder.IsValid(); }
+
+	// 把录制的输入直接送给输入处理函数，用于无本地玩家的回放和基准测试
+	void ReplayLocomotionInput(const FVector2D& MoveValue, const FVector2D& LookValue, bool bJumpPressed);
+
+	// 由URagdollBudgetSubsystem分配，只在布娃娃状态下生效
+	void SetRagdollSimulationTier(ERagdollSimulationTier NewTier);
+	ERagdollSimulationTier GetRagdollSimulationTier() const { return RagdollTier; }
+
+	// 布娃娃静止后会定格姿势并停止模拟，受到外力或碰撞时调用以恢复模拟
+	void WakeRagdoll();
+	bool IsRagdollSettled() const { return bRagdollSettled; }
+
+	// 只模拟受击骨骼所在的骨骼链，物理动画驱动其跟随动画并逐渐混合回动画姿势。
+	// 没有匹配的骨骼链或超出URagdollBudgetSubsystem的刚体预算时返回false
+	UFUNCTION(BlueprintCallable, Category = HitReaction)
+	bool PlayHitReaction(FName HitBoneName, FVector Impulse);
+	bool IsPlayingHitReaction() const { return !HitReactionChainRoot.IsNone(); }
+
 protected:
 	virtual void OnStartCrouch(float HalfHeightAdjust, float ScaledHalfHeightAdjust) override;
 	virtual void OnEndCrouch(float HalfHeightAdjust, float ScaledHalfHeightAdjust) override;
@@ -214,27 +353,11 @@ private:
 	void UpdateHeldObjectAnimations();
 	void UpdateHeldObject();
 	void ClearHeldObject();
-	void AttachToHand(UStaticMesh* StaticMesh, USkeletalMesh* SkeletalMesh, UClass* NewAnimClass, bool LeftHand, FVector Offset);
+	void ReleaseHeldObject();
 	void UpdateLayeringColors();
 	void SetDynamicMaterials();
 	void SetAndResetColors();
 
-	bool SolidColor = false;
-	uint8 ShirtType = 0;
-	uint8 PantsType = 0;
-	bool Shoes = false;
-	bool Gloves = false;
-	FLinearColor DefaultColor;
-	FLinearColor SkinColor;
-	FLinearColor ShirtColor;
-	FLinearColor PantsColor;
-	FLinearColor ShoesColor;
-	FLinearColor GlovesColor;
-	FLinearColor OverlayLayerColor;
-	FLinearColor AdditiveAmountColor;
-	FLinearColor BaseLayerColor;
-	FLinearColor HandColor;
-	FLinearColor HandIKColor;
 	UMaterialInstanceDynamic* Head = nullptr;
 	UMaterialInstanceDynamic* Torso = nullptr;
 	UMaterialInstanceDynamic* Pelvis = nullptr;
@@ -250,16 +373,12 @@ private:
 	UMaterialInstanceDynamic* LowerLegs = nullptr;
 	UMaterialInstanceDynamic* Feet = nullptr;
 	
-	FMantleAsset Mantle2mDefault;
-	FMantleAsset Mantle1mDefault;
-	FMantleAsset Mantle1mLH;
-	FMantleAsset Mantle1m2H;
-	FMantleAsset Mantle1mRH;
-	FMantleAsset Mantle1mBox;
-
-	UStaticMeshComponent* StaticMeshComponent = nullptr;
-	USkeletalMeshComponent* SkeletalMeshComponent = nullptr;
-	USceneComponent* HeldObjectRoot = nullptr;
+	// 当前手持物品的组件，从UHeldObjectPool取出，换OverlayState时归还
+	UPROPERTY(Transient)
+	TObjectPtr<UPrimitiveComponent> HeldObject;
+	EOverlayState HeldObjectItem = EOverlayState::Default;
+	bool bHeldObjectPending = false;
+	bool bHeldObjectHidden = false;
 
 private:
 	void OnGaitChanged(EGait NewGait);
@@ -274,22 +393,47 @@ private:
 	void OnMovementStateChanged(EMovementState NewMovementState);
 	void OnMovementActionChanged(EMovementAction NewMovementAction);
 	
-	void SetEssentialValues();
+	float GetLocomotionFixedStepHz() const;
+	// 以下按LocomotionFeatures.h中的特性策略实例化，由BeginPlay按LocomotionConfig->FeatureSet选择
+	template <typename Features>
+	void TickWithFeatures(float DeltaSeconds);
+	template <typename Features>
+	void TickLocomotionFixedStep(float DeltaSeconds, float StepSeconds);
+	/**
+	 * FrameSeconds只在本帧最后一步为本帧模拟的总时间，其余补的步为0。
+	 * 空中攀爬检测、布娃娃同步和录制只在最后一步执行，补的步之间移动和物理没有前进，重复执行只会得到相同的结果
+	 */
+	template <typename Features>
+	void TickLocomotion(float StepSeconds, float RateSeconds, float FrameSeconds);
+	/** RateSeconds为0时沿用上一步的加速度和瞄准转速 */
+	void SetEssentialValues(float RateSeconds);
 	void CacheValues();
+	void RecordLocomotionFrame(float DeltaSeconds);
 	void DrawDebugShapes();
 	
 	void UpdateCharacterMovement();
 	void UpdateGroundedRotation();
+	// 按RotationMode查表调用，见UpdateGroundedRotation和UpdateInAirRotation
+	void UpdateVelocityDirectionRotation();
+	void UpdateLookingDirectionRotation();
+	void UpdateAimingRotation();
+	void UpdateInAirVelocityRotation();
+	void UpdateInAirAimingRotation();
 	float GetAnimCurveValue(FName CurveName);
 	void LimitRotation(float AimYawMin, float AimYawMax, float InterpSpeed);
 	bool CanUpdateMovingRotation();
 	void SmoothCharacterRotation(FRotator InTargetRotation, float TargetInterpSpeed, float ActorInterpSpeed);
 	void UpdateInAirRotation();
-	bool MantleCheck(FMantleTraceSettings TraceSettings, EDrawDebugTrace::Type DebugType);
+	bool MantleCheck(const FMantleTraceSettings& TraceSettings, EDrawDebugTrace::Type DebugType);
 	void MantleStart(float MantleHeight, FComponentAndTransform MantleLedgeWS, EMantleType MantleType);
 	void MantleEnd();
-	FMantleAsset GetMantleAsset(EMantleType MantleType);
-	EDrawDebugTrace::Type GetTraceDebugType(EDrawDebugTrace::Type ShowTraceType);
+	const FMantleAsset& GetMantleAsset(EMantleType MantleType) const;
+
+	// 按当前OverlayState和姿态登记需要常驻的起身、翻滚、攀爬蒙太奇
+	void UpdateResidentMontages();
+	/** 蒙太奇由另一端选择并只同步ID：模拟代理，以及服务器上由远端玩家控制的角色 */
+	bool IsMontageSelectedRemotely() const;
+	UAnimMontage* ResolveResidentMontage(const TSoftObjectPtr<UAnimMontage>& Montage);
 	FVector GetCapsuleLocationFromBase(FVector BaseLocation, float ZOffset);
 	bool CapsuleHasRoomCheck(
 		UCapsuleComponent* CapsuleComp,
@@ -300,7 +444,24 @@ private:
 	void RagdollStart();
 	void RagdollUpdate();
 	void RagdollEnd();
+	void ReleaseRagdoll();
+	void RestoreRagdollCollision();
+	void AbortRagdoll();
 	void SetActorLocationDuringRagdoll();
+	void BeginRagdollControl();
+	void EndRagdollControl();
+	void OnRagdollPhysicsCreated();
+	bool CheckRagdollSettled();
+	void FreezeRagdollPose();
+	void ThawRagdollPose();
+	void SelectRagdollPhysicsAsset();
+	void RestoreRagdollPhysicsAsset();
+	FName FindHitReactionChainRoot(FName BoneName) const;
+	void UpdateHitReaction(float DeltaSeconds);
+	void EndHitReaction();
+
+	UFUNCTION()
+	void OnRagdollMeshHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
 	bool SetLocationAndRotation(
 		FVector NewLocation,
 		FRotator NewRotation,
@@ -315,13 +476,24 @@ private:
 	EGait GetActualGait(EGait InAllowedGait) const;
 	void UpdateDynamicMovementSettings(EGait InAllowedGait);
 	bool CanSprint() const;
-	FMovementSettings GetTargetMovementSettings() const;
+	const FMovementSettings& GetTargetMovementSettings() const;
 	float GetMappedSpeed() const;
 	UAnimMontage* GetRollAnimation();
+	const TSoftObjectPtr<UAnimMontage>& SelectRollMontage() const;
 	void RollEvent();
 	void FixDiagonalGamepadValues(float InX, float InY, float& OutX, float& OutY);
 	
 	UAnimMontage* GetGetUpAnimation(bool bRagdollFaceUp);
+	const TSoftObjectPtr<UAnimMontage>& SelectGetUpMontage(bool bRagdollFaceUp) const;
+
+	void PlayLocomotionMontage(UAnimMontage* Montage, float PlayRate, float StartPosition);
+	void PlayLocomotionMontageStart(const FLocomotionMontageStart& MontageStart);
+
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerPlayLocomotionMontage(FLocomotionMontageStart MontageStart);
+
+	UFUNCTION(NetMulticast, Reliable)
+	void MulticastPlayLocomotionMontage(FLocomotionMontageStart MontageStart);
 
 #pragma endregion Locomotion
 };
@@ -0,0 +1,190 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "AnimationProject/Locomotion/LocomotionDefine.h"
+#include "CharacterLocomotionConfig.generated.h"
+
+class UAnimMontage;
+class UAnimSequenceBase;
+class UCurveFloat;
+class UCurveVector;
+
+/**
+ * ACharacterBase和UAnimInstanceBase中只读且同一类角色相同的配置，所有实例通过指针共享一份，
+ * 修改后对所有角色立即生效。
+ */
+UCLASS(BlueprintType)
+class UCharacterLocomotionConfig : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	// 关闭的特性在更新路径中被编译掉，NPC原型用Slim
+	UPROPERTY(EditDefaultsOnly, Category = Features)
+	ELocomotionFeatureSet FeatureSet = ELocomotionFeatureSet::Full;
+
+	UPROPERTY(EditDefaultsOnly, Category = Mantle)
+	FMantleAsset Mantle2mDefault;
+	UPROPERTY(EditDefaultsOnly, Category = Mantle)
+	FMantleAsset Mantle1mDefault;
+	UPROPERTY(EditDefaultsOnly, Category = Mantle)
+	FMantleAsset Mantle1mLH;
+	UPROPERTY(EditDefaultsOnly, Category = Mantle)
+	FMantleAsset Mantle1m2H;
+	UPROPERTY(EditDefaultsOnly, Category = Mantle)
+	FMantleAsset Mantle1mRH;
+	UPROPERTY(EditDefaultsOnly, Category = Mantle)
+	FMantleAsset Mantle1mBox;
+
+	// 起身和翻滚蒙太奇由ULocomotionMontageResidency按当前OverlayState提前加载
+	UPROPERTY(EditDefaultsOnly, Category = Montage)
+	TSoftObjectPtr<UAnimMontage> GetUpBackDefault;
+	UPROPERTY(EditDefaultsOnly, Category = Montage)
+	TSoftObjectPtr<UAnimMontage> GetUpBackLH;
+	UPROPERTY(EditDefaultsOnly, Category = Montage)
+	TSoftObjectPtr<UAnimMontage> GetUpBack2H;
+	UPROPERTY(EditDefaultsOnly, Category = Montage)
+	TSoftObjectPtr<UAnimMontage> GetUpBackRH;
+
+	UPROPERTY(EditDefaultsOnly, Category = Montage)
+	TSoftObjectPtr<UAnimMontage> GetUpFrontDefault;
+	UPROPERTY(EditDefaultsOnly, Category = Montage)
+	TSoftObjectPtr<UAnimMontage> GetUpFrontLH;
+	UPROPERTY(EditDefaultsOnly, Category = Montage)
+	TSoftObjectPtr<UAnimMontage> GetUpFrontRH;
+	UPROPERTY(EditDefaultsOnly, Category = Montage)
+	TSoftObjectPtr<UAnimMontage> GetUpFront2H;
+
+	UPROPERTY(EditDefaultsOnly, Category = Montage)
+	TSoftObjectPtr<UAnimMontage> LandRollDefault;
+	UPROPERTY(EditDefaultsOnly, Category = Montage)
+	TSoftObjectPtr<UAnimMontage> LandRollLH;
+	UPROPERTY(EditDefaultsOnly, Category = Montage)
+	TSoftObjectPtr<UAnimMontage> LandRollRH;
+	UPROPERTY(EditDefaultsOnly, Category = Montage)
+	TSoftObjectPtr<UAnimMontage> LandRoll2H;
+
+	// 调试着色
+	UPROPERTY(EditDefaultsOnly, Category = Coloring)
+	bool SolidColor = false;
+	UPROPERTY(EditDefaultsOnly, Category = Coloring)
+	uint8 ShirtType = 0;
+	UPROPERTY(EditDefaultsOnly, Category = Coloring)
+	uint8 PantsType = 0;
+	UPROPERTY(EditDefaultsOnly, Category = Coloring)
+	bool Shoes = false;
+	UPROPERTY(EditDefaultsOnly, Category = Coloring)
+	bool Gloves = false;
+	UPROPERTY(EditDefaultsOnly, Category = Coloring)
+	FLinearColor DefaultColor;
+	UPROPERTY(EditDefaultsOnly, Category = Coloring)
+	FLinearColor SkinColor;
+	UPROPERTY(EditDefaultsOnly, Category = Coloring)
+	FLinearColor ShirtColor;
+	UPROPERTY(EditDefaultsOnly, Category = Coloring)
+	FLinearColor PantsColor;
+	UPROPERTY(EditDefaultsOnly, Category = Coloring)
+	FLinearColor ShoesColor;
+	UPROPERTY(EditDefaultsOnly, Category = Coloring)
+	FLinearColor GlovesColor;
+	UPROPERTY(EditDefaultsOnly, Category = Coloring)
+	FLinearColor OverlayLayerColor;
+	UPROPERTY(EditDefaultsOnly, Category = Coloring)
+	FLinearColor AdditiveAmountColor;
+	UPROPERTY(EditDefaultsOnly, Category = Coloring)
+	FLinearColor BaseLayerColor;
+	UPROPERTY(EditDefaultsOnly, Category = Coloring)
+	FLinearColor HandColor;
+	UPROPERTY(EditDefaultsOnly, Category = Coloring)
+	FLinearColor HandIKColor;
+
+	// 以下由UAnimInstanceBase使用
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|Movement")
+	float TriggerRivotSpeedLimit = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|Movement")
+	float AnimatedWalkSpeed = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|Movement")
+	float AnimatedRunSpeed = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|Movement")
+	float AnimatedSprintSpeed = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|Movement")
+	float AnimatedCrouchSpeed = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|Movement")
+	float VelocityBlendInterpSpeed = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|Movement")
+	float GroundedLeanInterpSpeed = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|Movement")
+	TObjectPtr<UCurveFloat> DiagonalScaleAmountCurve = nullptr;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|Movement")
+	TObjectPtr<UCurveFloat> StrideBlendNWalk = nullptr;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|Movement")
+	TObjectPtr<UCurveFloat> StrideBlendNRun = nullptr;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|Movement")
+	TObjectPtr<UCurveFloat> StrideBlendCWalk = nullptr;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|Movement")
+	TObjectPtr<UCurveVector> YawOffsetFB = nullptr;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|Movement")
+	TObjectPtr<UCurveVector> YawOffsetLR = nullptr;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|Aiming")
+	float SmoothedAimingRotationInterpSpeed = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|Aiming")
+	float InputYawOffsetInterpSpeed = 8.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|InAir")
+	float InAirLeanInterpSpeed = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|InAir")
+	TObjectPtr<UCurveFloat> LeanInAirCurve = nullptr;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|InAir")
+	TObjectPtr<UCurveFloat> LandPredictionCurve = nullptr;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|FootIK")
+	float IKTraceDistanceAboveFoot = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|FootIK")
+	float IKTraceDistanceBelowFoot = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|FootIK")
+	float FootHeight = 0.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|RotateInPlace")
+	float RotateMinThreshold = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|RotateInPlace")
+	float RotateMaxThreshold = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|RotateInPlace")
+	float AimYawRateMinRange = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|RotateInPlace")
+	float AimYawRateMaxRange = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|RotateInPlace")
+	float MinPlayRate = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|RotateInPlace")
+	float MaxPlayRate = 0.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|TurnInPlace")
+	float TurnCheckMinAngle = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|TurnInPlace")
+	float Turn180Threshold = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|TurnInPlace")
+	float AimYawRateLimit = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|TurnInPlace")
+	float MinAngleDelay = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|TurnInPlace")
+	float MaxAngleDelay = 0.0f;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|TurnInPlace")
+	FTurnInPlaceAsset NTurnIPL90;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|TurnInPlace")
+	FTurnInPlaceAsset CLFTurnIPL90;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|TurnInPlace")
+	FTurnInPlaceAsset NTurnIPR90;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|TurnInPlace")
+	FTurnInPlaceAsset CLFTurnIPR90;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|TurnInPlace")
+	FTurnInPlaceAsset NTurnIPL180;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|TurnInPlace")
+	FTurnInPlaceAsset CLFTurnIPL180;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|TurnInPlace")
+	FTurnInPlaceAsset NTurnIPR180;
+	UPROPERTY(EditDefaultsOnly, Category = "Anim|TurnInPlace")
+	FTurnInPlaceAsset CLFTurnIPR180;
+};
@@ -0,0 +1,140 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "CharacterPool.h"
+#include "CharacterBase.h"
+#include "Engine/World.h"
+
+DECLARE_STATS_GROUP(TEXT("CharacterPool"), STATGROUP_CharacterPool, STATCAT_Advanced);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Free Characters"), STAT_CharacterPoolFree, STATGROUP_CharacterPool);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Acquired"), STAT_CharacterPoolAcquired, STATGROUP_CharacterPool);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spawned"), STAT_CharacterPoolSpawned, STATGROUP_CharacterPool);
+DECLARE_CYCLE_STAT(TEXT("Acquire"), STAT_CharacterPoolAcquire, STATGROUP_CharacterPool);
+
+static TAutoConsoleVariable<int32> CVarCharacterPoolPrewarmCount(
+	TEXT("CharacterPool.PrewarmCount"),
+	4,
+	TEXT("Characters spawned ahead of time for each pooled character class"));
+
+void UCharacterPool::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	for (int32 Index = 0; Index < ClassPools.Num(); ++Index)
+	{
+		const int32 Count = ClassPools[Index].PendingPrewarmCount;
+		ClassPools[Index].PendingPrewarmCount = 0;
+		Prewarm(ClassPools[Index].CharacterClass, Count);
+	}
+}
+
+void UCharacterPool::Deinitialize()
+{
+	for (const FCharacterClassPool& ClassPool : ClassPools)
+	{
+		DEC_DWORD_STAT_BY(STAT_CharacterPoolFree, ClassPool.FreeCharacters.Num());
+	}
+	ClassPools.Reset();
+
+	Super::Deinitialize();
+}
+
+void UCharacterPool::Prewarm(TSubclassOf<ACharacterBase> CharacterClass, int32 Count)
+{
+	if (CharacterClass == nullptr)
+	{
+		return;
+	}
+
+	if (Count < 0)
+	{
+		Count = CVarCharacterPoolPrewarmCount.GetValueOnGameThread();
+	}
+
+	FCharacterClassPool& ClassPool = FindOrAddClassPool(CharacterClass);
+	if (!GetWorld()->HasBegunPlay())
+	{
+		ClassPool.PendingPrewarmCount = FMath::Max(ClassPool.PendingPrewarmCount, Count);
+		return;
+	}
+
+	while (ClassPool.FreeCharacters.Num() < Count)
+	{
+		ACharacterBase* Character = SpawnCharacter(CharacterClass, FTransform::Identity);
+		if (Character == nullptr)
+		{
+			break;
+		}
+		Character->SetPooledActive(false);
+		ClassPool.FreeCharacters.Add(Character);
+		INC_DWORD_STAT(STAT_CharacterPoolFree);
+	}
+}
+
+ACharacterBase* UCharacterPool::Acquire(TSubclassOf<ACharacterBase> CharacterClass, const FTransform& SpawnTransform)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CharacterPoolAcquire);
+
+	if (CharacterClass == nullptr)
+	{
+		return nullptr;
+	}
+
+	FCharacterClassPool& ClassPool = FindOrAddClassPool(CharacterClass);
+	while (ClassPool.FreeCharacters.Num() > 0)
+	{
+		ACharacterBase* Character = ClassPool.FreeCharacters.Pop(false);
+		DEC_DWORD_STAT(STAT_CharacterPoolFree);
+		if (IsValid(Character))
+		{
+			Character->ResetForReuse(SpawnTransform);
+			Character->SetPooledActive(true);
+			INC_DWORD_STAT(STAT_CharacterPoolAcquired);
+			return Character;
+		}
+	}
+
+	return SpawnCharacter(CharacterClass, SpawnTransform);
+}
+
+void UCharacterPool::Release(ACharacterBase* Character)
+{
+	if (!IsValid(Character))
+	{
+		return;
+	}
+
+	FCharacterClassPool& ClassPool = FindOrAddClassPool(Character->GetClass());
+	if (ClassPool.FreeCharacters.Contains(Character))
+	{
+		return;
+	}
+
+	Character->SetPooledActive(false);
+	ClassPool.FreeCharacters.Add(Character);
+	INC_DWORD_STAT(STAT_CharacterPoolFree);
+}
+
+FCharacterClassPool& UCharacterPool::FindOrAddClassPool(TSubclassOf<ACharacterBase> CharacterClass)
+{
+	if (FCharacterClassPool* ClassPool = ClassPools.FindByPredicate([CharacterClass](const FCharacterClassPool& Pool) { return Pool.CharacterClass == CharacterClass; }))
+	{
+		return *ClassPool;
+	}
+
+	FCharacterClassPool& ClassPool = ClassPools.AddDefaulted_GetRef();
+	ClassPool.CharacterClass = CharacterClass;
+	return ClassPool;
+}
+
+ACharacterBase* UCharacterPool::SpawnCharacter(TSubclassOf<ACharacterBase> CharacterClass, const FTransform& SpawnTransform)
+{
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParameters.ObjectFlags |= RF_Transient;
+	ACharacterBase* Character = GetWorld()->SpawnActor<ACharacterBase>(CharacterClass, SpawnTransform, SpawnParameters);
+	if (Character)
+	{
+		INC_DWORD_STAT(STAT_CharacterPoolSpawned);
+	}
+	return Character;
+}
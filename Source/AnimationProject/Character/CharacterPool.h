@@ -0,0 +1,57 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CharacterPool.generated.h"
+
+class ACharacterBase;
+
+USTRUCT()
+struct FCharacterClassPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TSubclassOf<ACharacterBase> CharacterClass;
+
+	UPROPERTY()
+	TArray<TObjectPtr<ACharacterBase>> FreeCharacters;
+
+	// 世界开始BeginPlay之前请求的预生成数量
+	int32 PendingPrewarmCount = 0;
+};
+
+/**
+ * 提前生成的角色池。取出时只重置运动和动画状态并移动到出生点，
+ * 不会重新执行构造函数、创建组件、OnConstruction和动画实例初始化。
+ */
+UCLASS()
+class UCharacterPool : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	/**
+	 * 生成角色直到池中有Count个空闲角色，Count小于0时使用CharacterPool.PrewarmCount。
+	 * 在地图加载过程中调用时推迟到世界BeginPlay，保证角色的BeginPlay先于放回池中执行。
+	 */
+	void Prewarm(TSubclassOf<ACharacterBase> CharacterClass, int32 Count = -1);
+
+	/** 取出一个重置过的角色，池中没有时生成新的 */
+	ACharacterBase* Acquire(TSubclassOf<ACharacterBase> CharacterClass, const FTransform& SpawnTransform);
+
+	/** 归还角色，调用方需要先取消控制 */
+	void Release(ACharacterBase* Character);
+
+private:
+	FCharacterClassPool& FindOrAddClassPool(TSubclassOf<ACharacterBase> CharacterClass);
+	ACharacterBase* SpawnCharacter(TSubclassOf<ACharacterBase> CharacterClass, const FTransform& SpawnTransform);
+
+	UPROPERTY()
+	TArray<FCharacterClassPool> ClassPools;
+};
@@ -0,0 +1,54 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "DynamicMontageCache.h"
+#include "Animation/AnimMontage.h"
+
+DECLARE_STATS_GROUP(TEXT("DynamicMontageCache"), STATGROUP_DynamicMontageCache, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hits"), STAT_DynamicMontageCacheHits, STATGROUP_DynamicMontageCache);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Misses"), STAT_DynamicMontageCacheMisses, STATGROUP_DynamicMontageCache);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Cached Montages"), STAT_DynamicMontageCacheMontages, STATGROUP_DynamicMontageCache);
+
+UAnimMontage* UDynamicMontageCache::FindOrCreate(UAnimSequenceBase* Asset, FName SlotName, float BlendInTime, float BlendOutTime, int32 LoopCount, float BlendOutTriggerTime)
+{
+	if (Asset == nullptr)
+	{
+		return nullptr;
+	}
+
+	FKey Key;
+	Key.Asset = Asset;
+	Key.SlotName = SlotName;
+	Key.BlendInTime = BlendInTime;
+	Key.BlendOutTime = BlendOutTime;
+	Key.LoopCount = LoopCount;
+	Key.BlendOutTriggerTime = BlendOutTriggerTime;
+
+	// 缓存的蒙太奇引用着动画资源，资源不会在缓存期间被卸载
+	if (const int32* MontageIndex = MontageIndices.Find(Key))
+	{
+		// 每次命中就是少创建一个UAnimMontage
+		INC_DWORD_STAT(STAT_DynamicMontageCacheHits);
+		return Montages[*MontageIndex];
+	}
+
+	INC_DWORD_STAT(STAT_DynamicMontageCacheMisses);
+	// 播放速率和起始位置不会写入蒙太奇，这里传默认值
+	UAnimMontage* Montage = UAnimMontage::CreateSlotAnimationAsDynamicMontage(Asset, SlotName, BlendInTime, BlendOutTime, 1.0f, LoopCount, BlendOutTriggerTime, 0.0f);
+	if (Montage == nullptr)
+	{
+		return nullptr;
+	}
+
+	MontageIndices.Add(Key, Montages.Add(Montage));
+	INC_DWORD_STAT(STAT_DynamicMontageCacheMontages);
+	return Montage;
+}
+
+void UDynamicMontageCache::Deinitialize()
+{
+	DEC_DWORD_STAT_BY(STAT_DynamicMontageCacheMontages, Montages.Num());
+	MontageIndices.Reset();
+	Montages.Reset();
+
+	Super::Deinitialize();
+}
@@ -0,0 +1,59 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "DynamicMontageCache.generated.h"
+
+class UAnimMontage;
+class UAnimSequenceBase;
+
+/**
+ * PlaySlotAnimationAsDynamicMontage每次都会新建一个UAnimMontage。同一个(动画, 插槽, 混合参数)
+ * 生成的蒙太奇内容完全相同，这里只创建一次，世界内所有动画实例共用。
+ * 播放速率和起始位置在Montage_Play时传入，不属于蒙太奇本身。命中率可以用stat DynamicMontageCache查看，
+ * 命中次数即少创建的蒙太奇数量。调用方负责检查动画与自己的骨架兼容。
+ */
+UCLASS()
+class UDynamicMontageCache : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UAnimMontage* FindOrCreate(UAnimSequenceBase* Asset, FName SlotName, float BlendInTime, float BlendOutTime, int32 LoopCount, float BlendOutTriggerTime);
+
+	virtual void Deinitialize() override;
+
+private:
+	struct FKey
+	{
+		TObjectKey<UAnimSequenceBase> Asset;
+		FName SlotName;
+		float BlendInTime = 0.0f;
+		float BlendOutTime = 0.0f;
+		int32 LoopCount = 0;
+		float BlendOutTriggerTime = 0.0f;
+
+		bool operator==(const FKey& Other) const
+		{
+			return Asset == Other.Asset && SlotName == Other.SlotName && BlendInTime == Other.BlendInTime
+				&& BlendOutTime == Other.BlendOutTime && LoopCount == Other.LoopCount && BlendOutTriggerTime == Other.BlendOutTriggerTime;
+		}
+
+		friend uint32 GetTypeHash(const FKey& Key)
+		{
+			uint32 Hash = HashCombine(GetTypeHash(Key.Asset), GetTypeHash(Key.SlotName));
+			Hash = HashCombine(Hash, GetTypeHash(Key.BlendInTime));
+			Hash = HashCombine(Hash, GetTypeHash(Key.BlendOutTime));
+			Hash = HashCombine(Hash, GetTypeHash(Key.LoopCount));
+			return HashCombine(Hash, GetTypeHash(Key.BlendOutTriggerTime));
+		}
+	};
+
+	TMap<FKey, int32> MontageIndices;
+
+	UPROPERTY()
+	TArray<TObjectPtr<UAnimMontage>> Montages;
+};
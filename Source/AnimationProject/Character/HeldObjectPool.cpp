@@ -0,0 +1,214 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "HeldObjectPool.h"
+#include "Animation/AnimInstance.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/AssetManager.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+
+DECLARE_STATS_GROUP(TEXT("HeldObjectPool"), STATGROUP_HeldObjectPool, STATCAT_Advanced);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Components"), STAT_HeldObjectPoolComponents, STATGROUP_HeldObjectPool);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Acquired"), STAT_HeldObjectPoolAcquired, STATGROUP_HeldObjectPool);
+
+static TAutoConsoleVariable<int32> CVarHeldObjectPoolPrewarmCount(
+	TEXT("HeldObject.Pool.PrewarmCount"),
+	2,
+	TEXT("Components created for each held object as soon as its assets finish loading"));
+
+bool UHeldObjectPool::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// 手持物品只用于显示
+	return Super::ShouldCreateSubsystem(Outer) && !IsRunningDedicatedServer();
+}
+
+void UHeldObjectPool::Deinitialize()
+{
+	for (FHeldObjectItemPool& ItemPool : ItemPools)
+	{
+		if (ItemPool.LoadHandle.IsValid())
+		{
+			ItemPool.LoadHandle->CancelHandle();
+		}
+	}
+	ItemPools.Reset();
+	PoolActor = nullptr;
+
+	Super::Deinitialize();
+}
+
+void UHeldObjectPool::Preload(const UHeldObjectSet* Set)
+{
+	if (Set == nullptr)
+	{
+		return;
+	}
+
+	for (const TPair<EOverlayState, FHeldObjectDefinition>& Pair : Set->Items)
+	{
+		if (FindItemPool(Set, Pair.Key) != nullptr)
+		{
+			continue;
+		}
+
+		FHeldObjectItemPool& ItemPool = ItemPools.AddDefaulted_GetRef();
+		ItemPool.Set = Set;
+		ItemPool.Item = Pair.Key;
+
+		TArray<FSoftObjectPath> Assets;
+		const FHeldObjectDefinition& Definition = Pair.Value;
+		for (const FSoftObjectPath& Path : { Definition.StaticMesh.ToSoftObjectPath(), Definition.SkeletalMesh.ToSoftObjectPath(), Definition.AnimClass.ToSoftObjectPath() })
+		{
+			if (!Path.IsNull())
+			{
+				Assets.Add(Path);
+			}
+		}
+		if (Assets.Num() == 0)
+		{
+			ItemPool.bLoaded = true;
+			continue;
+		}
+
+		// 回调可能在RequestAsyncLoad内同步执行并修改ItemPools，句柄通过查找重新赋值
+		const TWeakObjectPtr<const UHeldObjectSet> WeakSet(Set);
+		const EOverlayState Item = Pair.Key;
+		TSharedPtr<FStreamableHandle> LoadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(MoveTemp(Assets),
+			FStreamableDelegate::CreateUObject(this, &UHeldObjectPool::OnItemLoaded, WeakSet, Item));
+		if (FHeldObjectItemPool* LoadingPool = FindItemPool(Set, Item))
+		{
+			LoadingPool->LoadHandle = MoveTemp(LoadHandle);
+		}
+	}
+}
+
+void UHeldObjectPool::OnItemLoaded(TWeakObjectPtr<const UHeldObjectSet> Set, EOverlayState Item)
+{
+	FHeldObjectItemPool* ItemPool = Set.IsValid() ? FindItemPool(Set.Get(), Item) : nullptr;
+	if (ItemPool == nullptr || ItemPool->bLoaded)
+	{
+		return;
+	}
+
+	ItemPool->bLoaded = true;
+	const FHeldObjectDefinition& Definition = Set->Items.FindChecked(Item);
+	for (int32 Index = ItemPool->FreeComponents.Num(); Index < CVarHeldObjectPoolPrewarmCount.GetValueOnGameThread(); ++Index)
+	{
+		if (UPrimitiveComponent* Component = CreateComponent(Definition))
+		{
+			ItemPool->FreeComponents.Add(Component);
+		}
+	}
+}
+
+UPrimitiveComponent* UHeldObjectPool::Acquire(const UHeldObjectSet* Set, EOverlayState Item, USceneComponent* Parent, FName SocketName)
+{
+	FHeldObjectItemPool* ItemPool = FindItemPool(Set, Item);
+	const FHeldObjectDefinition* Definition = Set ? Set->Items.Find(Item) : nullptr;
+	if (ItemPool == nullptr || Definition == nullptr || !ItemPool->bLoaded || !IsValid(Parent))
+	{
+		return nullptr;
+	}
+
+	UPrimitiveComponent* Component = nullptr;
+	while (Component == nullptr && ItemPool->FreeComponents.Num() > 0)
+	{
+		Component = ItemPool->FreeComponents.Pop(false);
+		Component = IsValid(Component) ? Component : nullptr;
+	}
+	if (Component == nullptr)
+	{
+		Component = CreateComponent(*Definition);
+		if (Component == nullptr)
+		{
+			return nullptr;
+		}
+	}
+
+	Component->AttachToComponent(Parent, FAttachmentTransformRules::SnapToTargetNotIncludingScale, SocketName);
+	Component->SetRelativeLocation(Definition->Offset);
+	Component->SetVisibility(true);
+	Component->SetComponentTickEnabled(true);
+	INC_DWORD_STAT(STAT_HeldObjectPoolAcquired);
+	return Component;
+}
+
+void UHeldObjectPool::Release(const UHeldObjectSet* Set, EOverlayState Item, UPrimitiveComponent* Component)
+{
+	FHeldObjectItemPool* ItemPool = FindItemPool(Set, Item);
+	if (!IsValid(Component) || ItemPool == nullptr || GetPoolActor() == nullptr)
+	{
+		return;
+	}
+
+	Component->SetVisibility(false);
+	Component->SetComponentTickEnabled(false);
+	Component->AttachToComponent(PoolActor->GetRootComponent(), FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+	ItemPool->FreeComponents.Add(Component);
+}
+
+FHeldObjectItemPool* UHeldObjectPool::FindItemPool(const UHeldObjectSet* Set, EOverlayState Item)
+{
+	return ItemPools.FindByPredicate([Set, Item](const FHeldObjectItemPool& ItemPool)
+	{
+		return ItemPool.Set == Set && ItemPool.Item == Item;
+	});
+}
+
+UPrimitiveComponent* UHeldObjectPool::CreateComponent(const FHeldObjectDefinition& Definition)
+{
+	AActor* Owner = GetPoolActor();
+	if (Owner == nullptr)
+	{
+		return nullptr;
+	}
+
+	UPrimitiveComponent* Component = nullptr;
+	if (USkeletalMesh* SkeletalMesh = Definition.SkeletalMesh.Get())
+	{
+		USkeletalMeshComponent* SkeletalMeshComponent = NewObject<USkeletalMeshComponent>(Owner);
+		SkeletalMeshComponent->SetSkeletalMesh(SkeletalMesh);
+		SkeletalMeshComponent->SetAnimInstanceClass(Definition.AnimClass.Get());
+		Component = SkeletalMeshComponent;
+	}
+	else if (UStaticMesh* StaticMesh = Definition.StaticMesh.Get())
+	{
+		UStaticMeshComponent* StaticMeshComponent = NewObject<UStaticMeshComponent>(Owner);
+		StaticMeshComponent->SetStaticMesh(StaticMesh);
+		Component = StaticMeshComponent;
+	}
+	else
+	{
+		return nullptr;
+	}
+
+	Component->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Component->SetVisibility(false);
+	Component->SetupAttachment(Owner->GetRootComponent());
+	Component->RegisterComponent();
+	Component->SetComponentTickEnabled(false);
+	INC_DWORD_STAT(STAT_HeldObjectPoolComponents);
+	return Component;
+}
+
+AActor* UHeldObjectPool::GetPoolActor()
+{
+	if (PoolActor == nullptr)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.Name = TEXT("HeldObjectPool");
+		SpawnParameters.ObjectFlags = RF_Transient;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		PoolActor = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParameters);
+		if (PoolActor != nullptr)
+		{
+			USceneComponent* Root = NewObject<USceneComponent>(PoolActor, TEXT("Root"));
+			PoolActor->SetRootComponent(Root);
+			Root->RegisterComponent();
+		}
+	}
+	return PoolActor;
+}
@@ -0,0 +1,103 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AnimationProject/Locomotion/LocomotionDefine.h"
+#include "HeldObjectPool.generated.h"
+
+class UAnimInstance;
+class UPrimitiveComponent;
+class USkeletalMesh;
+class UStaticMesh;
+struct FStreamableHandle;
+
+USTRUCT(BlueprintType)
+struct FHeldObjectDefinition
+{
+	GENERATED_BODY()
+
+	// 静态网格和骨骼网格只需要设置一个，都设置时使用骨骼网格
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	TSoftObjectPtr<UStaticMesh> StaticMesh;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	TSoftObjectPtr<USkeletalMesh> SkeletalMesh;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	TSoftClassPtr<UAnimInstance> AnimClass;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	bool bLeftHand = false;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	FVector Offset = FVector::ZeroVector;
+};
+
+/**
+ * 每个OverlayState手持的物品(步枪、手枪、弓、火把、望远镜、箱子、木桶)，没有配置的OverlayState空手。
+ */
+UCLASS(BlueprintType)
+class UHeldObjectSet : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditDefaultsOnly, Category = HeldObject)
+	TMap<EOverlayState, FHeldObjectDefinition> Items;
+};
+
+USTRUCT()
+struct FHeldObjectItemPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TObjectPtr<const UHeldObjectSet> Set;
+
+	UPROPERTY()
+	EOverlayState Item = EOverlayState::Default;
+
+	UPROPERTY()
+	TArray<TObjectPtr<UPrimitiveComponent>> FreeComponents;
+
+	TSharedPtr<FStreamableHandle> LoadHandle;
+	bool bLoaded = false;
+};
+
+/**
+ * 所有角色共享的手持物品组件池。资源异步加载，组件提前创建并注册，
+ * 取用和归还只改变附加位置和可见性，不会重建渲染状态或重新初始化动画实例。
+ */
+UCLASS()
+class UHeldObjectPool : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	/** 异步加载Set中所有物品，加载完成后每种物品预先创建HeldObject.Pool.PrewarmCount个组件 */
+	void Preload(const UHeldObjectSet* Set);
+
+	/** 取出物品组件并附加到Parent的Socket上，资源还没加载完时返回空 */
+	UPrimitiveComponent* Acquire(const UHeldObjectSet* Set, EOverlayState Item, USceneComponent* Parent, FName SocketName);
+
+	/** 归还组件，隐藏后留在池中 */
+	void Release(const UHeldObjectSet* Set, EOverlayState Item, UPrimitiveComponent* Component);
+
+private:
+	FHeldObjectItemPool* FindItemPool(const UHeldObjectSet* Set, EOverlayState Item);
+	void OnItemLoaded(TWeakObjectPtr<const UHeldObjectSet> Set, EOverlayState Item);
+	UPrimitiveComponent* CreateComponent(const FHeldObjectDefinition& Definition);
+	AActor* GetPoolActor();
+
+	UPROPERTY()
+	TArray<FHeldObjectItemPool> ItemPools;
+
+	UPROPERTY()
+	TObjectPtr<AActor> PoolActor;
+};
@@ -4,8 +4,15 @@
 
 #include "Components/CapsuleComponent.h"
 #include "GameFramework/Character.h"
+#include "AnimationProject/Locomotion/LocomotionProfiler.h"
 
 UXXCharacterMovementComponent::UXXCharacterMovementComponent(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
 }
+
+void UXXCharacterMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	LOCOMOTION_PROFILE_SCOPE(CharacterMovement);
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+}
@@ -13,4 +13,6 @@ class ANIMATIONPROJECT_API UXXCharacterMovementComponent : public UCharacterMove
 
 public:
 	UXXCharacterMovementComponent(const FObjectInitializer& ObjectInitializer);
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 };
\ No newline at end of file
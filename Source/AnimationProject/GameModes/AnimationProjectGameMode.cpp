@@ -1,14 +1,132 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "AnimationProjectGameMode.h"
-#include "UObject/ConstructorHelpers.h"
+#include "AnimationProject/Character/CharacterArchetype.h"
+#include "AnimationProject/Character/CharacterBase.h"
+#include "AnimationProject/Character/CharacterPool.h"
+#include "AnimationProject/Character/HeldObjectPool.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "GameFramework/PlayerController.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogAnimationProjectGameMode, Log, All);
 
 AAnimationProjectGameMode::AAnimationProjectGameMode()
 {
-	// set default pawn class to our Blueprinted character
-	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnBPClass(TEXT("/Game/ThirdPerson/Blueprints/BP_ThirdPersonCharacter"));
-	if (PlayerPawnBPClass.Class != NULL)
+	// 角色类在InitGame中异步加载，不在构造函数里用FClassFinder同步加载
+}
+
+void AAnimationProjectGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	const FStreamableDelegate OnLoaded = FStreamableDelegate::CreateUObject(this, &AAnimationProjectGameMode::OnArchetypeLoaded);
+	if (DefaultArchetype.IsValid())
+	{
+		ArchetypeHandle = UAssetManager::Get().LoadPrimaryAsset(DefaultArchetype, UCharacterArchetype::GetPreloadBundles(),
+			OnLoaded, FStreamableManager::AsyncLoadHighPriority);
+	}
+	else if (!FallbackPawnClass.IsNull())
+	{
+		ArchetypeHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(FallbackPawnClass.ToSoftObjectPath(),
+			OnLoaded, FStreamableManager::AsyncLoadHighPriority);
+	}
+
+	// 已经加载过时不会返回句柄，也可能不会回调
+	if (!ArchetypeHandle.IsValid() || ArchetypeHandle->HasLoadCompleted())
+	{
+		OnArchetypeLoaded();
+	}
+}
+
+void AAnimationProjectGameMode::HandleStartingNewPlayer_Implementation(APlayerController* NewPlayer)
+{
+	if (!bArchetypeLoaded)
+	{
+		PendingPlayers.AddUnique(NewPlayer);
+		return;
+	}
+
+	Super::HandleStartingNewPlayer_Implementation(NewPlayer);
+}
+
+APawn* AAnimationProjectGameMode::SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform)
+{
+	const TSubclassOf<ACharacterBase> CharacterClass = TSubclassOf<ACharacterBase>(GetDefaultPawnClassForController(NewPlayer));
+	UCharacterPool* CharacterPool = GetWorld()->GetSubsystem<UCharacterPool>();
+	if (CharacterClass == nullptr || CharacterPool == nullptr)
+	{
+		return Super::SpawnDefaultPawnAtTransform_Implementation(NewPlayer, SpawnTransform);
+	}
+
+	ACharacterBase* Character = CharacterPool->Acquire(CharacterClass, SpawnTransform);
+	if (Character)
+	{
+		Character->SetInstigator(GetInstigator());
+	}
+	return Character;
+}
+
+void AAnimationProjectGameMode::Logout(AController* Exiting)
+{
+	ACharacterBase* Character = Exiting ? Cast<ACharacterBase>(Exiting->GetPawn()) : nullptr;
+	UCharacterPool* CharacterPool = GetWorld()->GetSubsystem<UCharacterPool>();
+	if (Character && CharacterPool)
+	{
+		Exiting->UnPossess();
+		CharacterPool->Release(Character);
+	}
+
+	Super::Logout(Exiting);
+}
+
+void AAnimationProjectGameMode::OnArchetypeLoaded()
+{
+	if (bArchetypeLoaded)
+	{
+		return;
+	}
+	bArchetypeLoaded = true;
+
+	UClass* PawnClass = nullptr;
+	if (DefaultArchetype.IsValid())
+	{
+		const UCharacterArchetype* Archetype = UAssetManager::Get().GetPrimaryAssetObject<UCharacterArchetype>(DefaultArchetype);
+		PawnClass = Archetype ? Archetype->CharacterClass.Get() : nullptr;
+	}
+	else
+	{
+		PawnClass = FallbackPawnClass.Get();
+	}
+
+	if (PawnClass)
+	{
+		DefaultPawnClass = PawnClass;
+	}
+	else
+	{
+		UE_LOG(LogAnimationProjectGameMode, Warning, TEXT("Failed to load character archetype %s, using %s"),
+			*DefaultArchetype.ToString(), *GetNameSafe(DefaultPawnClass));
+	}
+
+	// 手持物品资源也在这里开始加载，角色生成时组件池已经预热
+	const ACharacterBase* CharacterDefaults = Cast<ACharacterBase>(DefaultPawnClass ? DefaultPawnClass->GetDefaultObject() : nullptr);
+	UHeldObjectPool* HeldObjectPool = GetWorld()->GetSubsystem<UHeldObjectPool>();
+	if (CharacterDefaults && HeldObjectPool)
+	{
+		HeldObjectPool->Preload(CharacterDefaults->HeldObjects);
+	}
+	if (UCharacterPool* CharacterPool = CharacterDefaults ? GetWorld()->GetSubsystem<UCharacterPool>() : nullptr)
+	{
+		CharacterPool->Prewarm(CharacterDefaults->GetClass());
+	}
+
+	TArray<TObjectPtr<APlayerController>> Players = MoveTemp(PendingPlayers);
+	for (APlayerController* Player : Players)
 	{
-		DefaultPawnClass = PlayerPawnBPClass.Class;
+		if (IsValid(Player))
+		{
+			Super::HandleStartingNewPlayer_Implementation(Player);
+		}
 	}
 }
@@ -6,14 +6,41 @@
 #include "GameFramework/GameModeBase.h"
 #include "AnimationProjectGameMode.generated.h"
 
-UCLASS(minimalapi)
+struct FStreamableHandle;
+
+/**
+ * 地图加载时(InitGame)异步预加载角色原型的Bundle，加载完成前加入的玩家排队等待，
+ * 首次生成和重生都不会触发同步加载。加载句柄在关卡生命周期内一直持有。
+ * 角色从UCharacterPool取出，玩家离开时放回池中。
+ */
+UCLASS(minimalapi, config = Game)
 class AAnimationProjectGameMode : public AGameModeBase
 {
 	GENERATED_BODY()
 
 public:
 	AAnimationProjectGameMode();
-};
 
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+	virtual void HandleStartingNewPlayer_Implementation(APlayerController* NewPlayer) override;
+	virtual APawn* SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform) override;
+	virtual void Logout(AController* Exiting) override;
+
+protected:
+	// 玩家使用的角色原型(UCharacterArchetype)
+	UPROPERTY(Config, EditDefaultsOnly, Category = Archetype)
+	FPrimaryAssetId DefaultArchetype;
 
+	// 没有配置DefaultArchetype时异步加载这个角色类
+	UPROPERTY(Config, EditDefaultsOnly, Category = Archetype)
+	TSoftClassPtr<APawn> FallbackPawnClass;
 
+private:
+	void OnArchetypeLoaded();
+
+	TSharedPtr<FStreamableHandle> ArchetypeHandle;
+	bool bArchetypeLoaded = false;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<APlayerController>> PendingPlayers;
+};
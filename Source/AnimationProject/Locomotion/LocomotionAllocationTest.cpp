@@ -0,0 +1,112 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "AnimationProject/Character/CharacterBase.h"
+#include "AnimationProject/Locomotion/LocomotionBenchmarkCommandlet.h"
+#include "AnimationProject/Locomotion/LocomotionProfiler.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerStart.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace LocomotionAllocationTest
+{
+	constexpr float StepSeconds = 1.0f / 60.0f;
+	// 预热期间允许分配(数组扩容、蒙太奇加载等)，之后每帧都不应再分配
+	constexpr int32 NumWarmupFrames = 60;
+	constexpr int32 NumFrames = 240;
+
+	// 前进、转向、停下、起跳循环，覆盖地面、空中和落地
+	void ReplayInput(ACharacterBase* Character, int32 FrameIndex)
+	{
+		const int32 Phase = (FrameIndex / 30) % 4;
+		const FVector2D Move = Phase == 2 ? FVector2D::ZeroVector : FVector2D(Phase == 1 ? 0.5f : 0.0f, 1.0f);
+		const FVector2D Look(Phase == 1 ? 1.0f : 0.0f, 0.0f);
+		Character->ReplayLocomotionInput(Move, Look, Phase == 3 && FrameIndex % 30 < 5);
+	}
+}
+
+/**
+ * 生成一个角色连续Tick，统计整个角色Tick和动画更新(含工作线程上的动画更新)内的堆分配，预热之后必须为0。
+ * 只替换GMalloc到测试结束，需要加载地图，不在编辑器内运行：
+ * AnimationProject -run=LocomotionBenchmark -TestAllocations
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLocomotionZeroAllocationTickTest, "AnimationProject.Locomotion.ZeroAllocationTick",
+	EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::CommandletContext | EAutomationTestFlags::EngineFilter)
+
+bool FLocomotionZeroAllocationTickTest::RunTest(const FString& Parameters)
+{
+	using namespace LocomotionAllocationTest;
+
+	UClass* CharacterClass = LoadClass<ACharacterBase>(nullptr, ULocomotionBenchmarkCommandlet::DefaultCharacter);
+	if (CharacterClass == nullptr)
+	{
+		AddError(FString::Printf(TEXT("Failed to load character class %s"), ULocomotionBenchmarkCommandlet::DefaultCharacter));
+		return false;
+	}
+	UWorld* World = ULocomotionBenchmarkCommandlet::LoadBenchmarkWorld(ULocomotionBenchmarkCommandlet::DefaultMap);
+	if (World == nullptr)
+	{
+		AddError(FString::Printf(TEXT("Failed to load map %s"), ULocomotionBenchmarkCommandlet::DefaultMap));
+		return false;
+	}
+
+	FTransform SpawnTransform(FVector(0.0f, 0.0f, 200.0f));
+	for (TActorIterator<APlayerStart> It(World); It; ++It)
+	{
+		SpawnTransform = It->GetActorTransform();
+		break;
+	}
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	ACharacterBase* Character = World->SpawnActor<ACharacterBase>(CharacterClass, SpawnTransform, SpawnParameters);
+	if (Character == nullptr)
+	{
+		AddError(TEXT("Failed to spawn the character"));
+		ULocomotionBenchmarkCommandlet::DestroyBenchmarkWorld(World);
+		return false;
+	}
+	Character->SpawnDefaultController();
+	Character->GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+
+	for (int32 FrameIndex = 0; FrameIndex < NumWarmupFrames; ++FrameIndex)
+	{
+		ReplayInput(Character, FrameIndex);
+		World->Tick(LEVELTICK_All, StepSeconds);
+	}
+
+	constexpr int32 NumScopes = FLocomotionProfiler::NumScopes;
+	uint32 ScopeAllocations[NumScopes];
+	uint32 TotalScopeAllocations[NumScopes] = {};
+	FLocomotionProfiler::SetEnabled(true);
+	FLocomotionProfiler::SetCountAllocations(true);
+	FLocomotionProfiler::ConsumeAllocations(ScopeAllocations);
+	for (int32 FrameIndex = NumWarmupFrames; FrameIndex < NumWarmupFrames + NumFrames; ++FrameIndex)
+	{
+		ReplayInput(Character, FrameIndex);
+		World->Tick(LEVELTICK_All, StepSeconds);
+		FLocomotionProfiler::ConsumeAllocations(ScopeAllocations);
+		for (int32 Scope = 0; Scope < NumScopes; ++Scope)
+		{
+			TotalScopeAllocations[Scope] += ScopeAllocations[Scope];
+		}
+	}
+	FLocomotionProfiler::SetCountAllocations(false);
+	FLocomotionProfiler::SetEnabled(false);
+
+	for (int32 Scope = 0; Scope < NumScopes; ++Scope)
+	{
+		if (TotalScopeAllocations[Scope] > 0)
+		{
+			AddError(FString::Printf(TEXT("%s allocated %u times over %d frames, expected none"),
+				FLocomotionProfiler::GetScopeName(static_cast<ELocomotionProfileScope>(Scope)), TotalScopeAllocations[Scope], NumFrames));
+		}
+	}
+
+	ULocomotionBenchmarkCommandlet::DestroyBenchmarkWorld(World);
+	return !HasAnyErrors();
+}
+
+#endif
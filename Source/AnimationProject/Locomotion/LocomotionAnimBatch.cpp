@@ -0,0 +1,223 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "LocomotionAnimBatch.h"
+#include "AnimationProject/Character/AnimInstanceBase.h"
+#include "AnimationProject/Character/CharacterBase.h"
+#include "AnimationProject/Character/CharacterLocomotionConfig.h"
+#include "AnimationProject/Locomotion/LocomotionMathBatch.h"
+#include "AnimationProject/Locomotion/LocomotionProfiler.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+DECLARE_STATS_GROUP(TEXT("LocomotionAnimBatch"), STATGROUP_LocomotionAnimBatch, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Instances"), STAT_LocomotionAnimBatchInstances, STATGROUP_LocomotionAnimBatch);
+
+static TAutoConsoleVariable<bool> CVarLocomotionAnimBatchEnable(
+	TEXT("Locomotion.AnimBatch.Enable"),
+	true,
+	TEXT("Compute the grounded velocity blend, relative acceleration and lean of every anim instance in one SIMD batch before animation updates"));
+
+static TAutoConsoleVariable<bool> CVarLocomotionAnimBatchVerify(
+	TEXT("Locomotion.AnimBatch.Verify"),
+	false,
+	TEXT("Also run the scalar path during animation updates and report batched results that differ from it"));
+
+void FLocomotionAnimBatchTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Batch != nullptr)
+	{
+		Batch->Execute(DeltaTime);
+	}
+}
+
+FString FLocomotionAnimBatchTickFunction::DiagnosticMessage()
+{
+	return TEXT("ULocomotionAnimBatch[Execute]");
+}
+
+void ULocomotionAnimBatch::FBatchStreams::SetNum(int32 Num)
+{
+	for (TArray<float>* Stream : {
+		&VelocityX, &VelocityY, &VelocityZ,
+		&AccelerationX, &AccelerationY, &AccelerationZ,
+		&MaxAcceleration, &MaxBrakingDeceleration,
+		&VelocityBlendInterpSpeed, &LeanInterpSpeed,
+		&TargetF, &TargetB, &TargetL, &TargetR,
+		&BlendF, &BlendB, &BlendL, &BlendR,
+		&RelativeAccelerationX, &RelativeAccelerationY, &RelativeAccelerationZ,
+		&LeanLR, &LeanFB })
+	{
+		Stream->SetNum(Num, false);
+	}
+}
+
+bool ULocomotionAnimBatch::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// 只在运行中的游戏世界里有动画更新需要合并
+	const UWorld* World = Cast<UWorld>(Outer);
+	return Super::ShouldCreateSubsystem(Outer) && World != nullptr && World->IsGameWorld();
+}
+
+void ULocomotionAnimBatch::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	TickFunction.Batch = this;
+	TickFunction.TickGroup = TG_PrePhysics;
+	TickFunction.bCanEverTick = true;
+	TickFunction.bStartWithTickEnabled = true;
+	TickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+}
+
+void ULocomotionAnimBatch::Deinitialize()
+{
+	if (TickFunction.IsTickFunctionRegistered())
+	{
+		TickFunction.UnRegisterTickFunction();
+	}
+	TickFunction.Batch = nullptr;
+	Instances.Reset();
+
+	Super::Deinitialize();
+}
+
+bool ULocomotionAnimBatch::ShouldVerify()
+{
+	return CVarLocomotionAnimBatchVerify.GetValueOnGameThread();
+}
+
+void ULocomotionAnimBatch::Register(UAnimInstanceBase* AnimInstance)
+{
+	if (!IsValid(AnimInstance) || !IsValid(AnimInstance->CharacterBase) || Instances.Contains(AnimInstance))
+	{
+		return;
+	}
+
+	Instances.Add(AnimInstance);
+	// 速度和加速度在角色和移动组件更新之后才是本帧的值
+	ACharacterBase* Character = AnimInstance->CharacterBase;
+	TickFunction.AddPrerequisite(Character, Character->PrimaryActorTick);
+	if (UCharacterMovementComponent* MovementComponent = Character->GetCharacterMovement())
+	{
+		TickFunction.AddPrerequisite(MovementComponent, MovementComponent->PrimaryComponentTick);
+	}
+	AnimInstance->GetOwningComponent()->PrimaryComponentTick.AddPrerequisite(this, TickFunction);
+}
+
+void ULocomotionAnimBatch::Unregister(UAnimInstanceBase* AnimInstance)
+{
+	if (Instances.RemoveSwap(AnimInstance) == 0)
+	{
+		return;
+	}
+
+	AnimInstance->GetOwningComponent()->PrimaryComponentTick.RemovePrerequisite(this, TickFunction);
+	// 同一个角色可能还有别的动画实例在批量里
+	ACharacterBase* Character = AnimInstance->CharacterBase;
+	const bool bCharacterStillBatched = Instances.ContainsByPredicate([Character](const TWeakObjectPtr<UAnimInstanceBase>& Instance)
+	{
+		return Instance.IsValid() && Instance->CharacterBase == Character;
+	});
+	if (IsValid(Character) && !bCharacterStillBatched)
+	{
+		TickFunction.RemovePrerequisite(Character, Character->PrimaryActorTick);
+		if (UCharacterMovementComponent* MovementComponent = Character->GetCharacterMovement())
+		{
+			TickFunction.RemovePrerequisite(MovementComponent, MovementComponent->PrimaryComponentTick);
+		}
+	}
+}
+
+void ULocomotionAnimBatch::Execute(float DeltaTime)
+{
+	if (!CVarLocomotionAnimBatchEnable.GetValueOnGameThread() || Instances.Num() == 0 || DeltaTime == 0.0f)
+	{
+		return;
+	}
+
+	LOCOMOTION_PROFILE_SCOPE(AnimBatch);
+	GatherInputs();
+
+	// 与UAnimInstanceBase::UpdateMovementValues的标量计算顺序相同
+	const int32 Num = Instances.Num();
+	LocomotionMathBatch::VelocityBlend(Streams.VelocityX.GetData(), Streams.VelocityY.GetData(), Streams.VelocityZ.GetData(),
+		Streams.TargetF.GetData(), Streams.TargetB.GetData(), Streams.TargetL.GetData(), Streams.TargetR.GetData(), Num);
+	LocomotionMathBatch::InterpTo(Streams.BlendF.GetData(), Streams.TargetF.GetData(), Streams.VelocityBlendInterpSpeed.GetData(), DeltaTime, Num);
+	LocomotionMathBatch::InterpTo(Streams.BlendB.GetData(), Streams.TargetB.GetData(), Streams.VelocityBlendInterpSpeed.GetData(), DeltaTime, Num);
+	LocomotionMathBatch::InterpTo(Streams.BlendL.GetData(), Streams.TargetL.GetData(), Streams.VelocityBlendInterpSpeed.GetData(), DeltaTime, Num);
+	LocomotionMathBatch::InterpTo(Streams.BlendR.GetData(), Streams.TargetR.GetData(), Streams.VelocityBlendInterpSpeed.GetData(), DeltaTime, Num);
+	LocomotionMathBatch::RelativeAcceleration(Streams.AccelerationX.GetData(), Streams.AccelerationY.GetData(), Streams.AccelerationZ.GetData(),
+		Streams.VelocityX.GetData(), Streams.VelocityY.GetData(), Streams.VelocityZ.GetData(),
+		Streams.MaxAcceleration.GetData(), Streams.MaxBrakingDeceleration.GetData(),
+		Streams.RelativeAccelerationX.GetData(), Streams.RelativeAccelerationY.GetData(), Streams.RelativeAccelerationZ.GetData(), Num);
+	LocomotionMathBatch::InterpTo(Streams.LeanLR.GetData(), Streams.RelativeAccelerationY.GetData(), Streams.LeanInterpSpeed.GetData(), DeltaTime, Num);
+	LocomotionMathBatch::InterpTo(Streams.LeanFB.GetData(), Streams.RelativeAccelerationX.GetData(), Streams.LeanInterpSpeed.GetData(), DeltaTime, Num);
+
+	ScatterResults(DeltaTime);
+	SET_DWORD_STAT(STAT_LocomotionAnimBatchInstances, Num);
+}
+
+void ULocomotionAnimBatch::GatherInputs()
+{
+	Instances.RemoveAllSwap([](const TWeakObjectPtr<UAnimInstanceBase>& Instance)
+	{
+		return !Instance.IsValid() || !IsValid(Instance->CharacterBase);
+	});
+	Streams.SetNum(Instances.Num());
+
+	for (int32 Index = 0; Index < Instances.Num(); ++Index)
+	{
+		const UAnimInstanceBase* AnimInstance = Instances[Index].Get();
+		ACharacterBase* Character = AnimInstance->CharacterBase;
+
+		// 与动画更新时UpdateCharacterInfo取到的值相同
+		FVector Velocity, Acceleration, MovementInput;
+		bool bIsMoving, bHasMovementInput;
+		float Speed, MovementInputAmount, AimYawRate;
+		FRotator AimingRotation;
+		Character->BPIGetEssentialValues(Velocity, Acceleration, MovementInput, bIsMoving,
+			bHasMovementInput, Speed, MovementInputAmount, AimingRotation, AimYawRate);
+
+		// 转到角色空间，点积和长度不受旋转影响，先转再限制长度与标量版本结果相同
+		const FRotator Rotation = Character->GetActorRotation();
+		const FVector RelativeVelocity = Rotation.UnrotateVector(Velocity);
+		const FVector RelativeAcceleration = Rotation.UnrotateVector(Acceleration);
+		Streams.VelocityX[Index] = RelativeVelocity.X;
+		Streams.VelocityY[Index] = RelativeVelocity.Y;
+		Streams.VelocityZ[Index] = RelativeVelocity.Z;
+		Streams.AccelerationX[Index] = RelativeAcceleration.X;
+		Streams.AccelerationY[Index] = RelativeAcceleration.Y;
+		Streams.AccelerationZ[Index] = RelativeAcceleration.Z;
+
+		const UCharacterMovementComponent* MovementComponent = Character->GetCharacterMovement();
+		Streams.MaxAcceleration[Index] = MovementComponent->GetMaxAcceleration();
+		Streams.MaxBrakingDeceleration[Index] = MovementComponent->GetMaxBrakingDeceleration();
+
+		Streams.VelocityBlendInterpSpeed[Index] = AnimInstance->LocomotionConfig->VelocityBlendInterpSpeed;
+		Streams.LeanInterpSpeed[Index] = AnimInstance->LocomotionConfig->GroundedLeanInterpSpeed;
+		Streams.BlendF[Index] = AnimInstance->VelocityBlend.F;
+		Streams.BlendB[Index] = AnimInstance->VelocityBlend.B;
+		Streams.BlendL[Index] = AnimInstance->VelocityBlend.L;
+		Streams.BlendR[Index] = AnimInstance->VelocityBlend.R;
+		Streams.LeanLR[Index] = AnimInstance->LeanAmount.LR;
+		Streams.LeanFB[Index] = AnimInstance->LeanAmount.FB;
+	}
+}
+
+void ULocomotionAnimBatch::ScatterResults(float DeltaTime)
+{
+	for (int32 Index = 0; Index < Instances.Num(); ++Index)
+	{
+		UAnimInstanceBase::FBatchedMovementValues& Values = Instances[Index]->BatchedMovementValues;
+		Values.VelocityBlend.F = Streams.BlendF[Index];
+		Values.VelocityBlend.B = Streams.BlendB[Index];
+		Values.VelocityBlend.L = Streams.BlendL[Index];
+		Values.VelocityBlend.R = Streams.BlendR[Index];
+		Values.RelativeAccelerationAmount = FVector(Streams.RelativeAccelerationX[Index], Streams.RelativeAccelerationY[Index], Streams.RelativeAccelerationZ[Index]);
+		Values.LeanAmount.LR = Streams.LeanLR[Index];
+		Values.LeanAmount.FB = Streams.LeanFB[Index];
+		Values.FrameCounter = GFrameCounter;
+		Values.DeltaSeconds = DeltaTime;
+	}
+}
@@ -0,0 +1,68 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LocomotionAnimBatch.generated.h"
+
+class UAnimInstanceBase;
+class ULocomotionAnimBatch;
+
+struct FLocomotionAnimBatchTickFunction : public FTickFunction
+{
+	ULocomotionAnimBatch* Batch = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+/**
+ * 在所有角色移动之后、动画更新之前，把世界内UAnimInstanceBase的地面移动混合值
+ * (VelocityBlend、RelativeAccelerationAmount、LeanAmount)一起用LocomotionMathBatch算好，
+ * 动画更新时直接取用，帧号或DeltaTime对不上时回到逐个的标量计算。
+ * 通过Locomotion.AnimBatch.*控制台变量开关和校验。
+ */
+UCLASS()
+class ULocomotionAnimBatch : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	/** 动画实例初始化时调用，批量计算排在角色移动之后、骨骼网格体更新之前 */
+	void Register(UAnimInstanceBase* AnimInstance);
+	void Unregister(UAnimInstanceBase* AnimInstance);
+
+	void Execute(float DeltaTime);
+
+	/** Locomotion.AnimBatch.Verify开启时动画更新同时跑标量版本，结果不一致时报错 */
+	static bool ShouldVerify();
+
+private:
+	void GatherInputs();
+	void ScatterResults(float DeltaTime);
+
+	// 按分量分开存放，下标与Instances一致，数组只增不减，稳定后不再分配内存
+	struct FBatchStreams
+	{
+		TArray<float> VelocityX, VelocityY, VelocityZ;
+		TArray<float> AccelerationX, AccelerationY, AccelerationZ;
+		TArray<float> MaxAcceleration, MaxBrakingDeceleration;
+		TArray<float> VelocityBlendInterpSpeed, LeanInterpSpeed;
+		TArray<float> TargetF, TargetB, TargetL, TargetR;
+		TArray<float> BlendF, BlendB, BlendL, BlendR;
+		TArray<float> RelativeAccelerationX, RelativeAccelerationY, RelativeAccelerationZ;
+		TArray<float> LeanLR, LeanFB;
+
+		void SetNum(int32 Num);
+	};
+
+	TArray<TWeakObjectPtr<UAnimInstanceBase>> Instances;
+	FBatchStreams Streams;
+	FLocomotionAnimBatchTickFunction TickFunction;
+};
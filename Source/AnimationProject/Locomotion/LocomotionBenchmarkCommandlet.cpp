@@ -0,0 +1,320 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "LocomotionBenchmarkCommandlet.h"
+#include "AnimationProject/Character/CharacterBase.h"
+#include "AnimationProject/Locomotion/LocomotionProfiler.h"
+#include "AnimationProject/Locomotion/LocomotionRecorder.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/Engine.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerStart.h"
+#include "Misc/App.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogLocomotionBenchmark, Log, All);
+
+const TCHAR* const ULocomotionBenchmarkCommandlet::DefaultMap = TEXT("/Game/ThirdPerson/Maps/ThirdPersonMap");
+const TCHAR* const ULocomotionBenchmarkCommandlet::DefaultCharacter = TEXT("/Game/ThirdPerson/Blueprints/BP_ThirdPersonCharacter.BP_ThirdPersonCharacter_C");
+
+namespace LocomotionBenchmark
+{
+	constexpr float CharacterSpacing = 300.0f;
+
+	struct FSampleStats
+	{
+		double Mean = 0.0;
+		double P50 = 0.0;
+		double P90 = 0.0;
+		double P99 = 0.0;
+		double Max = 0.0;
+	};
+
+	// 运行一个自动化测试，失败时返回false
+	bool RunAutomationTest(const TCHAR* TestName)
+	{
+		FAutomationTestFramework& Framework = FAutomationTestFramework::Get();
+		if (!Framework.ContainsTest(TestName))
+		{
+			UE_LOG(LogLocomotionBenchmark, Error, TEXT("Automation test %s is not available in this build"), TestName);
+			return false;
+		}
+
+		FAutomationTestExecutionInfo ExecutionInfo;
+		Framework.StartTestByName(TestName, 0);
+		const bool bSucceeded = Framework.StopTest(ExecutionInfo);
+		for (const FAutomationExecutionEntry& Entry : ExecutionInfo.GetEntries())
+		{
+			if (Entry.Event.Type == EAutomationEventType::Error)
+			{
+				UE_LOG(LogLocomotionBenchmark, Error, TEXT("%s"), *Entry.Event.Message);
+			}
+		}
+		UE_LOG(LogLocomotionBenchmark, Display, TEXT("%s %s"), TestName, bSucceeded ? TEXT("passed") : TEXT("failed"));
+		return bSucceeded;
+	}
+
+	FSampleStats ComputeStats(TArray<double>& Samples)
+	{
+		FSampleStats Stats;
+		if (Samples.Num() == 0)
+		{
+			return Stats;
+		}
+
+		Samples.Sort();
+		double Sum = 0.0;
+		for (const double Sample : Samples)
+		{
+			Sum += Sample;
+		}
+		const auto Percentile = [&Samples](double Fraction)
+		{
+			return Samples[FMath::Clamp(FMath::FloorToInt32(Fraction * Samples.Num()), 0, Samples.Num() - 1)];
+		};
+		Stats.Mean = Sum / Samples.Num();
+		Stats.P50 = Percentile(0.5);
+		Stats.P90 = Percentile(0.9);
+		Stats.P99 = Percentile(0.99);
+		Stats.Max = Samples.Last();
+		return Stats;
+	}
+}
+
+ULocomotionBenchmarkCommandlet::ULocomotionBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = true;
+	LogToConsole = true;
+}
+
+int32 ULocomotionBenchmarkCommandlet::Main(const FString& Params)
+{
+	using namespace LocomotionBenchmark;
+
+	if (FParse::Param(*Params, TEXT("TestBatchMath")))
+	{
+		return RunAutomationTest(TEXT("AnimationProject.Locomotion.MathBatch")) ? 0 : 1;
+	}
+	if (FParse::Param(*Params, TEXT("TestAllocations")))
+	{
+		return RunAutomationTest(TEXT("AnimationProject.Locomotion.ZeroAllocationTick")) ? 0 : 1;
+	}
+
+	FString RecordingList;
+	if (!FParse::Value(*Params, TEXT("Recording="), RecordingList, false))
+	{
+		UE_LOG(LogLocomotionBenchmark, Error, TEXT("Missing -Recording=<file.locrec>[,<file.locrec>...]"));
+		return 1;
+	}
+
+	FString MapName = DefaultMap;
+	FString CharacterClassPath = DefaultCharacter;
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Locomotion") / FString::Printf(TEXT("Benchmark_%s.csv"), *FDateTime::Now().ToString());
+	int32 NumCharacters = 1;
+	int32 StepHz = 60;
+	int32 NumFrames = 0;
+	int32 NumWarmupFrames = 30;
+	int32 Seed = 0;
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	FParse::Value(*Params, TEXT("Character="), CharacterClassPath);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FParse::Value(*Params, TEXT("Count="), NumCharacters);
+	FParse::Value(*Params, TEXT("StepHz="), StepHz);
+	FParse::Value(*Params, TEXT("Frames="), NumFrames);
+	FParse::Value(*Params, TEXT("Warmup="), NumWarmupFrames);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	const bool bFailOnAllocation = FParse::Param(*Params, TEXT("FailOnAllocation"));
+	NumCharacters = FMath::Max(NumCharacters, 1);
+	StepHz = FMath::Max(StepHz, 1);
+
+	TArray<FString> RecordingFiles;
+	RecordingList.ParseIntoArray(RecordingFiles, TEXT(","));
+	TArray<TUniquePtr<FLocomotionRecordReader>> Readers;
+	for (const FString& RecordingFile : RecordingFiles)
+	{
+		TUniquePtr<FLocomotionRecordReader> Reader = MakeUnique<FLocomotionRecordReader>();
+		if (!Reader->Open(RecordingFile) || Reader->GetNumFrames() == 0)
+		{
+			UE_LOG(LogLocomotionBenchmark, Error, TEXT("Failed to open recording %s"), *RecordingFile);
+			return 1;
+		}
+		NumFrames = FMath::Max(NumFrames, Reader->GetNumFrames());
+		Readers.Add(MoveTemp(Reader));
+	}
+
+	UClass* CharacterClass = LoadClass<ACharacterBase>(nullptr, *CharacterClassPath);
+	if (CharacterClass == nullptr)
+	{
+		UE_LOG(LogLocomotionBenchmark, Error, TEXT("Failed to load character class %s"), *CharacterClassPath);
+		return 1;
+	}
+
+	UWorld* World = LoadBenchmarkWorld(MapName);
+	if (World == nullptr)
+	{
+		UE_LOG(LogLocomotionBenchmark, Error, TEXT("Failed to load map %s"), *MapName);
+		return 1;
+	}
+
+	// 固定步长和随机种子，保证同一份输入在不同构建上得到相同的模拟
+	const float StepSeconds = 1.0f / StepHz;
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(StepSeconds);
+	FMath::RandInit(Seed);
+	FMath::SRandInit(Seed);
+
+	FTransform SpawnOrigin(FVector(0.0f, 0.0f, 200.0f));
+	for (TActorIterator<APlayerStart> It(World); It; ++It)
+	{
+		SpawnOrigin = It->GetActorTransform();
+		break;
+	}
+
+	const int32 GridSize = FMath::CeilToInt32(FMath::Sqrt(static_cast<float>(NumCharacters)));
+	TArray<ACharacterBase*> Characters;
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	for (int32 Index = 0; Index < NumCharacters; ++Index)
+	{
+		const FVector Offset((Index / GridSize) * CharacterSpacing, (Index % GridSize) * CharacterSpacing, 0.0f);
+		const FTransform SpawnTransform(SpawnOrigin.GetRotation(), SpawnOrigin.TransformPosition(Offset));
+		ACharacterBase* Character = World->SpawnActor<ACharacterBase>(CharacterClass, SpawnTransform, SpawnParameters);
+		if (Character == nullptr)
+		{
+			continue;
+		}
+		Character->SpawnDefaultController();
+		// 无渲染时骨骼网格不可见，强制更新动画才能测到动画的开销
+		Character->GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+		Characters.Add(Character);
+	}
+	UE_LOG(LogLocomotionBenchmark, Display, TEXT("Spawned %d characters, running %d warmup + %d frames at %d Hz"),
+		Characters.Num(), NumWarmupFrames, NumFrames, StepHz);
+
+	constexpr int32 NumScopes = FLocomotionProfiler::NumScopes;
+	TArray<double> ScopeSamples[NumScopes];
+	TArray<double> WorldTickSamples;
+	for (TArray<double>& Samples : ScopeSamples)
+	{
+		Samples.Reserve(NumFrames);
+	}
+	WorldTickSamples.Reserve(NumFrames);
+
+	uint32 TotalScopeAllocations[NumScopes] = {};
+
+	FLocomotionProfiler::SetEnabled(true);
+	FLocomotionProfiler::SetCountAllocations(true);
+	double ScopeMilliseconds[NumScopes];
+	uint32 ScopeAllocations[NumScopes];
+	for (int32 FrameIndex = 0; FrameIndex < NumWarmupFrames + NumFrames; ++FrameIndex)
+	{
+		for (int32 Index = 0; Index < Characters.Num(); ++Index)
+		{
+			const FLocomotionRecordReader& Reader = *Readers[Index % Readers.Num()];
+			const FLocomotionRecordFrame& Frame = Reader.GetFrame(FrameIndex % Reader.GetNumFrames());
+			Characters[Index]->ReplayLocomotionInput(FVector2D(Frame.MoveInput), FVector2D(Frame.LookInput),
+				EnumHasAnyFlags(Frame.StateFlags, ELocomotionStateFlags::JumpPressed));
+		}
+
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		World->Tick(LEVELTICK_All, StepSeconds);
+		const double WorldTickMilliseconds = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+		FLocomotionProfiler::ConsumeMilliseconds(ScopeMilliseconds);
+		FLocomotionProfiler::ConsumeAllocations(ScopeAllocations);
+
+		if (FrameIndex < NumWarmupFrames)
+		{
+			continue;
+		}
+		WorldTickSamples.Add(WorldTickMilliseconds);
+		for (int32 Scope = 0; Scope < NumScopes; ++Scope)
+		{
+			ScopeSamples[Scope].Add(ScopeMilliseconds[Scope]);
+			TotalScopeAllocations[Scope] += ScopeAllocations[Scope];
+		}
+	}
+	FLocomotionProfiler::SetCountAllocations(false);
+	FLocomotionProfiler::SetEnabled(false);
+
+	// 最终状态的哈希，用于确认不同构建的模拟结果一致
+	uint32 StateHash = 0;
+	for (const ACharacterBase* Character : Characters)
+	{
+		const FVector Location = Character->GetActorLocation();
+		const FRotator Rotation = Character->GetActorRotation();
+		StateHash = HashCombine(StateHash, GetTypeHash(FIntVector(FMath::RoundToInt32(Location.X), FMath::RoundToInt32(Location.Y), FMath::RoundToInt32(Location.Z))));
+		StateHash = HashCombine(StateHash, GetTypeHash(FMath::RoundToInt32(Rotation.Yaw)));
+	}
+
+	TArray<FString> Lines;
+	Lines.Add(TEXT("Scope,MeanMs,P50Ms,P90Ms,P99Ms,MaxMs,Allocations"));
+	const auto Report = [&Lines](const TCHAR* ScopeName, TArray<double>& Samples, uint32 Allocations)
+	{
+		const FSampleStats Stats = ComputeStats(Samples);
+		UE_LOG(LogLocomotionBenchmark, Display, TEXT("%-18s mean %7.3f  p50 %7.3f  p90 %7.3f  p99 %7.3f  max %7.3f ms  %u allocs"),
+			ScopeName, Stats.Mean, Stats.P50, Stats.P90, Stats.P99, Stats.Max, Allocations);
+		Lines.Add(FString::Printf(TEXT("%s,%.4f,%.4f,%.4f,%.4f,%.4f,%u"), ScopeName, Stats.Mean, Stats.P50, Stats.P90, Stats.P99, Stats.Max, Allocations));
+	};
+	// WorldTick一行的分配数是所有运动作用域之和，不包含引擎其余部分
+	uint32 NumAllocations = 0;
+	for (int32 Scope = 0; Scope < NumScopes; ++Scope)
+	{
+		NumAllocations += TotalScopeAllocations[Scope];
+	}
+	Report(TEXT("WorldTick"), WorldTickSamples, NumAllocations);
+	for (int32 Scope = 0; Scope < NumScopes; ++Scope)
+	{
+		Report(FLocomotionProfiler::GetScopeName(static_cast<ELocomotionProfileScope>(Scope)), ScopeSamples[Scope], TotalScopeAllocations[Scope]);
+	}
+	Lines.Add(FString::Printf(TEXT("StateHash,%08x"), StateHash));
+	UE_LOG(LogLocomotionBenchmark, Display, TEXT("StateHash %08x"), StateHash);
+
+	DestroyBenchmarkWorld(World);
+
+	if (!FFileHelper::SaveStringArrayToFile(Lines, *OutputPath))
+	{
+		UE_LOG(LogLocomotionBenchmark, Error, TEXT("Failed to write %s"), *OutputPath);
+		return 1;
+	}
+	UE_LOG(LogLocomotionBenchmark, Display, TEXT("Wrote %s"), *OutputPath);
+
+	if (bFailOnAllocation && NumAllocations > 0)
+	{
+		UE_LOG(LogLocomotionBenchmark, Error, TEXT("%u heap allocations in locomotion scopes over %d frames, expected none"), NumAllocations, NumFrames);
+		return 1;
+	}
+	return 0;
+}
+
+UWorld* ULocomotionBenchmarkCommandlet::LoadBenchmarkWorld(const FString& MapName)
+{
+	UPackage* MapPackage = LoadPackage(nullptr, *MapName, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : nullptr;
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	World->WorldType = EWorldType::Game;
+	World->AddToRoot();
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	World->InitWorld();
+	const FURL URL;
+	World->SetGameMode(URL);
+	World->InitializeActorsForPlay(URL);
+	World->BeginPlay();
+	return World;
+}
+
+void ULocomotionBenchmarkCommandlet::DestroyBenchmarkWorld(UWorld* World)
+{
+	World->BeginTearingDown();
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+}
@@ -0,0 +1,34 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "LocomotionBenchmarkCommandlet.generated.h"
+
+/**
+ * 无渲染回放录制的输入，按固定步长驱动世界，统计运动各子系统的帧耗时分布。
+ * 用法: AnimationProject -run=LocomotionBenchmark -Recording=A.locrec[,B.locrec] [-Map=] [-Character=]
+ *      [-Count=1] [-StepHz=60] [-Frames=] [-Warmup=30] [-Seed=0] [-Output=Benchmark.csv] [-FailOnAllocation]
+ * 每个角色循环回放一份录制(多份时依次分配)，结果写入CSV，便于在构建机上对比不同版本。
+ * 同时统计预热之后各作用域内的堆分配次数，带-FailOnAllocation时有任何分配即返回失败。
+ * 带-TestBatchMath或-TestAllocations时只运行对应的自动化测试(批量数学与标量版本的对比、角色Tick的零分配)，
+ * 不需要录制，失败时返回非0。
+ */
+UCLASS()
+class ULocomotionBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	ULocomotionBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+	static const TCHAR* const DefaultMap;
+	static const TCHAR* const DefaultCharacter;
+
+	/** 以游戏世界加载地图并开始运行，自动化测试也用它搭建同样的场景 */
+	static UWorld* LoadBenchmarkWorld(const FString& MapName);
+	static void DestroyBenchmarkWorld(UWorld* World);
+};
@@ -197,31 +197,32 @@ struct FMantleAsset
 {
 	GENERATED_BODY()
 	
-	UPROPERTY(BlueprintReadWrite)
-	TObjectPtr<UAnimMontage> AnimMontage = nullptr;
+	// 由ULocomotionMontageResidency提前加载
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TSoftObjectPtr<UAnimMontage> AnimMontage;
 
 	UPROPERTY(BlueprintReadWrite, meta = (DisplayName = "Position/Correction Curve"))
 	FVectorCurve* PositionCurve = nullptr;
 
-	UPROPERTY(BlueprintReadWrite)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FVector StartingOffset = FVector::ZeroVector;
 
-	UPROPERTY(BlueprintReadWrite)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float LowHeight = 0.0f;
 
-	UPROPERTY(BlueprintReadWrite)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float LowPlayRate = 0.0f;
 
-	UPROPERTY(BlueprintReadWrite)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float LowStartPosition = 0.0f;
 
-	UPROPERTY(BlueprintReadWrite)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float HighHeight = 0.0f;
 
-	UPROPERTY(BlueprintReadWrite)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float HighPlayRate = 0.0f;
 	
-	UPROPERTY(BlueprintReadWrite)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float HightStartPosition = 0.0f;
 };
 
@@ -278,19 +279,19 @@ struct FTurnInPlaceAsset
 {
 	GENERATED_BODY()
 	
-	UPROPERTY(BlueprintReadWrite)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	TObjectPtr<UAnimSequenceBase> Animation = nullptr;
 
-	UPROPERTY(BlueprintReadWrite)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float AnimatedAngle = 0.0f;
 	
-	UPROPERTY(BlueprintReadWrite)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FName SlotName;
 	
-	UPROPERTY(BlueprintReadWrite)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float PlayRate = 1.0f;
 
-	UPROPERTY(BlueprintReadWrite)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	bool ScaleTurnAngle = true;
 };
 
@@ -370,6 +371,14 @@ enum class EAnimFeatureExample : uint8
 	SprintImpulse
 };
 
+// 角色原型启用的运动特性组合，对应LocomotionFeatures.h中的特性策略
+UENUM(BlueprintType)
+enum class ELocomotionFeatureSet : uint8
+{
+	Full,
+	Slim
+};
+
 UENUM(BlueprintType)
 enum class EFootstepType : uint8
 {
@@ -0,0 +1,58 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AnimationProject/Locomotion/LocomotionDefine.h"
+
+/**
+ * 运动特性策略。ACharacterBase和UAnimInstanceBase的更新函数以策略为模板参数实例化，
+ * 关闭的特性用if constexpr去掉，不会出现在该原型的更新路径里。
+ * 原型通过UCharacterLocomotionConfig::FeatureSet选择策略，初始化时确定一次。
+ */
+struct FFullLocomotionFeatures
+{
+	// 动画
+	static constexpr bool bFootLocking = true;
+	static constexpr bool bFootIK = true;
+	static constexpr bool bLandPrediction = true;
+	static constexpr bool bStrideBlending = true;
+	static constexpr bool bAdditiveLeaning = true;
+	static constexpr bool bTurnInPlace = true;
+	static constexpr bool bDynamicTransitions = true;
+
+	// 角色
+	static constexpr bool bInAirMantle = true;
+	static constexpr bool bDebugShapes = true;
+	static constexpr bool bLayeringColors = true;
+};
+
+/** 远处或大量NPC用，只保留移动、朝向和基础动画混合 */
+struct FSlimLocomotionFeatures
+{
+	static constexpr bool bFootLocking = false;
+	static constexpr bool bFootIK = false;
+	static constexpr bool bLandPrediction = false;
+	static constexpr bool bStrideBlending = false;
+	static constexpr bool bAdditiveLeaning = false;
+	static constexpr bool bTurnInPlace = false;
+	static constexpr bool bDynamicTransitions = false;
+
+	static constexpr bool bInAirMantle = false;
+	static constexpr bool bDebugShapes = false;
+	static constexpr bool bLayeringColors = false;
+};
+
+/** 按FeatureSet用对应的策略对象调用Visitor，Visitor对每种策略的返回类型必须相同 */
+template <typename VisitorType>
+decltype(auto) VisitLocomotionFeatures(ELocomotionFeatureSet FeatureSet, VisitorType&& Visitor)
+{
+	switch (FeatureSet)
+	{
+	case ELocomotionFeatureSet::Slim:
+		return Visitor(FSlimLocomotionFeatures());
+	case ELocomotionFeatureSet::Full:
+	default:
+		return Visitor(FFullLocomotionFeatures());
+	}
+}
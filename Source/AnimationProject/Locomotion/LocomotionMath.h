@@ -0,0 +1,146 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include <cmath>
+
+/**
+ * 运动相关的纯计算函数，只依赖标准库，不依赖UObject和引擎数学库，可以单独编译做测试和性能分析。
+ * 需要枚举或结构体的函数以模板参数接收类型，只要求成员名一致(EGait::Walking、FVelocityBlend::F等)。
+ * 与引擎版本的结果保持一致：FInterpTo、MapRangeClamped的边界处理与FMath相同。
+ */
+namespace LocomotionMath
+{
+	constexpr float SmallNumber = 1.e-8f;
+
+	constexpr float Clamp(float Value, float Min, float Max)
+	{
+		return Value < Min ? Min : (Value > Max ? Max : Value);
+	}
+
+	constexpr float Lerp(float A, float B, float Alpha)
+	{
+		return A + Alpha * (B - A);
+	}
+
+	/** 闭区间 */
+	constexpr bool InRange(float Value, float Min, float Max)
+	{
+		return Value >= Min && Value <= Max;
+	}
+
+	/** 同UKismetMathLibrary::MapRangeClamped，输入区间为0时按Value >= InB取0或1 */
+	constexpr float MapRangeClamped(float Value, float InA, float InB, float OutA, float OutB)
+	{
+		const float Divisor = InB - InA;
+		const float Percent = (Divisor > -SmallNumber && Divisor < SmallNumber) ? (Value >= InB ? 1.0f : 0.0f) : (Value - InA) / Divisor;
+		return Lerp(OutA, OutB, Clamp(Percent, 0.0f, 1.0f));
+	}
+
+	/** 同FMath::FInterpTo */
+	inline float FInterpTo(float Current, float Target, float DeltaTime, float InterpSpeed)
+	{
+		if (InterpSpeed <= 0.0f)
+		{
+			return Target;
+		}
+		const float Dist = Target - Current;
+		if (Dist * Dist < SmallNumber)
+		{
+			return Target;
+		}
+		return Current + Dist * Clamp(DeltaTime * InterpSpeed, 0.0f, 1.0f);
+	}
+
+	/** 把速度映射到0~3：0静止，1走，2跑，3冲刺 */
+	constexpr float MappedSpeed(float Speed, float WalkSpeed, float RunSpeed, float SprintSpeed)
+	{
+		return Speed > RunSpeed ? MapRangeClamped(Speed, RunSpeed, SprintSpeed, 2.0f, 3.0f)
+			: Speed > WalkSpeed ? MapRangeClamped(Speed, WalkSpeed, RunSpeed, 1.0f, 2.0f)
+			: MapRangeClamped(Speed, 0.0f, WalkSpeed, 0.0f, 1.0f);
+	}
+
+	/** 按实际速度得到的步态，超过对应速度10以上才切换，不会超过允许的步态 */
+	template <typename GaitType>
+	constexpr GaitType ActualGait(float Speed, float WalkSpeed, float RunSpeed, GaitType AllowedGait)
+	{
+		if (Speed >= RunSpeed + 10.0f)
+		{
+			return AllowedGait == GaitType::Sprinting ? GaitType::Sprinting : GaitType::Running;
+		}
+		return Speed >= WalkSpeed + 10.0f ? GaitType::Running : GaitType::Walking;
+	}
+
+	/** 手柄斜向输入的幅度偏小，按另一轴的大小放大后再限制到[-1, 1] */
+	inline void FixDiagonalGamepadValues(float InX, float InY, float& OutX, float& OutY)
+	{
+		const float ScaleX = MapRangeClamped(std::abs(InX), 0.0f, 0.6f, 1.0f, 1.2f);
+		const float ScaleY = MapRangeClamped(std::abs(InY), 0.0f, 0.6f, 1.0f, 1.2f);
+		OutX = Clamp(InX * ScaleY, -1.0f, 1.0f);
+		OutY = Clamp(InY * ScaleX, -1.0f, 1.0f);
+	}
+
+	/** 输入为角色空间的速度方向，按各轴占比分到前后左右四个权重，速度为0时四个权重都是0 */
+	template <typename BlendType>
+	inline BlendType VelocityBlend(float RelativeX, float RelativeY, float RelativeZ)
+	{
+		const float Sum = std::abs(RelativeX) + std::abs(RelativeY) + std::abs(RelativeZ);
+		const float InvSum = Sum > SmallNumber ? 1.0f / Sum : 0.0f;
+		const float X = RelativeX * InvSum;
+		const float Y = RelativeY * InvSum;
+		BlendType Result;
+		Result.F = Clamp(X, 0.0f, 1.0f);
+		Result.B = Clamp(X, -1.0f, 0.0f);
+		Result.L = Clamp(Y, -1.0f, 0.0f);
+		Result.R = Clamp(Y, 0.0f, 1.0f);
+		return Result;
+	}
+
+	template <typename BlendType>
+	inline BlendType InterpVelocityBlend(const BlendType& Current, const BlendType& Target, float InterpSpeed, float DeltaTime)
+	{
+		BlendType Result;
+		Result.F = FInterpTo(Current.F, Target.F, DeltaTime, InterpSpeed);
+		Result.B = FInterpTo(Current.B, Target.B, DeltaTime, InterpSpeed);
+		Result.L = FInterpTo(Current.L, Target.L, DeltaTime, InterpSpeed);
+		Result.R = FInterpTo(Current.R, Target.R, DeltaTime, InterpSpeed);
+		return Result;
+	}
+
+	template <typename LeanType>
+	inline LeanType InterpLeanAmount(const LeanType& Current, const LeanType& Target, float InterpSpeed, float DeltaTime)
+	{
+		LeanType Result;
+		Result.LR = FInterpTo(Current.LR, Target.LR, DeltaTime, InterpSpeed);
+		Result.FB = FInterpTo(Current.FB, Target.FB, DeltaTime, InterpSpeed);
+		return Result;
+	}
+
+	/** IncreaseBuffer为true时区间向外扩Buffer，否则向内缩，用于象限切换的滞后 */
+	constexpr bool AngleInRange(float Angle, float MinAngle, float MaxAngle, float Buffer, bool bIncreaseBuffer)
+	{
+		return bIncreaseBuffer ? InRange(Angle, MinAngle - Buffer, MaxAngle + Buffer) : InRange(Angle, MinAngle + Buffer, MaxAngle - Buffer);
+	}
+
+	/**
+	 * 按角度和阈值判断移动方向的象限。
+	 * 注意各象限的扩展条件写成了"!= A || != B"，恒为true，即总是扩展Buffer，与原蓝图一致。
+	 */
+	template <typename DirectionType>
+	constexpr DirectionType Quadrant(DirectionType Current, float FRThreshold, float FLThreshold, float BRThreshold, float BLThreshold, float Buffer, float Angle)
+	{
+		if (AngleInRange(Angle, FLThreshold, FRThreshold, Buffer, Current != DirectionType::Forward || Current != DirectionType::Backward))
+		{
+			return DirectionType::Forward;
+		}
+		if (AngleInRange(Angle, FRThreshold, BRThreshold, Buffer, Current != DirectionType::Right || Current != DirectionType::Left))
+		{
+			return DirectionType::Right;
+		}
+		if (AngleInRange(Angle, BLThreshold, FLThreshold, Buffer, Current != DirectionType::Right || Current != DirectionType::Left))
+		{
+			return DirectionType::Left;
+		}
+		return DirectionType::Backward;
+	}
+}
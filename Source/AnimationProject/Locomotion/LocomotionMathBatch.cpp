@@ -0,0 +1,122 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "LocomotionMathBatch.h"
+#include "AnimationProject/Locomotion/LocomotionMath.h"
+
+namespace LocomotionMathBatch
+{
+	struct FScalarVelocityBlend
+	{
+		float F = 0.0f;
+		float B = 0.0f;
+		float L = 0.0f;
+		float R = 0.0f;
+	};
+
+	// 同UKismetMathLibrary::Vector_ClampSizeMax后再除以上限
+	void ScalarRelativeAcceleration(float X, float Y, float Z, float MaxSize, float& OutX, float& OutY, float& OutZ)
+	{
+		float Scale = 0.0f;
+		if (MaxSize >= KINDA_SMALL_NUMBER)
+		{
+			const float SizeSquared = X * X + Y * Y + Z * Z;
+			Scale = SizeSquared > MaxSize * MaxSize ? FMath::InvSqrt(SizeSquared) : 1.0f / MaxSize;
+		}
+		OutX = X * Scale;
+		OutY = Y * Scale;
+		OutZ = Z * Scale;
+	}
+
+	void InterpTo(float* Current, const float* Target, const float* InterpSpeed, float DeltaTime, int32 Num)
+	{
+		const VectorRegister4Float Zero = VectorZeroFloat();
+		const VectorRegister4Float One = VectorOneFloat();
+		const VectorRegister4Float SmallNumber = VectorSetFloat1(LocomotionMath::SmallNumber);
+		const VectorRegister4Float DeltaTimes = VectorSetFloat1(DeltaTime);
+
+		int32 Index = 0;
+		for (; Index + NumLanes <= Num; Index += NumLanes)
+		{
+			const VectorRegister4Float Currents = VectorLoad(Current + Index);
+			const VectorRegister4Float Targets = VectorLoad(Target + Index);
+			const VectorRegister4Float Speeds = VectorLoad(InterpSpeed + Index);
+			const VectorRegister4Float Dist = VectorSubtract(Targets, Currents);
+			const VectorRegister4Float Alpha = VectorMin(VectorMax(VectorMultiply(DeltaTimes, Speeds), Zero), One);
+			const VectorRegister4Float Interped = VectorMultiplyAdd(Dist, Alpha, Currents);
+			// 插值速度不大于0或已经足够接近时直接取目标值
+			const VectorRegister4Float SnapMask = VectorBitwiseOr(VectorCompareLE(Speeds, Zero), VectorCompareLT(VectorMultiply(Dist, Dist), SmallNumber));
+			VectorStore(VectorSelect(SnapMask, Targets, Interped), Current + Index);
+		}
+		for (; Index < Num; ++Index)
+		{
+			Current[Index] = LocomotionMath::FInterpTo(Current[Index], Target[Index], DeltaTime, InterpSpeed[Index]);
+		}
+	}
+
+	void VelocityBlend(const float* X, const float* Y, const float* Z, float* OutF, float* OutB, float* OutL, float* OutR, int32 Num)
+	{
+		const VectorRegister4Float Zero = VectorZeroFloat();
+		const VectorRegister4Float One = VectorOneFloat();
+		const VectorRegister4Float MinusOne = VectorSetFloat1(-1.0f);
+		const VectorRegister4Float SmallNumber = VectorSetFloat1(LocomotionMath::SmallNumber);
+
+		int32 Index = 0;
+		for (; Index + NumLanes <= Num; Index += NumLanes)
+		{
+			const VectorRegister4Float Xs = VectorLoad(X + Index);
+			const VectorRegister4Float Ys = VectorLoad(Y + Index);
+			const VectorRegister4Float Sum = VectorAdd(VectorAdd(VectorAbs(Xs), VectorAbs(Ys)), VectorAbs(VectorLoad(Z + Index)));
+			const VectorRegister4Float InvSum = VectorSelect(VectorCompareGT(Sum, SmallNumber), VectorDivide(One, Sum), Zero);
+			const VectorRegister4Float RatioX = VectorMultiply(Xs, InvSum);
+			const VectorRegister4Float RatioY = VectorMultiply(Ys, InvSum);
+			VectorStore(VectorMin(VectorMax(RatioX, Zero), One), OutF + Index);
+			VectorStore(VectorMin(VectorMax(RatioX, MinusOne), Zero), OutB + Index);
+			VectorStore(VectorMin(VectorMax(RatioY, MinusOne), Zero), OutL + Index);
+			VectorStore(VectorMin(VectorMax(RatioY, Zero), One), OutR + Index);
+		}
+		for (; Index < Num; ++Index)
+		{
+			const FScalarVelocityBlend Blend = LocomotionMath::VelocityBlend<FScalarVelocityBlend>(X[Index], Y[Index], Z[Index]);
+			OutF[Index] = Blend.F;
+			OutB[Index] = Blend.B;
+			OutL[Index] = Blend.L;
+			OutR[Index] = Blend.R;
+		}
+	}
+
+	void RelativeAcceleration(const float* AccelerationX, const float* AccelerationY, const float* AccelerationZ,
+		const float* VelocityX, const float* VelocityY, const float* VelocityZ,
+		const float* MaxAcceleration, const float* MaxBrakingDeceleration,
+		float* OutX, float* OutY, float* OutZ, int32 Num)
+	{
+		const VectorRegister4Float Zero = VectorZeroFloat();
+		const VectorRegister4Float One = VectorOneFloat();
+		const VectorRegister4Float KindaSmallNumber = VectorSetFloat1(KINDA_SMALL_NUMBER);
+
+		int32 Index = 0;
+		for (; Index + NumLanes <= Num; Index += NumLanes)
+		{
+			const VectorRegister4Float Xs = VectorLoad(AccelerationX + Index);
+			const VectorRegister4Float Ys = VectorLoad(AccelerationY + Index);
+			const VectorRegister4Float Zs = VectorLoad(AccelerationZ + Index);
+			const VectorRegister4Float Dot = VectorMultiplyAdd(Xs, VectorLoad(VelocityX + Index),
+				VectorMultiplyAdd(Ys, VectorLoad(VelocityY + Index), VectorMultiply(Zs, VectorLoad(VelocityZ + Index))));
+			const VectorRegister4Float MaxSize = VectorSelect(VectorCompareGT(Dot, Zero),
+				VectorLoad(MaxAcceleration + Index), VectorLoad(MaxBrakingDeceleration + Index));
+			const VectorRegister4Float SizeSquared = VectorMultiplyAdd(Xs, Xs, VectorMultiplyAdd(Ys, Ys, VectorMultiply(Zs, Zs)));
+			// 超过上限时缩放到上限再除以上限，相当于除以自身长度，否则直接除以上限
+			VectorRegister4Float Scale = VectorSelect(VectorCompareGT(SizeSquared, VectorMultiply(MaxSize, MaxSize)),
+				VectorReciprocalSqrtAccurate(SizeSquared), VectorDivide(One, MaxSize));
+			Scale = VectorSelect(VectorCompareLT(MaxSize, KindaSmallNumber), Zero, Scale);
+			VectorStore(VectorMultiply(Xs, Scale), OutX + Index);
+			VectorStore(VectorMultiply(Ys, Scale), OutY + Index);
+			VectorStore(VectorMultiply(Zs, Scale), OutZ + Index);
+		}
+		for (; Index < Num; ++Index)
+		{
+			const float Dot = AccelerationX[Index] * VelocityX[Index] + AccelerationY[Index] * VelocityY[Index] + AccelerationZ[Index] * VelocityZ[Index];
+			ScalarRelativeAcceleration(AccelerationX[Index], AccelerationY[Index], AccelerationZ[Index],
+				Dot > 0.0f ? MaxAcceleration[Index] : MaxBrakingDeceleration[Index], OutX[Index], OutY[Index], OutZ[Index]);
+		}
+	}
+}
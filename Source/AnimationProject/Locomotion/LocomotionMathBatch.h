@@ -0,0 +1,31 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * LocomotionMath中动画每帧都要算的几个函数的批量版本，输入输出按分量分开存放(SoA)，
+ * 每次用VectorRegister4Float处理4个角色，不足4个的部分逐个调用LocomotionMath。
+ * 结果与标量版本在浮点误差内一致，由Locomotion.AnimBatch.Verify在运行时对比，
+ * 固定输入的对比测试见LocomotionMathBatchTest.cpp(AnimationProject.Locomotion.MathBatch)。
+ */
+namespace LocomotionMathBatch
+{
+	constexpr int32 NumLanes = 4;
+
+	/** Current[i] = FInterpTo(Current[i], Target[i], DeltaTime, InterpSpeed[i]) */
+	void InterpTo(float* Current, const float* Target, const float* InterpSpeed, float DeltaTime, int32 Num);
+
+	/** 同LocomotionMath::VelocityBlend，输入为角色空间的速度，不需要先归一化 */
+	void VelocityBlend(const float* X, const float* Y, const float* Z, float* OutF, float* OutB, float* OutL, float* OutR, int32 Num);
+
+	/**
+	 * 同UAnimInstanceBase::CalculateRelativeAccelerationAmount，输入为角色空间的加速度和速度。
+	 * 加速度与速度同向时按MaxAcceleration归一化，否则按MaxBrakingDeceleration，长度不超过1。
+	 */
+	void RelativeAcceleration(const float* AccelerationX, const float* AccelerationY, const float* AccelerationZ,
+		const float* VelocityX, const float* VelocityY, const float* VelocityZ,
+		const float* MaxAcceleration, const float* MaxBrakingDeceleration,
+		float* OutX, float* OutY, float* OutZ, int32 Num);
+}
@@ -0,0 +1,181 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "AnimationProject/Locomotion/LocomotionMath.h"
+#include "AnimationProject/Locomotion/LocomotionMathBatch.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace LocomotionMathBatchTest
+{
+	constexpr float Tolerance = 1.e-5f;
+	// 覆盖0到3个整组加上0到3个尾部元素，每种特殊输入按下标轮流出现，在整组和尾部里都会碰到
+	constexpr int32 MaxNum = 15;
+
+	struct FBlend
+	{
+		float F = 0.0f;
+		float B = 0.0f;
+		float L = 0.0f;
+		float R = 0.0f;
+	};
+
+	bool IsNear(float Actual, float Expected)
+	{
+		return FMath::IsFinite(Actual) && FMath::IsNearlyEqual(Actual, Expected, Tolerance);
+	}
+
+	void TestInterpTo(FAutomationTestBase& Test, float DeltaTime)
+	{
+		FRandomStream Random(1);
+		TArray<float> Current, Target, InterpSpeed;
+		for (int32 Index = 0; Index < MaxNum; ++Index)
+		{
+			const float From = Random.FRandRange(-1.0f, 1.0f);
+			float To = Random.FRandRange(-1.0f, 1.0f);
+			float Speed = Random.FRandRange(1.0f, 20.0f);
+			switch (Index % 5)
+			{
+			case 1: Speed = 0.0f; break;			// 插值速度为0直接取目标值
+			case 2: Speed = -3.0f; break;			// 插值速度为负同上
+			case 3: To = From + 5.e-5f; break;		// 距离平方小于SmallNumber直接取目标值
+			case 4: Speed = 1000.0f; break;			// 一步越过目标时停在目标值
+			default: break;
+			}
+			Current.Add(From);
+			Target.Add(To);
+			InterpSpeed.Add(Speed);
+		}
+
+		for (int32 Num = 0; Num <= MaxNum; ++Num)
+		{
+			TArray<float> Batched = Current;
+			LocomotionMathBatch::InterpTo(Batched.GetData(), Target.GetData(), InterpSpeed.GetData(), DeltaTime, Num);
+			for (int32 Index = 0; Index < MaxNum; ++Index)
+			{
+				// Num之后的元素不能被改写
+				const float Expected = Index < Num ? LocomotionMath::FInterpTo(Current[Index], Target[Index], DeltaTime, InterpSpeed[Index]) : Current[Index];
+				if (!IsNear(Batched[Index], Expected))
+				{
+					Test.AddError(FString::Printf(TEXT("InterpTo Num=%d Index=%d DeltaTime=%f: %.9g, expected %.9g"), Num, Index, DeltaTime, Batched[Index], Expected));
+				}
+			}
+		}
+	}
+
+	void TestVelocityBlend(FAutomationTestBase& Test)
+	{
+		FRandomStream Random(2);
+		TArray<float> X, Y, Z;
+		for (int32 Index = 0; Index < MaxNum; ++Index)
+		{
+			FVector3f Velocity = FVector3f(Random.VRand()) * Random.FRandRange(10.0f, 700.0f);
+			switch (Index % 5)
+			{
+			case 1: Velocity = FVector3f::ZeroVector; break;				// 静止
+			case 2: Velocity = FVector3f(1.e-10f, -1.e-10f, 0.0f); break;	// 小于SmallNumber按静止处理
+			case 3: Velocity = FVector3f(0.0f, 0.0f, -400.0f); break;		// 只有竖直速度
+			case 4: Velocity = FVector3f(-300.0f, 300.0f, 0.0f); break;		// 斜向
+			default: break;
+			}
+			X.Add(Velocity.X);
+			Y.Add(Velocity.Y);
+			Z.Add(Velocity.Z);
+		}
+
+		for (int32 Num = 0; Num <= MaxNum; ++Num)
+		{
+			TArray<float> F, B, L, R;
+			F.Init(0.0f, Num);
+			B.Init(0.0f, Num);
+			L.Init(0.0f, Num);
+			R.Init(0.0f, Num);
+			LocomotionMathBatch::VelocityBlend(X.GetData(), Y.GetData(), Z.GetData(), F.GetData(), B.GetData(), L.GetData(), R.GetData(), Num);
+			for (int32 Index = 0; Index < Num; ++Index)
+			{
+				// 与UAnimInstanceBase::CalculateVelocityBlend一样先归一化再分配权重
+				const FVector3f Direction = FVector3f(X[Index], Y[Index], Z[Index]).GetSafeNormal();
+				const FBlend Expected = LocomotionMath::VelocityBlend<FBlend>(Direction.X, Direction.Y, Direction.Z);
+				if (!IsNear(F[Index], Expected.F) || !IsNear(B[Index], Expected.B) || !IsNear(L[Index], Expected.L) || !IsNear(R[Index], Expected.R))
+				{
+					Test.AddError(FString::Printf(TEXT("VelocityBlend Num=%d Index=%d: (%.9g, %.9g, %.9g, %.9g), expected (%.9g, %.9g, %.9g, %.9g)"), Num, Index,
+						F[Index], B[Index], L[Index], R[Index], Expected.F, Expected.B, Expected.L, Expected.R));
+				}
+			}
+		}
+	}
+
+	void TestRelativeAcceleration(FAutomationTestBase& Test)
+	{
+		FRandomStream Random(3);
+		TArray<float> AX, AY, AZ, VX, VY, VZ, MaxAcceleration, MaxBraking;
+		for (int32 Index = 0; Index < MaxNum; ++Index)
+		{
+			const FVector3f Direction(Random.VRand());
+			FVector3f Acceleration = Direction * Random.FRandRange(0.0f, 1500.0f);
+			FVector3f Velocity = FVector3f(Random.VRand()) * Random.FRandRange(0.0f, 600.0f);
+			float MaxAccel = 1500.0f;
+			float MaxBrake = 2048.0f;
+			switch (Index % 6)
+			{
+			case 1: Acceleration = Direction * 4000.0f; Velocity = Direction * 300.0f; break;	// 同向且超过MaxAcceleration
+			case 2: Acceleration = Direction * 5000.0f; Velocity = -Direction * 300.0f; break;	// 反向且超过MaxBrakingDeceleration
+			case 3: MaxAccel = 0.0f; MaxBrake = 0.0f; break;									// 上限为0
+			case 4: MaxAccel = 1.e-5f; MaxBrake = 1.e-5f; break;								// 上限小于KINDA_SMALL_NUMBER
+			case 5: Acceleration = FVector3f::ZeroVector; break;								// 没有加速度
+			default: break;
+			}
+			AX.Add(Acceleration.X);
+			AY.Add(Acceleration.Y);
+			AZ.Add(Acceleration.Z);
+			VX.Add(Velocity.X);
+			VY.Add(Velocity.Y);
+			VZ.Add(Velocity.Z);
+			MaxAcceleration.Add(MaxAccel);
+			MaxBraking.Add(MaxBrake);
+		}
+
+		for (int32 Num = 0; Num <= MaxNum; ++Num)
+		{
+			TArray<float> OutX, OutY, OutZ;
+			OutX.Init(0.0f, Num);
+			OutY.Init(0.0f, Num);
+			OutZ.Init(0.0f, Num);
+			LocomotionMathBatch::RelativeAcceleration(AX.GetData(), AY.GetData(), AZ.GetData(), VX.GetData(), VY.GetData(), VZ.GetData(),
+				MaxAcceleration.GetData(), MaxBraking.GetData(), OutX.GetData(), OutY.GetData(), OutZ.GetData(), Num);
+			for (int32 Index = 0; Index < Num; ++Index)
+			{
+				// 与UAnimInstanceBase::CalculateRelativeAccelerationAmount相同
+				const FVector3f Acceleration(AX[Index], AY[Index], AZ[Index]);
+				const FVector3f Velocity(VX[Index], VY[Index], VZ[Index]);
+				const float MaxSize = FVector3f::DotProduct(Acceleration, Velocity) > 0.0f ? MaxAcceleration[Index] : MaxBraking[Index];
+				const FVector3f Expected = MaxSize < KINDA_SMALL_NUMBER ? FVector3f::ZeroVector : Acceleration.GetClampedToMaxSize(MaxSize) / MaxSize;
+				if (!IsNear(OutX[Index], Expected.X) || !IsNear(OutY[Index], Expected.Y) || !IsNear(OutZ[Index], Expected.Z))
+				{
+					Test.AddError(FString::Printf(TEXT("RelativeAcceleration Num=%d Index=%d: (%.9g, %.9g, %.9g), expected (%.9g, %.9g, %.9g)"), Num, Index,
+						OutX[Index], OutY[Index], OutZ[Index], Expected.X, Expected.Y, Expected.Z));
+				}
+			}
+		}
+	}
+}
+
+/**
+ * LocomotionMathBatch与标量版本的对比，输入固定，覆盖不足4个的尾部和各个特殊分支。
+ * 可以在Session Frontend里运行，或用-run=LocomotionBenchmark -TestBatchMath在构建机上运行。
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLocomotionMathBatchTest, "AnimationProject.Locomotion.MathBatch",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FLocomotionMathBatchTest::RunTest(const FString& Parameters)
+{
+	LocomotionMathBatchTest::TestInterpTo(*this, 1.0f / 60.0f);
+	LocomotionMathBatchTest::TestInterpTo(*this, 0.5f);
+	LocomotionMathBatchTest::TestInterpTo(*this, -0.1f);
+	LocomotionMathBatchTest::TestVelocityBlend(*this);
+	LocomotionMathBatchTest::TestRelativeAcceleration(*this);
+	return !HasAnyErrors();
+}
+
+#endif
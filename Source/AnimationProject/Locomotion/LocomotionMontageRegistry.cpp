@@ -0,0 +1,70 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "LocomotionMontageRegistry.h"
+#include "Animation/AnimMontage.h"
+
+FLocomotionMontageStart FLocomotionMontageStart::Make(uint8 InMontageId, float InPlayRate, float InStartPosition)
+{
+	FLocomotionMontageStart MontageStart;
+	MontageStart.MontageId = InMontageId;
+	MontageStart.StartPosition = static_cast<uint16>(FMath::Clamp(FMath::RoundToInt(InStartPosition * 1000.0f), 0, MAX_uint16));
+	MontageStart.PlayRate = static_cast<uint16>(FMath::Clamp(FMath::RoundToInt(InPlayRate * 1000.0f), 0, MAX_uint16));
+	return MontageStart;
+}
+
+bool FLocomotionMontageStart::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar << MontageId;
+	Ar << StartPosition;
+	Ar << PlayRate;
+	bOutSuccess = true;
+	return true;
+}
+
+uint8 ULocomotionMontageRegistry::GetMontageId(const UAnimMontage* Montage) const
+{
+	if (!IsValid(Montage))
+	{
+		return InvalidMontageId;
+	}
+	const uint8* MontageId = MontageIds.Find(FSoftObjectPath(Montage));
+	return MontageId ? *MontageId : InvalidMontageId;
+}
+
+const TSoftObjectPtr<UAnimMontage>& ULocomotionMontageRegistry::GetMontage(uint8 MontageId) const
+{
+	static const TSoftObjectPtr<UAnimMontage> NullMontage;
+	const int32 Index = static_cast<int32>(MontageId) - 1;
+	return Montages.IsValidIndex(Index) ? Montages[Index] : NullMontage;
+}
+
+void ULocomotionMontageRegistry::PostLoad()
+{
+	Super::PostLoad();
+
+	RebuildMontageIds();
+}
+
+#if WITH_EDITOR
+void ULocomotionMontageRegistry::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	RebuildMontageIds();
+}
+#endif
+
+void ULocomotionMontageRegistry::RebuildMontageIds()
+{
+	ensureMsgf(Montages.Num() <= MAX_uint8, TEXT("%s: only the first %d montages can be replicated"), *GetName(), MAX_uint8);
+
+	MontageIds.Reset();
+	const int32 NumIds = FMath::Min(Montages.Num(), static_cast<int32>(MAX_uint8));
+	for (int32 Index = 0; Index < NumIds; ++Index)
+	{
+		if (!Montages[Index].IsNull())
+		{
+			MontageIds.Add(Montages[Index].ToSoftObjectPath(), static_cast<uint8>(Index + 1));
+		}
+	}
+}
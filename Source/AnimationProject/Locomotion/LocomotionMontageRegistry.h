@@ -0,0 +1,79 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "LocomotionMontageRegistry.generated.h"
+
+class UAnimMontage;
+
+/**
+ * 蒙太奇开始播放的网络表示：(ID, 起始位置, 播放速率)。
+ * 起始位置和播放速率按毫秒/千分之一量化，整条消息只有5个字节。
+ */
+USTRUCT(BlueprintType)
+struct FLocomotionMontageStart
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint8 MontageId = 0;
+
+	UPROPERTY()
+	uint16 StartPosition = 0;
+
+	UPROPERTY()
+	uint16 PlayRate = 0;
+
+	/** 服务器接受客户端上报的最大播放速率，超出视为非法请求 */
+	static constexpr float MaxPlayRate = 10.0f;
+
+	static FLocomotionMontageStart Make(uint8 InMontageId, float InPlayRate, float InStartPosition);
+
+	float GetStartPosition() const { return StartPosition / 1000.0f; }
+	float GetPlayRate() const { return PlayRate / 1000.0f; }
+	bool IsValid() const { return MontageId != 0; }
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FLocomotionMontageStart> : public TStructOpsTypeTraitsBase2<FLocomotionMontageStart>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/**
+ * 所有端共享的运动蒙太奇表，按数组顺序给每个蒙太奇分配一个ID(从1开始，0表示无效)。
+ * 攀爬、翻滚、起身蒙太奇只用ID同步，接收端用同一份表解析，不会因为本地的OverlayState不同而选错动画。
+ */
+UCLASS(BlueprintType)
+class ULocomotionMontageRegistry : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	static constexpr uint8 InvalidMontageId = 0;
+
+	/** 顺序即ID，发布后只能在末尾追加，最多255个 */
+	UPROPERTY(EditDefaultsOnly, Category = Montage)
+	TArray<TSoftObjectPtr<UAnimMontage>> Montages;
+
+	uint8 GetMontageId(const UAnimMontage* Montage) const;
+	/** 只返回软引用，由ULocomotionMontageResidency取已加载的对象，ID无效时返回空引用 */
+	const TSoftObjectPtr<UAnimMontage>& GetMontage(uint8 MontageId) const;
+
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+	void RebuildMontageIds();
+
+	TMap<FSoftObjectPath, uint8> MontageIds;
+};
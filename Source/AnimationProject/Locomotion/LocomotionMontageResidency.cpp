@@ -0,0 +1,211 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "LocomotionMontageResidency.h"
+#include "Animation/AnimMontage.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+
+DECLARE_STATS_GROUP(TEXT("MontageResidency"), STATGROUP_MontageResidency, STATCAT_Advanced);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Resident Montages"), STAT_MontageResidencyResident, STATGROUP_MontageResidency);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Referenced Montages"), STAT_MontageResidencyReferenced, STATGROUP_MontageResidency);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Misses"), STAT_MontageResidencyMisses, STATGROUP_MontageResidency);
+DECLARE_MEMORY_STAT(TEXT("Resident Memory"), STAT_MontageResidencyMemory, STATGROUP_MontageResidency);
+
+DEFINE_LOG_CATEGORY_STATIC(LogMontageResidency, Log, All);
+
+static TAutoConsoleVariable<float> CVarMontageResidencyBudgetMB(
+	TEXT("Locomotion.MontageResidency.BudgetMB"),
+	32.0f,
+	TEXT("Memory kept for montages no character currently needs, montages in use are never evicted"));
+
+namespace LocomotionMontageResidency
+{
+	// 蒙太奇本身很小，主要是引用的动画序列
+	int64 GetMontageSize(const UAnimMontage* Montage)
+	{
+		int64 SizeBytes = Montage->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+		for (const FSlotAnimationTrack& SlotTrack : Montage->SlotAnimTracks)
+		{
+			for (const FAnimSegment& Segment : SlotTrack.AnimTrack.AnimSegments)
+			{
+				if (const UAnimSequenceBase* Sequence = Segment.GetAnimReference())
+				{
+					SizeBytes += Sequence->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+				}
+			}
+		}
+		return SizeBytes;
+	}
+}
+
+void ULocomotionMontageResidency::SetResidentMontages(const UObject* Owner, TArrayView<const TSoftObjectPtr<UAnimMontage>> Montages)
+{
+	TArray<FSoftObjectPath> NewPaths;
+	NewPaths.Reserve(Montages.Num());
+	for (const TSoftObjectPtr<UAnimMontage>& Montage : Montages)
+	{
+		if (!Montage.IsNull())
+		{
+			NewPaths.AddUnique(Montage.ToSoftObjectPath());
+		}
+	}
+
+	// 先加新引用再减旧引用，两组共有的蒙太奇不会被回收
+	TArray<FSoftObjectPath>& OwnerPaths = OwnerMontages.FindOrAdd(Owner);
+	for (const FSoftObjectPath& Path : NewPaths)
+	{
+		AddReference(Path);
+	}
+	for (const FSoftObjectPath& Path : OwnerPaths)
+	{
+		RemoveReference(Path);
+	}
+	OwnerPaths = MoveTemp(NewPaths);
+
+	TrimToBudget();
+	UpdateStats();
+}
+
+void ULocomotionMontageResidency::ReleaseResidentMontages(const UObject* Owner)
+{
+	TArray<FSoftObjectPath> OwnerPaths;
+	if (OwnerMontages.RemoveAndCopyValue(Owner, OwnerPaths))
+	{
+		for (const FSoftObjectPath& Path : OwnerPaths)
+		{
+			RemoveReference(Path);
+		}
+		TrimToBudget();
+		UpdateStats();
+	}
+}
+
+UAnimMontage* ULocomotionMontageResidency::GetResidentMontage(const TSoftObjectPtr<UAnimMontage>& Montage)
+{
+	if (Montage.IsNull())
+	{
+		return nullptr;
+	}
+
+	UAnimMontage* Loaded = Montage.Get();
+	if (Loaded == nullptr)
+	{
+		INC_DWORD_STAT(STAT_MontageResidencyMisses);
+		UE_LOG(LogMontageResidency, Verbose, TEXT("%s was needed before it finished streaming in"), *Montage.ToString());
+	}
+	return Loaded;
+}
+
+void ULocomotionMontageResidency::Deinitialize()
+{
+	TArray<FSoftObjectPath> Paths;
+	Residents.GetKeys(Paths);
+	for (const FSoftObjectPath& Path : Paths)
+	{
+		Evict(Path);
+	}
+	OwnerMontages.Reset();
+
+	Super::Deinitialize();
+}
+
+void ULocomotionMontageResidency::AddReference(const FSoftObjectPath& Path)
+{
+	FResidentMontage& Resident = Residents.FindOrAdd(Path);
+	if (++Resident.RefCount == 1 && !Resident.Handle.IsValid())
+	{
+		Resident.Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Path,
+			FStreamableDelegate::CreateUObject(this, &ULocomotionMontageResidency::OnMontageLoaded, Path),
+			FStreamableManager::AsyncLoadHighPriority);
+	}
+}
+
+void ULocomotionMontageResidency::RemoveReference(const FSoftObjectPath& Path)
+{
+	if (FResidentMontage* Resident = Residents.Find(Path))
+	{
+		if (--Resident->RefCount == 0)
+		{
+			Resident->ReleaseTime = GetWorld()->GetRealTimeSeconds();
+		}
+	}
+}
+
+void ULocomotionMontageResidency::OnMontageLoaded(FSoftObjectPath Path)
+{
+	FResidentMontage* Resident = Residents.Find(Path);
+	const UAnimMontage* Montage = Cast<UAnimMontage>(Path.ResolveObject());
+	if (Resident == nullptr || Montage == nullptr || Resident->SizeBytes > 0)
+	{
+		return;
+	}
+
+	Resident->SizeBytes = LocomotionMontageResidency::GetMontageSize(Montage);
+	ResidentBytes += Resident->SizeBytes;
+	TrimToBudget();
+	UpdateStats();
+}
+
+void ULocomotionMontageResidency::Evict(const FSoftObjectPath& Path)
+{
+	FResidentMontage Resident;
+	if (!Residents.RemoveAndCopyValue(Path, Resident))
+	{
+		return;
+	}
+
+	ResidentBytes -= Resident.SizeBytes;
+	if (Resident.Handle.IsValid())
+	{
+		if (Resident.Handle->IsLoadingInProgress())
+		{
+			Resident.Handle->CancelHandle();
+		}
+		else
+		{
+			Resident.Handle->ReleaseHandle();
+		}
+	}
+}
+
+void ULocomotionMontageResidency::TrimToBudget()
+{
+	const int64 BudgetBytes = static_cast<int64>(FMath::Max(CVarMontageResidencyBudgetMB.GetValueOnGameThread(), 0.0f) * 1024.0f * 1024.0f);
+	if (ResidentBytes <= BudgetBytes)
+	{
+		return;
+	}
+
+	// 只回收没有角色需要的，先回收最早释放的
+	TArray<TPair<double, FSoftObjectPath>> Unreferenced;
+	for (const TPair<FSoftObjectPath, FResidentMontage>& Pair : Residents)
+	{
+		if (Pair.Value.RefCount == 0)
+		{
+			Unreferenced.Emplace(Pair.Value.ReleaseTime, Pair.Key);
+		}
+	}
+	Unreferenced.Sort([](const TPair<double, FSoftObjectPath>& A, const TPair<double, FSoftObjectPath>& B) { return A.Key < B.Key; });
+
+	for (const TPair<double, FSoftObjectPath>& Entry : Unreferenced)
+	{
+		if (ResidentBytes <= BudgetBytes)
+		{
+			break;
+		}
+		Evict(Entry.Value);
+	}
+}
+
+void ULocomotionMontageResidency::UpdateStats() const
+{
+	int32 NumReferenced = 0;
+	for (const TPair<FSoftObjectPath, FResidentMontage>& Pair : Residents)
+	{
+		NumReferenced += Pair.Value.RefCount > 0 ? 1 : 0;
+	}
+	SET_DWORD_STAT(STAT_MontageResidencyResident, Residents.Num());
+	SET_DWORD_STAT(STAT_MontageResidencyReferenced, NumReferenced);
+	SET_MEMORY_STAT(STAT_MontageResidencyMemory, ResidentBytes);
+}
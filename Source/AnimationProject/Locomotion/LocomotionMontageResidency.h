@@ -0,0 +1,52 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "LocomotionMontageResidency.generated.h"
+
+class UAnimMontage;
+struct FStreamableHandle;
+
+/**
+ * 起身、翻滚、攀爬蒙太奇的常驻管理。每个角色按当前的OverlayState和姿态登记需要的蒙太奇，
+ * 管理器异步加载并按引用计数保持常驻，需要播放时只取已加载的对象，不会同步加载。
+ * 引用计数为0的蒙太奇在Locomotion.MontageResidency.BudgetMB内继续保留，超出时先回收最早释放的。
+ */
+UCLASS()
+class ULocomotionMontageResidency : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** 替换Owner需要常驻的蒙太奇，新加入的立即开始异步加载 */
+	void SetResidentMontages(const UObject* Owner, TArrayView<const TSoftObjectPtr<UAnimMontage>> Montages);
+	void ReleaseResidentMontages(const UObject* Owner);
+
+	/** 只返回已经加载的蒙太奇，未加载时返回空并计为一次未命中 */
+	UAnimMontage* GetResidentMontage(const TSoftObjectPtr<UAnimMontage>& Montage);
+
+	virtual void Deinitialize() override;
+
+private:
+	struct FResidentMontage
+	{
+		TSharedPtr<FStreamableHandle> Handle;
+		int32 RefCount = 0;
+		int64 SizeBytes = 0;
+		double ReleaseTime = 0.0;
+	};
+
+	void AddReference(const FSoftObjectPath& Path);
+	void RemoveReference(const FSoftObjectPath& Path);
+	void OnMontageLoaded(FSoftObjectPath Path);
+	void Evict(const FSoftObjectPath& Path);
+	void TrimToBudget();
+	void UpdateStats() const;
+
+	TMap<FSoftObjectPath, FResidentMontage> Residents;
+	TMap<TObjectKey<UObject>, TArray<FSoftObjectPath>> OwnerMontages;
+	int64 ResidentBytes = 0;
+};
@@ -0,0 +1,165 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "LocomotionProfiler.h"
+#include "HAL/MemoryBase.h"
+
+bool FLocomotionProfiler::bEnabled = false;
+std::atomic<uint64> FLocomotionProfiler::ScopeCycles[FLocomotionProfiler::NumScopes] = {};
+
+namespace LocomotionProfiler
+{
+	std::atomic<bool> bCountAllocations { false };
+	std::atomic<uint32> ScopeAllocations[FLocomotionProfiler::NumScopes] = {};
+	thread_local int32 CurrentAllocationScope = INDEX_NONE;
+
+	/**
+	 * 转发所有调用给原来的GMalloc，当前线程处于运动作用域时记录Malloc和增长的Realloc。
+	 * 只在统计期间替换GMalloc，结束后换回原分配器。包装对象本身不释放，
+	 * 其他线程在切换前后读到的任一指针最终都由原分配器处理，不需要与它们同步。
+	 */
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+		explicit FCountingMalloc(FMalloc* InInner)
+			: Inner(InInner)
+		{
+		}
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->TryMalloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if (Count > 0)
+			{
+				CountAllocation();
+			}
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if (Count > 0)
+			{
+				CountAllocation();
+			}
+			return Inner->TryRealloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override { Inner->Free(Original); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+		virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual void InitializeStatsMetadata() override { Inner->InitializeStatsMetadata(); }
+		virtual void UpdateStats() override { Inner->UpdateStats(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override { Inner->DumpAllocatorStats(Ar); }
+		virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+		virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+
+	private:
+		static void CountAllocation()
+		{
+			if (CurrentAllocationScope != INDEX_NONE && bCountAllocations.load(std::memory_order_relaxed))
+			{
+				ScopeAllocations[CurrentAllocationScope].fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		FMalloc* Inner;
+	};
+}
+
+void FLocomotionProfiler::SetCountAllocations(bool bInCountAllocations)
+{
+	using namespace LocomotionProfiler;
+	check(IsInGameThread());
+	if (bInCountAllocations == bCountAllocations.load())
+	{
+		return;
+	}
+
+	static FMalloc* const OriginalMalloc = GMalloc;
+	static FCountingMalloc* const CountingMalloc = new FCountingMalloc(OriginalMalloc);
+	if (bInCountAllocations)
+	{
+		// 原分配器已被别的包装替换时不安装，否则释放时会交给错误的分配器
+		if (!ensureMsgf(GMalloc == OriginalMalloc, TEXT("GMalloc changed since allocation counting was first enabled")))
+		{
+			return;
+		}
+		GMalloc = CountingMalloc;
+		bCountAllocations = true;
+	}
+	else
+	{
+		bCountAllocations = false;
+		if (GMalloc == CountingMalloc)
+		{
+			GMalloc = OriginalMalloc;
+		}
+		else
+		{
+			// 统计期间又有别的包装装在外层，只能保留计数包装，计数已经关闭
+			ensureMsgf(false, TEXT("GMalloc was wrapped again while counting allocations, leaving the counting wrapper in place"));
+		}
+	}
+}
+
+void FLocomotionProfiler::ConsumeAllocations(uint32 OutAllocations[NumScopes])
+{
+	for (int32 Index = 0; Index < NumScopes; ++Index)
+	{
+		OutAllocations[Index] = LocomotionProfiler::ScopeAllocations[Index].exchange(0, std::memory_order_relaxed);
+	}
+}
+
+int32 FLocomotionProfiler::EnterAllocationScope(ELocomotionProfileScope Scope)
+{
+	const int32 PreviousScope = LocomotionProfiler::CurrentAllocationScope;
+	LocomotionProfiler::CurrentAllocationScope = static_cast<int32>(Scope);
+	return PreviousScope;
+}
+
+void FLocomotionProfiler::LeaveAllocationScope(int32 PreviousScope)
+{
+	LocomotionProfiler::CurrentAllocationScope = PreviousScope;
+}
+
+void FLocomotionProfiler::ConsumeMilliseconds(double OutMilliseconds[NumScopes])
+{
+	for (int32 Index = 0; Index < NumScopes; ++Index)
+	{
+		OutMilliseconds[Index] = FPlatformTime::ToMilliseconds64(ScopeCycles[Index].exchange(0, std::memory_order_relaxed));
+	}
+}
+
+const TCHAR* FLocomotionProfiler::GetScopeName(ELocomotionProfileScope Scope)
+{
+	switch (Scope)
+	{
+	case ELocomotionProfileScope::CharacterTick: return TEXT("CharacterTick");
+	case ELocomotionProfileScope::CharacterMovement: return TEXT("CharacterMovement");
+	case ELocomotionProfileScope::EssentialValues: return TEXT("EssentialValues");
+	case ELocomotionProfileScope::GroundedUpdate: return TEXT("GroundedUpdate");
+	case ELocomotionProfileScope::InAirUpdate: return TEXT("InAirUpdate");
+	case ELocomotionProfileScope::Ragdoll: return TEXT("Ragdoll");
+	case ELocomotionProfileScope::CacheValues: return TEXT("CacheValues");
+	case ELocomotionProfileScope::AnimUpdate: return TEXT("AnimUpdate");
+	case ELocomotionProfileScope::FootIK: return TEXT("FootIK");
+	case ELocomotionProfileScope::AnimBatch: return TEXT("AnimBatch");
+	default: return TEXT("Unknown");
+	}
+}
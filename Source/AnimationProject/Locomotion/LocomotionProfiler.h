@@ -0,0 +1,88 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+enum class ELocomotionProfileScope : uint8
+{
+	// 整个角色Tick，包含下面嵌套作用域的耗时，分配只计入不属于其他作用域的部分
+	CharacterTick,
+	CharacterMovement,
+	EssentialValues,
+	GroundedUpdate,
+	InAirUpdate,
+	Ragdoll,
+	CacheValues,
+	AnimUpdate,
+	FootIK,
+	AnimBatch,
+	Num
+};
+
+/**
+ * 运动各子系统的耗时累加，只在基准测试等需要时开启，关闭时每个作用域只多一次判断。
+ * 动画更新可能在工作线程执行，所以累加使用原子操作。
+ * 开启分配统计后还会记录各作用域内的堆分配次数，嵌套的作用域只计入最内层。
+ */
+struct FLocomotionProfiler
+{
+	static constexpr int32 NumScopes = static_cast<int32>(ELocomotionProfileScope::Num);
+
+	static void SetEnabled(bool bInEnabled) { bEnabled = bInEnabled; }
+	/** 开启时在GMalloc外包一层计数，关闭时换回原来的GMalloc，只能在游戏线程调用 */
+	static void SetCountAllocations(bool bInCountAllocations);
+	static bool IsEnabled() { return bEnabled; }
+
+	static void AddCycles(ELocomotionProfileScope Scope, uint64 Cycles)
+	{
+		ScopeCycles[static_cast<int32>(Scope)].fetch_add(Cycles, std::memory_order_relaxed);
+	}
+
+	/** 取出上次调用以来的累计耗时(毫秒)并清零 */
+	static void ConsumeMilliseconds(double OutMilliseconds[NumScopes]);
+	/** 取出上次调用以来的分配次数并清零 */
+	static void ConsumeAllocations(uint32 OutAllocations[NumScopes]);
+
+	/** 由FLocomotionProfileScopeTimer调用，返回外层作用域用于退出时恢复 */
+	static int32 EnterAllocationScope(ELocomotionProfileScope Scope);
+	static void LeaveAllocationScope(int32 PreviousScope);
+
+	static const TCHAR* GetScopeName(ELocomotionProfileScope Scope);
+
+private:
+	static bool bEnabled;
+	static std::atomic<uint64> ScopeCycles[NumScopes];
+};
+
+class FLocomotionProfileScopeTimer
+{
+public:
+	explicit FLocomotionProfileScopeTimer(ELocomotionProfileScope InScope)
+		: Scope(InScope)
+		, StartCycles(FLocomotionProfiler::IsEnabled() ? FPlatformTime::Cycles64() : 0)
+	{
+		if (StartCycles != 0)
+		{
+			PreviousAllocationScope = FLocomotionProfiler::EnterAllocationScope(Scope);
+		}
+	}
+
+	~FLocomotionProfileScopeTimer()
+	{
+		if (StartCycles != 0)
+		{
+			FLocomotionProfiler::LeaveAllocationScope(PreviousAllocationScope);
+			FLocomotionProfiler::AddCycles(Scope, FPlatformTime::Cycles64() - StartCycles);
+		}
+	}
+
+private:
+	ELocomotionProfileScope Scope;
+	uint64 StartCycles;
+	int32 PreviousAllocationScope = INDEX_NONE;
+};
+
+#define LOCOMOTION_PROFILE_SCOPE(Scope) \
+	FLocomotionProfileScopeTimer ANONYMOUS_VARIABLE(LocomotionProfileScope)(ELocomotionProfileScope::Scope)
@@ -0,0 +1,273 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "LocomotionRecorder.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogLocomotionRecorder, Log, All);
+
+const FName FLocomotionRecordFrame::CurveNames[FLocomotionRecordFrame::NumCurves] =
+{
+	FName("YawOffset"),
+	FName("RotationAmount"),
+	FName("Enable_FootIK_L"),
+	FName("Enable_FootIK_R"),
+	FName("FootLock_L"),
+	FName("FootLock_R"),
+	FName("Weight_Gait"),
+	FName("Mask_AimOffset"),
+};
+
+/**
+ * 所有录制器共享的写文件线程，轮询每个录制器的环形缓冲区并批量写入。
+ */
+class FLocomotionRecordWriter : public FRunnable
+{
+public:
+	static FLocomotionRecordWriter& Get()
+	{
+		static FLocomotionRecordWriter* Writer = nullptr;
+		if (Writer == nullptr)
+		{
+			Writer = new FLocomotionRecordWriter();
+			FCoreDelegates::OnPreExit.AddLambda([]()
+			{
+				delete Writer;
+				Writer = nullptr;
+			});
+		}
+		return *Writer;
+	}
+
+	void Add(const TSharedPtr<FLocomotionRecorder, ESPMode::ThreadSafe>& Recorder)
+	{
+		FScopeLock Lock(&RecordersLock);
+		Recorders.Add(Recorder);
+		WakeUp->Trigger();
+	}
+
+	void Flush()
+	{
+		WakeUp->Trigger();
+	}
+
+	virtual uint32 Run() override
+	{
+		while (!bStopping)
+		{
+			DrainAll();
+			WakeUp->Wait(FTimespan::FromMilliseconds(10.0));
+		}
+		DrainAll();
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		bStopping = true;
+		WakeUp->Trigger();
+	}
+
+private:
+	FLocomotionRecordWriter()
+	{
+		WakeUp = FPlatformProcess::GetSynchEventFromPool(false);
+		Thread = FRunnableThread::Create(this, TEXT("LocomotionRecordWriter"), 0, TPri_BelowNormal);
+	}
+
+	virtual ~FLocomotionRecordWriter() override
+	{
+		if (Thread)
+		{
+			Thread->Kill(true);
+			delete Thread;
+		}
+		FPlatformProcess::ReturnSynchEventToPool(WakeUp);
+	}
+
+	void DrainAll()
+	{
+		FScopeLock Lock(&RecordersLock);
+		for (int32 Index = Recorders.Num() - 1; Index >= 0; --Index)
+		{
+			if (!Recorders[Index]->Drain())
+			{
+				Recorders.RemoveAtSwap(Index);
+			}
+		}
+	}
+
+	FRunnableThread* Thread = nullptr;
+	FEvent* WakeUp = nullptr;
+	std::atomic<bool> bStopping { false };
+	FCriticalSection RecordersLock;
+	TArray<TSharedPtr<FLocomotionRecorder, ESPMode::ThreadSafe>> Recorders;
+};
+
+TSharedPtr<FLocomotionRecorder, ESPMode::ThreadSafe> FLocomotionRecorder::Start(const FString& Filename, const FString& CharacterName)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Filename));
+	IFileHandle* FileHandle = PlatformFile.OpenWrite(*Filename);
+	if (FileHandle == nullptr)
+	{
+		UE_LOG(LogLocomotionRecorder, Warning, TEXT("Failed to open %s for recording"), *Filename);
+		return nullptr;
+	}
+
+	FLocomotionRecordHeader Header;
+	FCStringAnsi::Strncpy(Header.CharacterName, TCHAR_TO_ANSI(*CharacterName), UE_ARRAY_COUNT(Header.CharacterName));
+	FileHandle->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+
+	TSharedPtr<FLocomotionRecorder, ESPMode::ThreadSafe> Recorder = MakeShareable(new FLocomotionRecorder(FileHandle));
+	FLocomotionRecordWriter::Get().Add(Recorder);
+	return Recorder;
+}
+
+FLocomotionRecorder::FLocomotionRecorder(IFileHandle* InFileHandle)
+	: Frames(RingCapacity)
+	, FileHandle(InFileHandle)
+{
+}
+
+FLocomotionRecorder::~FLocomotionRecorder()
+{
+	if (NumDroppedFrames > 0)
+	{
+		UE_LOG(LogLocomotionRecorder, Warning, TEXT("Recording dropped %u frames, the writer thread could not keep up"), NumDroppedFrames);
+	}
+}
+
+void FLocomotionRecorder::RecordFrame(FLocomotionRecordFrame Frame)
+{
+	if (bStopRequested)
+	{
+		return;
+	}
+
+	Frame.FrameIndex = NextFrameIndex++;
+	if (!Frames.Enqueue(Frame))
+	{
+		++NumDroppedFrames;
+	}
+}
+
+void FLocomotionRecorder::Stop()
+{
+	bStopRequested = true;
+	FLocomotionRecordWriter::Get().Flush();
+}
+
+bool FLocomotionRecorder::Drain()
+{
+	// Stop标记必须在取帧之前读取，保证Stop之前入队的帧都会写完
+	const bool bFinishing = bStopRequested;
+
+	constexpr int32 BatchSize = 64;
+	FLocomotionRecordFrame Batch[BatchSize];
+	int32 NumBatched = 0;
+	while (Frames.Dequeue(Batch[NumBatched]))
+	{
+		if (++NumBatched == BatchSize)
+		{
+			FileHandle->Write(reinterpret_cast<const uint8*>(Batch), sizeof(Batch));
+			NumBatched = 0;
+		}
+	}
+	if (NumBatched > 0)
+	{
+		FileHandle->Write(reinterpret_cast<const uint8*>(Batch), NumBatched * sizeof(FLocomotionRecordFrame));
+	}
+
+	if (bFinishing)
+	{
+		FileHandle->Flush();
+		FileHandle.Reset();
+		return false;
+	}
+	return true;
+}
+
+FLocomotionRecordReader::~FLocomotionRecordReader()
+{
+	Close();
+}
+
+bool FLocomotionRecordReader::Open(const FString& Filename)
+{
+	Close();
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (!MappedFile.IsValid() || MappedFile->GetFileSize() < static_cast<int64>(sizeof(FLocomotionRecordHeader)))
+	{
+		Close();
+		return false;
+	}
+
+	MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	if (!MappedRegion.IsValid())
+	{
+		Close();
+		return false;
+	}
+
+	const uint8* Data = MappedRegion->GetMappedPtr();
+	Header = reinterpret_cast<const FLocomotionRecordHeader*>(Data);
+	if (Header->Magic != FLocomotionRecordHeader::FileMagic
+		|| Header->Version != FLocomotionRecordHeader::CurrentVersion
+		|| Header->FrameSize != sizeof(FLocomotionRecordFrame))
+	{
+		UE_LOG(LogLocomotionRecorder, Warning, TEXT("%s is not a compatible locomotion recording"), *Filename);
+		Close();
+		return false;
+	}
+
+	Frames = reinterpret_cast<const FLocomotionRecordFrame*>(Data + sizeof(FLocomotionRecordHeader));
+	NumFrames = static_cast<int32>((MappedRegion->GetMappedSize() - sizeof(FLocomotionRecordHeader)) / sizeof(FLocomotionRecordFrame));
+	return true;
+}
+
+void FLocomotionRecordReader::Close()
+{
+	Header = nullptr;
+	Frames = nullptr;
+	NumFrames = 0;
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+const FLocomotionRecordFrame& FLocomotionRecordReader::GetFrame(int32 FrameIndex) const
+{
+	check(Frames != nullptr && FrameIndex >= 0 && FrameIndex < NumFrames);
+	return Frames[FrameIndex];
+}
+
+int32 FLocomotionRecordReader::FindFrameAtTime(float Time) const
+{
+	if (NumFrames == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	// 帧按时间递增写入，二分查找
+	int32 Low = 0;
+	int32 High = NumFrames - 1;
+	while (Low < High)
+	{
+		const int32 Mid = (Low + High + 1) / 2;
+		if (Frames[Mid].WorldTime <= Time)
+		{
+			Low = Mid;
+		}
+		else
+		{
+			High = Mid - 1;
+		}
+	}
+	return Low;
+}
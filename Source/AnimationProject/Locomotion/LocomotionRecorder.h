@@ -0,0 +1,147 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/CircularQueue.h"
+#include <atomic>
+
+class IFileHandle;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+enum class ELocomotionTraceFlags : uint8
+{
+	None = 0,
+	MantleForwardHit = 1 << 0,
+	MantleWalkableHit = 1 << 1,
+	MantleHasRoom = 1 << 2,
+	RagdollGroundHit = 1 << 3,
+};
+ENUM_CLASS_FLAGS(ELocomotionTraceFlags);
+
+enum class ELocomotionStateFlags : uint8
+{
+	None = 0,
+	IsMoving = 1 << 0,
+	HasMovementInput = 1 << 1,
+	RagdollFaceUp = 1 << 2,
+	RagdollOnGround = 1 << 3,
+	JumpPressed = 1 << 4,
+};
+ENUM_CLASS_FLAGS(ELocomotionStateFlags);
+
+/**
+ * 录制文件中的一帧，固定144字节，直接按内存布局写入文件，读取时映射后按下标访问。
+ * 修改布局时需要提升FLocomotionRecordHeader::CurrentVersion。
+ */
+struct FLocomotionRecordFrame
+{
+	static constexpr int32 NumCurves = 8;
+	static const FName CurveNames[NumCurves];
+
+	uint32 FrameIndex = 0;
+	float WorldTime = 0.0f;
+	float DeltaSeconds = 0.0f;
+	FVector3f Location = FVector3f::ZeroVector;
+	FVector3f Velocity = FVector3f::ZeroVector;
+	FVector3f Acceleration = FVector3f::ZeroVector;
+	FVector3f MovementInput = FVector3f::ZeroVector;
+	// Move/Look输入动作的原始值，用于回放
+	FVector2f MoveInput = FVector2f::ZeroVector;
+	FVector2f LookInput = FVector2f::ZeroVector;
+	float ActorYaw = 0.0f;
+	float ControlYaw = 0.0f;
+	float ControlPitch = 0.0f;
+	float Speed = 0.0f;
+	float MovementInputAmount = 0.0f;
+	float AimYawRate = 0.0f;
+	float Curves[NumCurves] = {};
+	uint8 MovementMode = 0;
+	uint8 MovementState = 0;
+	uint8 MovementAction = 0;
+	uint8 Gait = 0;
+	uint8 Stance = 0;
+	uint8 RotationMode = 0;
+	uint8 ViewMode = 0;
+	uint8 OverlayState = 0;
+	ELocomotionTraceFlags TraceFlags = ELocomotionTraceFlags::None;
+	ELocomotionStateFlags StateFlags = ELocomotionStateFlags::None;
+	uint8 Padding[2] = {};
+};
+static_assert(sizeof(FLocomotionRecordFrame) == 144, "FLocomotionRecordFrame layout is part of the file format");
+
+struct FLocomotionRecordHeader
+{
+	static constexpr uint32 FileMagic = 0x524F434C; // 'LOCR'
+	static constexpr uint16 CurrentVersion = 2;
+
+	uint32 Magic = FileMagic;
+	uint16 Version = CurrentVersion;
+	uint16 FrameSize = sizeof(FLocomotionRecordFrame);
+	uint32 NumCurves = FLocomotionRecordFrame::NumCurves;
+	uint32 Reserved = 0;
+	ANSICHAR CharacterName[48] = {};
+};
+static_assert(sizeof(FLocomotionRecordHeader) == 64, "FLocomotionRecordHeader layout is part of the file format");
+
+/**
+ * 单个角色的录制器。游戏线程只把帧写入无锁环形缓冲区，写文件由共享的后台线程完成。
+ * 缓冲区满时丢弃新帧并计数，不会阻塞游戏线程。
+ */
+class FLocomotionRecorder
+{
+public:
+	static constexpr uint32 RingCapacity = 1024;
+
+	static TSharedPtr<FLocomotionRecorder, ESPMode::ThreadSafe> Start(const FString& Filename, const FString& CharacterName);
+
+	~FLocomotionRecorder();
+
+	/** 只能在游戏线程调用，FrameIndex由录制器填写 */
+	void RecordFrame(FLocomotionRecordFrame Frame);
+
+	/** 停止录制，剩余的帧由后台线程写完后关闭文件 */
+	void Stop();
+
+	uint32 GetNumDroppedFrames() const { return NumDroppedFrames; }
+
+private:
+	friend class FLocomotionRecordWriter;
+
+	FLocomotionRecorder(IFileHandle* InFileHandle);
+
+	/** 只在后台线程调用，返回false表示录制已结束并写完 */
+	bool Drain();
+
+	TCircularQueue<FLocomotionRecordFrame> Frames;
+	TUniquePtr<IFileHandle> FileHandle;
+	uint32 NextFrameIndex = 0;
+	uint32 NumDroppedFrames = 0;
+	std::atomic<bool> bStopRequested { false };
+};
+
+/** 映射录制文件，按帧下标或时间直接访问，不需要读入整个文件 */
+class FLocomotionRecordReader
+{
+public:
+	~FLocomotionRecordReader();
+
+	bool Open(const FString& Filename);
+	void Close();
+
+	bool IsOpen() const { return Frames != nullptr; }
+	const FLocomotionRecordHeader& GetHeader() const { return *Header; }
+	int32 GetNumFrames() const { return NumFrames; }
+	const FLocomotionRecordFrame& GetFrame(int32 FrameIndex) const;
+
+	/** 返回WorldTime不大于Time的最后一帧，用于回放跳转 */
+	int32 FindFrameAtTime(float Time) const;
+
+private:
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	const FLocomotionRecordHeader* Header = nullptr;
+	const FLocomotionRecordFrame* Frames = nullptr;
+	int32 NumFrames = 0;
+};
@@ -0,0 +1,162 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "LocomotionSnapshot.h"
+
+namespace LocomotionSnapshot
+{
+	// 枚举按实际取值范围写入，FBitWriter下只占用必要的位数
+	template<typename EnumType>
+	void SerializeEnum(FArchive& Ar, EnumType& Value)
+	{
+		static const uint32 ValueMax = static_cast<uint32>(StaticEnum<EnumType>()->GetMaxEnumValue());
+		uint32 RawValue = static_cast<uint32>(Value);
+		Ar.SerializeInt(RawValue, ValueMax);
+		Value = static_cast<EnumType>(RawValue);
+	}
+
+	void SerializeEnum(FArchive& Ar, TEnumAsByte<EMovementMode>& Value)
+	{
+		EMovementMode RawValue = Value.GetValue();
+		SerializeEnum(Ar, RawValue);
+		Value = RawValue;
+	}
+
+	void SerializeBool(FArchive& Ar, bool& Value)
+	{
+		uint8 Bit = Value ? 1 : 0;
+		Ar.SerializeBits(&Bit, 1);
+		Value = Bit != 0;
+	}
+}
+
+void FCharacterLocomotionSnapshot::Serialize(FArchive& Ar)
+{
+	using namespace LocomotionSnapshot;
+
+	SerializeEnum(Ar, MovementMode);
+	SerializeEnum(Ar, MovementState);
+	SerializeEnum(Ar, PreviousMovementState);
+	SerializeEnum(Ar, MovementAction);
+	SerializeEnum(Ar, PreviousMovementAction);
+	SerializeEnum(Ar, RotationMode);
+	SerializeEnum(Ar, DesiredRotationMode);
+	SerializeEnum(Ar, Gait);
+	SerializeEnum(Ar, AllowedGait);
+	SerializeEnum(Ar, ActualGait);
+	SerializeEnum(Ar, PreviousActualGait);
+	SerializeEnum(Ar, DesiredGait);
+	SerializeEnum(Ar, Stance);
+	SerializeEnum(Ar, PreviousStance);
+	SerializeEnum(Ar, DesiredStance);
+	SerializeEnum(Ar, ViewMode);
+	SerializeEnum(Ar, OverlayState);
+
+	SerializeBool(Ar, RightShoulder);
+	SerializeBool(Ar, IsMoving);
+	SerializeBool(Ar, HasMovementInput);
+	SerializeBool(Ar, RagdollFaceUp);
+	SerializeBool(Ar, RagdollOnGround);
+	SerializeBool(Ar, BreakFall);
+
+	Ar << Speed;
+	Ar << MovementInputAmount;
+	Ar << PreviousAimYaw;
+	Ar << AimYawRate;
+
+	Ar << Velocity;
+	Ar << Acceleration;
+	Ar << PreviousVelocity;
+	Ar << LastRagdollVelocity;
+
+	Ar << TargetRotation;
+	Ar << LastVelocityRotation;
+	Ar << LastMovementInputRotation;
+	Ar << InAirRotation;
+
+	// 不在攀爬中时不需要攀爬参数
+	if (MovementState == EMovementState::Mantling)
+	{
+		Ar << MantleMontageId;
+		Ar << MantleStartingPosition;
+		Ar << MantlePlayRate;
+		Ar << MantleLowHeight;
+		Ar << MantleStartingOffset;
+		Ar << MantleTarget;
+		Ar << MantleActualStartOffset;
+		Ar << MantleAnimatedStartOffset;
+		Ar << MantleTimelineLength;
+		Ar << MantleTimelinePosition;
+		Ar << MantleMontagePosition;
+	}
+}
+
+void FAnimLocomotionSnapshot::Serialize(FArchive& Ar)
+{
+	using namespace LocomotionSnapshot;
+
+	SerializeEnum(Ar, MovementDirection);
+	SerializeEnum(Ar, TrackedHipsDirection);
+	SerializeEnum(Ar, GroundEntryState);
+
+	SerializeBool(Ar, bShouldMove);
+	SerializeBool(Ar, bRotateL);
+	SerializeBool(Ar, bRotateR);
+	SerializeBool(Ar, bPivot);
+	SerializeBool(Ar, bJumped);
+
+	Ar << RotateRate;
+	Ar << ElapsedDelayTime;
+	Ar << InputYawOffsetTime;
+	Ar << FallSpeed;
+	Ar << LandPrediction;
+	Ar << FlailRate;
+	Ar << DiagonalScaleAmount;
+	Ar << WalkRunBlend;
+	Ar << StrideBlend;
+	Ar << StandingPlayRate;
+	Ar << CrouchingPlayRate;
+	Ar << RotationScale;
+	Ar << PelvisAlpha;
+	Ar << FootLockLAlpha;
+	Ar << FootLockRAlpha;
+
+	Ar << VelocityBlend.F;
+	Ar << VelocityBlend.B;
+	Ar << VelocityBlend.L;
+	Ar << VelocityBlend.R;
+	Ar << LeanAmount.LR;
+	Ar << LeanAmount.FB;
+
+	Ar << SmoothedAimingRotation;
+	Ar << RelativeAccelerationAmount;
+	Ar << FootLockLLocation;
+	Ar << FootLockLRotation;
+	Ar << FootLockRLocation;
+	Ar << FootLockRRotation;
+	Ar << FootOffsetLTarget;
+	Ar << FootOffsetLLocation;
+	Ar << FootOffsetLRotation;
+	Ar << FootOffsetRTarget;
+	Ar << FootOffsetRLocation;
+	Ar << FootOffsetRRotation;
+	Ar << PelvisOffset;
+}
+
+bool FLocomotionSnapshot::Serialize(FArchive& Ar)
+{
+	Ar << Version;
+	if (Ar.IsLoading() && Version != CurrentVersion)
+	{
+		Ar.SetError();
+		return false;
+	}
+
+	Character.Serialize(Ar);
+
+	LocomotionSnapshot::SerializeBool(Ar, bHasAnimSnapshot);
+	if (bHasAnimSnapshot)
+	{
+		Anim.Serialize(Ar);
+	}
+	return !Ar.IsError();
+}
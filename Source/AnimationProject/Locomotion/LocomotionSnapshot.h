@@ -0,0 +1,142 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "LocomotionDefine.h"
+
+class UPrimitiveComponent;
+
+/**
+ * ACharacterBase的运动状态快照，固定大小、不分配内存，用于回滚、快速重生和回放跳转。
+ * 只记录运动逻辑自身的状态，角色的位置/朝向和物理模拟由调用方负责。
+ */
+struct FCharacterLocomotionSnapshot
+{
+	TEnumAsByte<EMovementMode> MovementMode = MOVE_None;
+	EMovementState MovementState = EMovementState::None;
+	EMovementState PreviousMovementState = EMovementState::None;
+	EMovementAction MovementAction = EMovementAction::None;
+	EMovementAction PreviousMovementAction = EMovementAction::None;
+	ERotationMode RotationMode = ERotationMode::VelocityDirection;
+	ERotationMode DesiredRotationMode = ERotationMode::VelocityDirection;
+	EGait Gait = EGait::Walking;
+	EGait AllowedGait = EGait::Walking;
+	EGait ActualGait = EGait::Walking;
+	EGait PreviousActualGait = EGait::Walking;
+	EGait DesiredGait = EGait::Running;
+	EStance Stance = EStance::Standing;
+	EStance PreviousStance = EStance::Standing;
+	EStance DesiredStance = EStance::Standing;
+	EViewMode ViewMode = EViewMode::ThirdPerson;
+	EOverlayState OverlayState = EOverlayState::Default;
+
+	bool RightShoulder = false;
+	bool IsMoving = false;
+	bool HasMovementInput = false;
+	bool RagdollFaceUp = false;
+	bool RagdollOnGround = false;
+	bool BreakFall = false;
+
+	float Speed = 0.0f;
+	float MovementInputAmount = 0.0f;
+	float PreviousAimYaw = 0.0f;
+	float AimYawRate = 0.0f;
+
+	FVector Velocity = FVector::ZeroVector;
+	FVector Acceleration = FVector::ZeroVector;
+	FVector PreviousVelocity = FVector::ZeroVector;
+	FVector LastRagdollVelocity = FVector::ZeroVector;
+
+	FRotator TargetRotation = FRotator::ZeroRotator;
+	FRotator LastVelocityRotation = FRotator::ZeroRotator;
+	FRotator LastMovementInputRotation = FRotator::ZeroRotator;
+	FRotator InAirRotation = FRotator::ZeroRotator;
+
+	// 攀爬参数，蒙太奇用ULocomotionMontageRegistry的ID表示
+	uint8 MantleMontageId = 0;
+	float MantleStartingPosition = 0.0f;
+	float MantlePlayRate = 0.0f;
+	float MantleLowHeight = 0.0f;
+	FVector MantleStartingOffset = FVector::ZeroVector;
+	FTransform MantleTarget = FTransform::Identity;
+	FTransform MantleActualStartOffset = FTransform::Identity;
+	FTransform MantleAnimatedStartOffset = FTransform::Identity;
+	// 攀爬由时间线和蒙太奇推动，回滚到攀爬中途时要从同一位置继续
+	float MantleTimelineLength = 0.0f;
+	float MantleTimelinePosition = 0.0f;
+	float MantleMontagePosition = 0.0f;
+	// 只在内存快照中有效，不参与序列化
+	TWeakObjectPtr<UPrimitiveComponent> MantleLedgeComponent;
+
+	void Serialize(FArchive& Ar);
+};
+
+/** UAnimInstanceBase中需要跨帧保持的插值状态 */
+struct FAnimLocomotionSnapshot
+{
+	EMovementDirection MovementDirection = EMovementDirection::Forward;
+	EHipsDirection TrackedHipsDirection = EHipsDirection::F;
+	EGroundedEntryState GroundEntryState = EGroundedEntryState::None;
+
+	bool bShouldMove = false;
+	bool bRotateL = false;
+	bool bRotateR = false;
+	bool bPivot = false;
+	bool bJumped = false;
+
+	float RotateRate = 0.0f;
+	float ElapsedDelayTime = 0.0f;
+	float InputYawOffsetTime = 0.0f;
+	float FallSpeed = 0.0f;
+	float LandPrediction = 0.0f;
+	float FlailRate = 0.0f;
+	float DiagonalScaleAmount = 0.0f;
+	float WalkRunBlend = 0.0f;
+	float StrideBlend = 0.0f;
+	float StandingPlayRate = 0.0f;
+	float CrouchingPlayRate = 0.0f;
+	float RotationScale = 0.0f;
+	float PelvisAlpha = 0.0f;
+	float FootLockLAlpha = 0.0f;
+	float FootLockRAlpha = 0.0f;
+
+	FVelocityBlend VelocityBlend;
+	FLeanAmount LeanAmount;
+
+	FRotator SmoothedAimingRotation = FRotator::ZeroRotator;
+	FVector RelativeAccelerationAmount = FVector::ZeroVector;
+	FVector FootLockLLocation = FVector::ZeroVector;
+	FRotator FootLockLRotation = FRotator::ZeroRotator;
+	FVector FootLockRLocation = FVector::ZeroVector;
+	FRotator FootLockRRotation = FRotator::ZeroRotator;
+	FVector FootOffsetLTarget = FVector::ZeroVector;
+	FVector FootOffsetLLocation = FVector::ZeroVector;
+	FRotator FootOffsetLRotation = FRotator::ZeroRotator;
+	FVector FootOffsetRTarget = FVector::ZeroVector;
+	FVector FootOffsetRLocation = FVector::ZeroVector;
+	FRotator FootOffsetRRotation = FRotator::ZeroRotator;
+	FVector PelvisOffset = FVector::ZeroVector;
+
+	void Serialize(FArchive& Ar);
+};
+
+/**
+ * 角色和动画实例的完整运动快照。
+ * 序列化时枚举和布尔值按位压缩(配合FBitWriter/FBitReader)，浮点保持原值，
+ * 位置、速度和朝向与角色上的类型相同(大世界坐标下为双精度)，回滚后与保存时完全一致。
+ * 格式变化时增加CurrentVersion，其他版本的数据不能读取。
+ */
+struct FLocomotionSnapshot
+{
+	static constexpr uint8 CurrentVersion = 2;
+
+	uint8 Version = CurrentVersion;
+	bool bHasAnimSnapshot = false;
+	FCharacterLocomotionSnapshot Character;
+	FAnimLocomotionSnapshot Anim;
+
+	/** 版本不一致时会给Ar设置错误并返回false */
+	bool Serialize(FArchive& Ar);
+};
@@ -0,0 +1,112 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AnimationProject/Locomotion/LocomotionDefine.h"
+
+/**
+ * 按运动状态查表代替逐层switch。表在编译期生成，运行时只做下标计算和一次数组访问。
+ * 修改LocomotionDefine.h中的枚举时，下面的static_assert会提示同步修改表。
+ */
+namespace LocomotionStateTables
+{
+	constexpr int32 NumGaits = 3;
+	constexpr int32 NumRotationModes = 3;
+	constexpr int32 NumStances = 2;
+	constexpr int32 NumOverlayStates = 13;
+
+	static_assert(static_cast<int32>(EGait::Sprinting) + 1 == NumGaits, "EGait changed, update LocomotionStateTables");
+	static_assert(static_cast<int32>(ERotationMode::Aiming) + 1 == NumRotationModes, "ERotationMode changed, update LocomotionStateTables");
+	static_assert(static_cast<int32>(EStance::Crouching) + 1 == NumStances, "EStance changed, update LocomotionStateTables");
+	static_assert(static_cast<int32>(EOverlayState::Barrel) + 1 == NumOverlayStates, "EOverlayState changed, update LocomotionStateTables");
+
+	template <typename EnumType>
+	constexpr int32 ToIndex(EnumType Value)
+	{
+		return static_cast<int32>(Value);
+	}
+
+	/** Stance、RotationMode、Gait打包成一个下标 */
+	constexpr int32 PackGaitKey(EStance Stance, ERotationMode RotationMode, EGait Gait)
+	{
+		return (ToIndex(Stance) * NumRotationModes + ToIndex(RotationMode)) * NumGaits + ToIndex(Gait);
+	}
+
+	/**
+	 * 期望步态对应的允许步态，按PackGaitKey排列。
+	 * Sprinting表示还需要CanSprint()通过，否则降为Running。
+	 */
+	constexpr EGait AllowedGaits[NumStances * NumRotationModes * NumGaits] =
+	{
+		// Standing: VelocityDirection, LookingDirection, Aiming
+		EGait::Running, EGait::Running, EGait::Sprinting,
+		EGait::Running, EGait::Running, EGait::Sprinting,
+		EGait::Running, EGait::Running, EGait::Running,
+		// Crouching: VelocityDirection, LookingDirection, Aiming
+		EGait::Running, EGait::Running, EGait::Running,
+		EGait::Running, EGait::Running, EGait::Running,
+		EGait::Running, EGait::Running, EGait::Running,
+	};
+
+	constexpr EGait GetAllowedGait(EStance Stance, ERotationMode RotationMode, EGait DesiredGait)
+	{
+		return AllowedGaits[PackGaitKey(Stance, RotationMode, DesiredGait)];
+	}
+
+	/** MovementData.*RotationModeSettings[RotationMode].*StanceSettings[Stance] 即目标移动设置 */
+	constexpr FMovementSettingsStance FMovementSettingsState::* RotationModeSettings[NumRotationModes] =
+	{
+		&FMovementSettingsState::VelocityDirection,
+		&FMovementSettingsState::LookingDirection,
+		&FMovementSettingsState::Aiming,
+	};
+
+	constexpr FMovementSettings FMovementSettingsStance::* StanceSettings[NumStances] =
+	{
+		&FMovementSettingsStance::Standing,
+		&FMovementSettingsStance::Crouching,
+	};
+
+	constexpr float FMovementSettings::* GaitSpeeds[NumGaits] =
+	{
+		&FMovementSettings::WalkSpeed,
+		&FMovementSettings::RunSpeed,
+		&FMovementSettings::SprintSpeed,
+	};
+
+	/** 按手上拿的东西归类，攀爬、起身、翻滚动画都只按这个类别区分 */
+	enum class EOverlayHandGroup : uint8
+	{
+		Default,
+		LeftHand,
+		TwoHand,
+		RightHand,
+		Box,
+		Num
+	};
+
+	constexpr int32 NumOverlayHandGroups = static_cast<int32>(EOverlayHandGroup::Num);
+
+	constexpr EOverlayHandGroup OverlayHandGroups[NumOverlayStates] =
+	{
+		EOverlayHandGroup::Default,		// Default
+		EOverlayHandGroup::Default,		// Masculine
+		EOverlayHandGroup::Default,		// Feminine
+		EOverlayHandGroup::LeftHand,	// Injured
+		EOverlayHandGroup::TwoHand,		// HandsTied
+		EOverlayHandGroup::RightHand,	// Rifle
+		EOverlayHandGroup::RightHand,	// Pistol1H
+		EOverlayHandGroup::RightHand,	// Pistol2H
+		EOverlayHandGroup::LeftHand,	// Bow
+		EOverlayHandGroup::LeftHand,	// Torch
+		EOverlayHandGroup::RightHand,	// Binoculars
+		EOverlayHandGroup::Box,			// Box
+		EOverlayHandGroup::LeftHand,	// Barrel
+	};
+
+	constexpr int32 GetOverlayHandGroupIndex(EOverlayState OverlayState)
+	{
+		return ToIndex(OverlayHandGroups[ToIndex(OverlayState)]);
+	}
+}
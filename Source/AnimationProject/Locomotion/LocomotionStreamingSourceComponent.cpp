@@ -0,0 +1,154 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "LocomotionStreamingSourceComponent.h"
+#include "AnimationProject/Common/CommonInterfaces.h"
+#include "AnimationProject/Locomotion/LocomotionDefine.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "WorldPartition/WorldPartitionSubsystem.h"
+
+static TAutoConsoleVariable<bool> CVarPredictiveStreamingEnable(
+	TEXT("Locomotion.PredictiveStreaming.Enable"),
+	true,
+	TEXT("Request World Partition cells along the predicted trajectory of player characters"));
+
+static TAutoConsoleVariable<float> CVarPredictiveStreamingHorizon(
+	TEXT("Locomotion.PredictiveStreaming.Horizon"),
+	2.0f,
+	TEXT("Seconds of trajectory predicted at running gait, walking uses half and sprinting 1.5x"));
+
+static TAutoConsoleVariable<int32> CVarPredictiveStreamingNumPoints(
+	TEXT("Locomotion.PredictiveStreaming.NumPoints"),
+	4,
+	TEXT("Trajectory points requested ahead of the character"));
+
+static TAutoConsoleVariable<float> CVarPredictiveStreamingMinRangeScale(
+	TEXT("Locomotion.PredictiveStreaming.MinRangeScale"),
+	0.25f,
+	TEXT("Loading range scale of the furthest trajectory point, nearer points ramp up to 1"));
+
+ULocomotionStreamingSourceComponent::ULocomotionStreamingSourceComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void ULocomotionStreamingSourceComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UWorldPartitionSubsystem* WorldPartitionSubsystem = GetWorld()->GetSubsystem<UWorldPartitionSubsystem>())
+	{
+		WorldPartitionSubsystem->RegisterStreamingSourceProvider(this);
+		bRegistered = true;
+	}
+}
+
+void ULocomotionStreamingSourceComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bRegistered)
+	{
+		if (UWorldPartitionSubsystem* WorldPartitionSubsystem = GetWorld()->GetSubsystem<UWorldPartitionSubsystem>())
+		{
+			WorldPartitionSubsystem->UnregisterStreamingSourceProvider(this);
+		}
+		bRegistered = false;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+bool ULocomotionStreamingSourceComponent::GetStreamingSource(FWorldPartitionStreamingSource& StreamingSource)
+{
+	const APawn* Pawn = Cast<APawn>(GetOwner());
+	ICharacterInterface* Character = Cast<ICharacterInterface>(GetOwner());
+	if (!CVarPredictiveStreamingEnable.GetValueOnGameThread() || Pawn == nullptr || Character == nullptr
+		|| !Pawn->IsPlayerControlled() || Pawn->IsHidden())
+	{
+		return false;
+	}
+
+	TEnumAsByte<EMovementMode> MovementMode;
+	EMovementState MovementState, PrevMovementState;
+	EMovementAction MovementAction;
+	ERotationMode RotationMode;
+	EGait Gait;
+	EStance Stance;
+	EViewMode ViewMode;
+	EOverlayState OverlayState;
+	Character->BPIGetCurrentStates(MovementMode, MovementState, PrevMovementState, MovementAction, RotationMode, Gait, Stance, ViewMode, OverlayState);
+
+	FVector Velocity, Acceleration, MovementInput;
+	bool bIsMoving, bHasMovementInput;
+	float Speed, MovementInputAmount, AimYawRate;
+	FRotator AimingRotation;
+	Character->BPIGetEssentialValues(Velocity, Acceleration, MovementInput, bIsMoving, bHasMovementInput, Speed, MovementInputAmount, AimingRotation, AimYawRate);
+
+	// 玩家控制器本身已经是以当前位置为中心的流送源，这里只补充前方的轨迹
+	const bool bFalling = MovementState == EMovementState::InAir || MovementState == EMovementState::Ragdoll;
+	if (!bIsMoving && !bFalling)
+	{
+		return false;
+	}
+
+	float Horizon = CVarPredictiveStreamingHorizon.GetValueOnGameThread();
+	switch (Gait)
+	{
+	case EGait::Walking:
+		Horizon *= 0.5f;
+		break;
+	case EGait::Sprinting:
+		Horizon *= 1.5f;
+		break;
+	default:
+		break;
+	}
+
+	const FVector Location = GetOwner()->GetActorLocation();
+	const float GravityZ = GetWorld()->GetGravityZ();
+	const float FallDistance = bFalling ? PredictFallDistance(Location, Velocity) : -1.0f;
+	const int32 NumPoints = FMath::Max(CVarPredictiveStreamingNumPoints.GetValueOnGameThread(), 1);
+	const float MinRangeScale = FMath::Clamp(CVarPredictiveStreamingMinRangeScale.GetValueOnGameThread(), 0.0f, 1.0f);
+
+	StreamingSource.Name = GetOwner()->GetFName();
+	StreamingSource.Location = Location;
+	StreamingSource.Rotation = FRotator::ZeroRotator;
+	StreamingSource.TargetState = EStreamingSourceTargetState::Activated;
+	StreamingSource.bBlockOnSlowLoading = false;
+	StreamingSource.Priority = bFalling || Speed > FastMovingSpeed ? FastMovingPriority : EStreamingSourcePriority::Normal;
+	StreamingSource.Shapes.Reset(NumPoints);
+	for (int32 Index = 1; Index <= NumPoints; ++Index)
+	{
+		const float Alpha = static_cast<float>(Index) / NumPoints;
+		const float Time = Horizon * Alpha;
+		FVector Offset = Velocity * Time;
+		if (bFalling)
+		{
+			Offset.Z += 0.5f * GravityZ * Time * Time;
+			// 落地后沿水平方向继续，不再下落
+			if (FallDistance >= 0.0f)
+			{
+				Offset.Z = FMath::Max(Offset.Z, -FallDistance);
+			}
+		}
+
+		FStreamingSourceShape& Shape = StreamingSource.Shapes.AddDefaulted_GetRef();
+		Shape.bUseGridLoadingRange = true;
+		Shape.LoadingRangeScale = FMath::Lerp(1.0f, MinRangeScale, Alpha);
+		Shape.Location = Offset;
+	}
+	return true;
+}
+
+float ULocomotionStreamingSourceComponent::PredictFallDistance(const FVector& Location, const FVector& Velocity) const
+{
+	// 与动画的落地预测相同，沿速度方向检测地面，单元格还没加载时检测不到
+	const FVector Direction = FVector(Velocity.X, Velocity.Y, FMath::Min(Velocity.Z, -200.0f)).GetSafeNormal();
+	const FVector End = Location + Direction * 10000.0f;
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(LocomotionStreamingLandPrediction), false, GetOwner());
+	FHitResult HitResult;
+	if (GetWorld()->LineTraceSingleByChannel(HitResult, Location, End, ECC_Visibility, QueryParams))
+	{
+		return Location.Z - HitResult.ImpactPoint.Z;
+	}
+	return -1.0f;
+}
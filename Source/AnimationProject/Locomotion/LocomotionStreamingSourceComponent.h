@@ -0,0 +1,41 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "WorldPartition/WorldPartitionStreamingSource.h"
+#include "LocomotionStreamingSourceComponent.generated.h"
+
+/**
+ * 按角色的速度、步态和落地预测推算未来一小段轨迹，沿轨迹提前请求World Partition单元格。
+ * 越远的轨迹点请求的加载范围越小，随着角色接近逐渐扩大，加载请求分散到多帧而不是在单元格边界集中发出。
+ * 只对玩家控制的角色生效。
+ */
+UCLASS(ClassGroup = (Locomotion), meta = (BlueprintSpawnableComponent))
+class ULocomotionStreamingSourceComponent : public UActorComponent, public IWorldPartitionStreamingSourceProvider
+{
+	GENERATED_BODY()
+
+public:
+	ULocomotionStreamingSourceComponent();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual bool GetStreamingSource(FWorldPartitionStreamingSource& StreamingSource) override;
+
+	// 冲刺或下落时的优先级，其他情况使用Normal
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	EStreamingSourcePriority FastMovingPriority = EStreamingSourcePriority::High;
+
+	// 速度超过这个值(cm/s)时使用FastMovingPriority
+	UPROPERTY(EditAnywhere, Category = Streaming, meta = (ClampMin = "0"))
+	float FastMovingSpeed = 700.0f;
+
+private:
+	/** 返回落地前还能下落的高度，前方没有地面时返回-1 */
+	float PredictFallDistance(const FVector& Location, const FVector& Velocity) const;
+
+	bool bRegistered = false;
+};
@@ -0,0 +1,99 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "RagdollAsyncCallback.h"
+#include "AnimationProject/Physics/RagdollMotorDrive.h"
+#include "Chaos/ParticleHandle.h"
+#include "Chaos/PBDJointConstraints.h"
+#include "PhysicsProxy/JointConstraintProxy.h"
+#include "PhysicsProxy/SingleParticlePhysicsProxy.h"
+
+void FRagdollAsyncCallback::OnPreSimulate_Internal()
+{
+	if (const FRagdollAsyncInput* Input = GetConsumerInput_Internal())
+	{
+		for (const FRagdollAsyncCommand& Command : Input->Commands)
+		{
+			ApplyCommand(Command);
+		}
+	}
+
+	for (auto It = Ragdolls.CreateIterator(); It; ++It)
+	{
+		if (!UpdateRagdoll(It.Value()))
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FRagdollAsyncCallback::ApplyCommand(const FRagdollAsyncCommand& Command)
+{
+	switch (Command.Type)
+	{
+	case FRagdollAsyncCommand::EType::Add:
+		Ragdolls.Add(Command.RagdollId).Setup = Command;
+		break;
+	case FRagdollAsyncCommand::EType::Remove:
+		Ragdolls.Remove(Command.RagdollId);
+		break;
+	case FRagdollAsyncCommand::EType::SetMotorsEnabled:
+		if (FRagdollEntry* Entry = Ragdolls.Find(Command.RagdollId))
+		{
+			Entry->Setup.bMotorsEnabled = Command.bMotorsEnabled;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+bool FRagdollAsyncCallback::UpdateRagdoll(FRagdollEntry& Entry)
+{
+	const FRagdollAsyncCommand& Setup = Entry.Setup;
+	Chaos::FRigidBodyHandle_Internal* Root = Setup.RootProxy ? Setup.RootProxy->GetPhysicsThreadAPI() : nullptr;
+	Chaos::FRigidBodyHandle_Internal* Pelvis = Setup.PelvisProxy ? Setup.PelvisProxy->GetPhysicsThreadAPI() : nullptr;
+	if (Root == nullptr || Pelvis == nullptr)
+	{
+		// 刚体已经注销(代理随后会被释放)，丢弃这一份，刚体重建时游戏线程会用新的代理重新添加
+		return false;
+	}
+
+	const FVector RootVelocity = Root->V();
+
+	// 与ACharacterBase::RagdollUpdate相同: 速度越大电机越强，下落过快时关闭重力
+	const float Spring = Setup.bMotorsEnabled ? FMath::GetMappedRangeValueClamped(FVector2f(0.0f, 1000.0f), FVector2f(0.0f, Setup.MaxSpring), static_cast<float>(RootVelocity.Size())) : 0.0f;
+	const int32 SpringBucket = FMath::Clamp(FMath::RoundToInt32(Spring / FMath::Max(Setup.MaxSpring, KINDA_SMALL_NUMBER) * (FRagdollMotorDrive::NumSpringBuckets - 1)), 0, FRagdollMotorDrive::NumSpringBuckets - 1);
+	if (SpringBucket != Entry.SpringBucket)
+	{
+		Entry.SpringBucket = SpringBucket;
+		const Chaos::FVec3 BucketSpring(Setup.MaxSpring * SpringBucket / (FRagdollMotorDrive::NumSpringBuckets - 1));
+		for (Chaos::FJointConstraintPhysicsProxy* JointProxy : Setup.DrivenJointProxies)
+		{
+			if (Chaos::FPBDJointConstraintHandle* Joint = JointProxy ? JointProxy->GetHandle() : nullptr)
+			{
+				Chaos::FPBDJointSettings Settings = Joint->GetSettings();
+				Settings.AngularDriveStiffness = BucketSpring;
+				Joint->SetSettings(Settings);
+			}
+		}
+	}
+
+	const int8 GravityState = RootVelocity.Z > -4000.0f ? 1 : 0;
+	if (GravityState != Entry.GravityState)
+	{
+		Entry.GravityState = GravityState;
+		for (FSingleParticlePhysicsProxy* BodyProxy : Setup.BodyProxies)
+		{
+			if (Chaos::FRigidBodyHandle_Internal* Body = BodyProxy ? BodyProxy->GetPhysicsThreadAPI() : nullptr)
+			{
+				Body->SetGravityEnabled(GravityState != 0);
+			}
+		}
+	}
+
+	FRagdollAsyncState State;
+	State.RootVelocity = RootVelocity;
+	State.PelvisLocation = Pelvis->X();
+	Setup.Mailbox->Publish(State);
+	return true;
+}
@@ -0,0 +1,75 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Chaos/SimCallbackInput.h"
+#include "Chaos/SimCallbackObject.h"
+#include "AnimationProject/Physics/RagdollMailbox.h"
+
+class FSingleParticlePhysicsProxy;
+namespace Chaos
+{
+	class FJointConstraintPhysicsProxy;
+}
+
+struct FRagdollAsyncCommand
+{
+	enum class EType : uint8
+	{
+		Add,
+		Remove,
+		SetMotorsEnabled,
+	};
+
+	EType Type = EType::Add;
+	uint32 RagdollId = 0;
+	bool bMotorsEnabled = true;
+	float MaxSpring = 0.0f;
+	// 代理在刚体注销后失效: 物理线程每步检查根和骨盆，刚体重建时游戏线程重新发送Add
+	FSingleParticlePhysicsProxy* RootProxy = nullptr;
+	FSingleParticlePhysicsProxy* PelvisProxy = nullptr;
+	TArray<FSingleParticlePhysicsProxy*> BodyProxies;
+	TArray<Chaos::FJointConstraintPhysicsProxy*> DrivenJointProxies;
+	TSharedPtr<FRagdollAsyncMailbox, ESPMode::ThreadSafe> Mailbox;
+};
+
+struct FRagdollAsyncInput : public Chaos::FSimCallbackInput
+{
+	TArray<FRagdollAsyncCommand> Commands;
+
+	void Reset()
+	{
+		Commands.Reset();
+	}
+};
+
+struct FRagdollAsyncOutput : public Chaos::FSimCallbackOutput
+{
+	void Reset()
+	{
+	}
+};
+
+/**
+ * 在物理线程的每个子步前执行布娃娃的电机强度和重力规则(与RagdollUpdate相同)，
+ * 结果通过每个布娃娃自己的信箱交回游戏线程。游戏线程只在开始、结束和切换等级时发送命令。
+ */
+class FRagdollAsyncCallback : public Chaos::TSimCallbackObject<FRagdollAsyncInput, FRagdollAsyncOutput>
+{
+private:
+	struct FRagdollEntry
+	{
+		FRagdollAsyncCommand Setup;
+		int32 SpringBucket = INDEX_NONE;
+		int8 GravityState = INDEX_NONE;
+	};
+
+	virtual void OnPreSimulate_Internal() override;
+
+	void ApplyCommand(const FRagdollAsyncCommand& Command);
+	/** 返回false表示刚体已经注销，需要移除这一份 */
+	bool UpdateRagdoll(FRagdollEntry& Entry);
+
+	TMap<uint32, FRagdollEntry> Ragdolls;
+};
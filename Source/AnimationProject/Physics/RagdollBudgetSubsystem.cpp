@@ -0,0 +1,333 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "RagdollBudgetSubsystem.h"
+#include "AnimationProject/Character/CharacterBase.h"
+#include "AnimationProject/Physics/RagdollAsyncCallback.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+#include "PBDRigidsSolver.h"
+#include "PhysicsEngine/ConstraintInstance.h"
+#include "AnimationProject/Physics/RagdollMotorDrive.h"
+#include "PhysicsProxy/JointConstraintProxy.h"
+
+DECLARE_STATS_GROUP(TEXT("RagdollBudget"), STATGROUP_RagdollBudget, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Full Ragdolls"), STAT_RagdollBudgetFull, STATGROUP_RagdollBudget);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Simplified Ragdolls"), STAT_RagdollBudgetSimplified, STATGROUP_RagdollBudget);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Frozen Ragdolls"), STAT_RagdollBudgetFrozen, STATGROUP_RagdollBudget);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hit Reaction Bodies"), STAT_RagdollBudgetHitReactionBodies, STATGROUP_RagdollBudget);
+
+static TAutoConsoleVariable<int32> CVarRagdollBudgetEnabled(
+	TEXT("Ragdoll.Budget.Enabled"),
+	1,
+	TEXT("0: every ragdoll gets full simulation, 1: limit ragdoll simulation by priority"));
+
+static TAutoConsoleVariable<int32> CVarRagdollBudgetMaxFull(
+	TEXT("Ragdoll.Budget.MaxFull"),
+	8,
+	TEXT("Number of ragdolls allowed to run full simulation"));
+
+static TAutoConsoleVariable<int32> CVarRagdollBudgetMaxSimplified(
+	TEXT("Ragdoll.Budget.MaxSimplified"),
+	8,
+	TEXT("Number of ragdolls allowed to run simplified simulation, the rest are frozen"));
+
+static TAutoConsoleVariable<float> CVarRagdollBudgetUpdateInterval(
+	TEXT("Ragdoll.Budget.UpdateInterval"),
+	0.25f,
+	TEXT("Seconds between ragdoll priority updates"));
+
+static TAutoConsoleVariable<float> CVarRagdollBudgetMaxDistance(
+	TEXT("Ragdoll.Budget.MaxDistance"),
+	5000.0f,
+	TEXT("Distance at which a ragdoll gets the lowest distance priority"));
+
+static TAutoConsoleVariable<float> CVarRagdollBudgetRecencyTime(
+	TEXT("Ragdoll.Budget.RecencyTime"),
+	5.0f,
+	TEXT("Seconds after which a ragdoll gets the lowest recency priority"));
+
+static TAutoConsoleVariable<int32> CVarRagdollHitReactionMaxBodies(
+	TEXT("Ragdoll.HitReaction.MaxBodies"),
+	48,
+	TEXT("Number of bodies all partial hit reactions in the world may simulate at the same time, -1 for no limit"));
+
+static TAutoConsoleVariable<int32> CVarRagdollAsyncControl(
+	TEXT("Ragdoll.AsyncControl"),
+	1,
+	TEXT("1: ragdoll motor strength and gravity run on the physics thread every substep, 0: on the game thread in RagdollUpdate"));
+
+void URagdollBudgetSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Ragdolls.Num() == 0)
+	{
+		return;
+	}
+
+	TimeUntilUpdate -= DeltaTime;
+	if (TimeUntilUpdate <= 0.0f)
+	{
+		TimeUntilUpdate = CVarRagdollBudgetUpdateInterval.GetValueOnGameThread();
+		UpdateTiers();
+	}
+}
+
+TStatId URagdollBudgetSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(URagdollBudgetSubsystem, STATGROUP_Tickables);
+}
+
+void URagdollBudgetSubsystem::RegisterRagdoll(ACharacterBase* Character)
+{
+	if (!IsValid(Character) || Ragdolls.ContainsByPredicate([Character](const FRagdollEntry& Entry) { return Entry.Character == Character; }))
+	{
+		return;
+	}
+
+	FRagdollEntry& Entry = Ragdolls.AddDefaulted_GetRef();
+	Entry.Character = Character;
+	Entry.StartTime = GetWorld()->GetTimeSeconds();
+	UpdateTiers();
+}
+
+void URagdollBudgetSubsystem::UnregisterRagdoll(ACharacterBase* Character)
+{
+	Ragdolls.RemoveAllSwap([Character](const FRagdollEntry& Entry) { return Entry.Character == Character; });
+}
+
+bool URagdollBudgetSubsystem::AcquireHitReactionBodies(ACharacterBase* Character, int32 NumBodies)
+{
+	if (!IsValid(Character) || NumBodies <= 0)
+	{
+		return false;
+	}
+
+	// 已销毁的角色不会再释放，这里顺便清理
+	for (auto It = HitReactionBodies.CreateIterator(); It; ++It)
+	{
+		if (!It->Key.IsValid())
+		{
+			Counters.NumHitReactionBodies -= It->Value;
+			It.RemoveCurrent();
+		}
+	}
+
+	const int32 PreviousBodies = HitReactionBodies.FindRef(Character);
+	const int32 MaxBodies = CVarRagdollHitReactionMaxBodies.GetValueOnGameThread();
+	if (CVarRagdollBudgetEnabled.GetValueOnGameThread() != 0
+		&& MaxBodies >= 0
+		&& Counters.NumHitReactionBodies - PreviousBodies + NumBodies > MaxBodies)
+	{
+		return false;
+	}
+
+	HitReactionBodies.Add(Character, NumBodies);
+	Counters.NumHitReactionBodies += NumBodies - PreviousBodies;
+	SET_DWORD_STAT(STAT_RagdollBudgetHitReactionBodies, Counters.NumHitReactionBodies);
+	return true;
+}
+
+void URagdollBudgetSubsystem::ReleaseHitReactionBodies(ACharacterBase* Character)
+{
+	int32 NumBodies = 0;
+	if (HitReactionBodies.RemoveAndCopyValue(Character, NumBodies))
+	{
+		Counters.NumHitReactionBodies -= NumBodies;
+		SET_DWORD_STAT(STAT_RagdollBudgetHitReactionBodies, Counters.NumHitReactionBodies);
+	}
+}
+
+void URagdollBudgetSubsystem::UpdateTiers()
+{
+	Ragdolls.RemoveAllSwap([](const FRagdollEntry& Entry) { return !Entry.Character.IsValid(); });
+
+	TArray<FVector> ViewLocations;
+	GatherViewLocations(ViewLocations);
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+	for (FRagdollEntry& Entry : Ragdolls)
+	{
+		Entry.Priority = CalculatePriority(Entry, ViewLocations, CurrentTime);
+	}
+	Ragdolls.Sort([](const FRagdollEntry& A, const FRagdollEntry& B) { return A.Priority < B.Priority; });
+
+	const bool bEnabled = CVarRagdollBudgetEnabled.GetValueOnGameThread() != 0;
+	const int32 MaxFull = bEnabled ? FMath::Max(CVarRagdollBudgetMaxFull.GetValueOnGameThread(), 0) : MAX_int32;
+	const int32 MaxSimplified = FMath::Max(CVarRagdollBudgetMaxSimplified.GetValueOnGameThread(), 0);
+
+	Counters.NumFull = 0;
+	Counters.NumSimplified = 0;
+	Counters.NumFrozen = 0;
+	for (int32 Index = 0; Index < Ragdolls.Num(); ++Index)
+	{
+		FRagdollEntry& Entry = Ragdolls[Index];
+		if (Index < MaxFull)
+		{
+			Entry.Tier = ERagdollSimulationTier::Full;
+			++Counters.NumFull;
+		}
+		else if (Index - MaxFull < MaxSimplified)
+		{
+			Entry.Tier = ERagdollSimulationTier::Simplified;
+			++Counters.NumSimplified;
+		}
+		else
+		{
+			Entry.Tier = ERagdollSimulationTier::Frozen;
+			++Counters.NumFrozen;
+		}
+		Entry.Character->SetRagdollSimulationTier(Entry.Tier);
+	}
+
+	SET_DWORD_STAT(STAT_RagdollBudgetFull, Counters.NumFull);
+	SET_DWORD_STAT(STAT_RagdollBudgetSimplified, Counters.NumSimplified);
+	SET_DWORD_STAT(STAT_RagdollBudgetFrozen, Counters.NumFrozen);
+}
+
+float URagdollBudgetSubsystem::CalculatePriority(const FRagdollEntry& Entry, const TArray<FVector>& ViewLocations, double CurrentTime) const
+{
+	// 数值越小优先级越高
+	const ACharacterBase* Character = Entry.Character.Get();
+	const FVector Location = Character->GetActorLocation();
+	float MinDistanceSquared = ViewLocations.Num() > 0 ? MAX_flt : 0.0f;
+	for (const FVector& ViewLocation : ViewLocations)
+	{
+		MinDistanceSquared = FMath::Min(MinDistanceSquared, static_cast<float>(FVector::DistSquared(ViewLocation, Location)));
+	}
+
+	const float MaxDistance = FMath::Max(CVarRagdollBudgetMaxDistance.GetValueOnGameThread(), 1.0f);
+	const float RecencyTime = FMath::Max(CVarRagdollBudgetRecencyTime.GetValueOnGameThread(), KINDA_SMALL_NUMBER);
+	float Priority = FMath::Clamp(FMath::Sqrt(MinDistanceSquared) / MaxDistance, 0.0f, 1.0f);
+	Priority += FMath::Clamp(static_cast<float>(CurrentTime - Entry.StartTime) / RecencyTime, 0.0f, 1.0f) * 0.5f;
+	if (!Character->WasRecentlyRendered(0.2f))
+	{
+		Priority += 1.0f;
+	}
+	return Priority;
+}
+
+float URagdollBudgetSubsystem::GetViewDistance(const AActor* Actor) const
+{
+	TArray<FVector> ViewLocations;
+	GatherViewLocations(ViewLocations);
+	float MinDistanceSquared = ViewLocations.Num() > 0 ? MAX_flt : 0.0f;
+	for (const FVector& ViewLocation : ViewLocations)
+	{
+		MinDistanceSquared = FMath::Min(MinDistanceSquared, static_cast<float>(FVector::DistSquared(ViewLocation, Actor->GetActorLocation())));
+	}
+	return FMath::Sqrt(MinDistanceSquared);
+}
+
+void URagdollBudgetSubsystem::GatherViewLocations(TArray<FVector>& OutViewLocations) const
+{
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (!IsValid(PlayerController))
+		{
+			continue;
+		}
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		OutViewLocations.Add(ViewLocation);
+	}
+}
+
+void URagdollBudgetSubsystem::Deinitialize()
+{
+	if (AsyncCallback != nullptr)
+	{
+		if (FPhysScene* PhysScene = GetWorld()->GetPhysicsScene())
+		{
+			PhysScene->GetSolver()->UnregisterAndFreeSimCallbackObject_External(AsyncCallback);
+		}
+		AsyncCallback = nullptr;
+	}
+
+	Super::Deinitialize();
+}
+
+FRagdollAsyncInput* URagdollBudgetSubsystem::GetAsyncInput()
+{
+	if (AsyncCallback == nullptr)
+	{
+		FPhysScene* PhysScene = GetWorld()->GetPhysicsScene();
+		if (PhysScene == nullptr || PhysScene->GetSolver() == nullptr)
+		{
+			return nullptr;
+		}
+		AsyncCallback = PhysScene->GetSolver()->CreateAndRegisterSimCallbackObject_External<FRagdollAsyncCallback>();
+	}
+	return AsyncCallback->GetProducerInputData_External();
+}
+
+bool URagdollBudgetSubsystem::BeginAsyncControl(ACharacterBase* Character, USkeletalMeshComponent* Mesh, float MaxSpring, TSharedPtr<FRagdollAsyncMailbox, ESPMode::ThreadSafe>& OutMailbox)
+{
+	if (CVarRagdollAsyncControl.GetValueOnGameThread() == 0 || !IsValid(Character) || !IsValid(Mesh))
+	{
+		return false;
+	}
+
+	FBodyInstance* RootBody = Mesh->GetBodyInstance(FName("root"));
+	FBodyInstance* PelvisBody = Mesh->GetBodyInstance(FName("pelvis"));
+	if (PelvisBody == nullptr)
+	{
+		return false;
+	}
+
+	FRagdollAsyncInput* Input = GetAsyncInput();
+	if (Input == nullptr)
+	{
+		return false;
+	}
+
+	FRagdollAsyncCommand& Command = Input->Commands.AddDefaulted_GetRef();
+	Command.Type = FRagdollAsyncCommand::EType::Add;
+	Command.RagdollId = Character->GetUniqueID();
+	Command.MaxSpring = MaxSpring;
+	// 没有root刚体时用骨盆的速度，与GetPhysicsLinearVelocity(root)找不到刚体时的行为一致
+	Command.RootProxy = RootBody ? RootBody->ActorHandle : PelvisBody->ActorHandle;
+	Command.PelvisProxy = PelvisBody->ActorHandle;
+	for (const FBodyInstance* Body : Mesh->Bodies)
+	{
+		if (Body != nullptr && Body->ActorHandle != nullptr)
+		{
+			Command.BodyProxies.Add(Body->ActorHandle);
+		}
+	}
+	for (const FConstraintInstance* Constraint : Mesh->Constraints)
+	{
+		if (Constraint != nullptr && Constraint->ConstraintHandle.IsValid() && FRagdollMotorDrive::HasAngularDrive(*Constraint))
+		{
+			Command.DrivenJointProxies.Add(Constraint->ConstraintHandle.Constraint->GetProxy<Chaos::FJointConstraintPhysicsProxy>());
+		}
+	}
+
+	OutMailbox = MakeShared<FRagdollAsyncMailbox, ESPMode::ThreadSafe>();
+	Command.Mailbox = OutMailbox;
+	return true;
+}
+
+void URagdollBudgetSubsystem::SetAsyncMotorsEnabled(ACharacterBase* Character, bool bEnabled)
+{
+	if (FRagdollAsyncInput* Input = AsyncCallback ? GetAsyncInput() : nullptr)
+	{
+		FRagdollAsyncCommand& Command = Input->Commands.AddDefaulted_GetRef();
+		Command.Type = FRagdollAsyncCommand::EType::SetMotorsEnabled;
+		Command.RagdollId = Character->GetUniqueID();
+		Command.bMotorsEnabled = bEnabled;
+	}
+}
+
+void URagdollBudgetSubsystem::EndAsyncControl(ACharacterBase* Character)
+{
+	if (FRagdollAsyncInput* Input = AsyncCallback ? GetAsyncInput() : nullptr)
+	{
+		FRagdollAsyncCommand& Command = Input->Commands.AddDefaulted_GetRef();
+		Command.Type = FRagdollAsyncCommand::EType::Remove;
+		Command.RagdollId = Character->GetUniqueID();
+	}
+}
@@ -0,0 +1,105 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AnimationProject/Physics/RagdollMailbox.h"
+#include "RagdollBudgetSubsystem.generated.h"
+
+class ACharacterBase;
+class USkeletalMeshComponent;
+class FRagdollAsyncCallback;
+struct FRagdollAsyncInput;
+
+UENUM(BlueprintType)
+enum class ERagdollSimulationTier : uint8
+{
+	// 全身物理模拟，每帧更新电机和胶囊位置
+	Full,
+	// 保持物理模拟，但关闭电机驱动并降低更新频率
+	Simplified,
+	// 停止物理模拟，定格在最后的姿势
+	Frozen,
+};
+
+USTRUCT(BlueprintType)
+struct FRagdollBudgetCounters
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 NumFull = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 NumSimplified = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 NumFrozen = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 NumHitReactionBodies = 0;
+};
+
+/**
+ * 世界内所有布娃娃共享的模拟预算。按距离、是否可见和开始时间排序，
+ * 只有优先级最高的若干个获得完整模拟，其余降级为简化模拟或定格姿势。
+ * 预算通过Ragdoll.Budget.*控制台变量配置。
+ */
+UCLASS()
+class URagdollBudgetSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** 开始布娃娃时调用，立即分配模拟等级 */
+	void RegisterRagdoll(ACharacterBase* Character);
+	void UnregisterRagdoll(ACharacterBase* Character);
+
+	UFUNCTION(BlueprintCallable)
+	FRagdollBudgetCounters GetCounters() const { return Counters; }
+
+	/**
+	 * 局部受击反应申请模拟NumBodies个刚体，超出Ragdoll.HitReaction.MaxBodies时返回false。
+	 * 同一个角色再次申请时替换之前的数量。
+	 */
+	bool AcquireHitReactionBodies(ACharacterBase* Character, int32 NumBodies);
+	void ReleaseHitReactionBodies(ACharacterBase* Character);
+
+	/** 到最近的玩家视点的距离，用于选择布娃娃的物理资源LOD */
+	float GetViewDistance(const AActor* Actor) const;
+
+	/**
+	 * 把布娃娃的电机和重力控制交给物理线程(Ragdoll.AsyncControl开启时)，返回false表示继续由游戏线程控制。
+	 * 物理线程的结果写入OutMailbox。
+	 */
+	bool BeginAsyncControl(ACharacterBase* Character, USkeletalMeshComponent* Mesh, float MaxSpring, TSharedPtr<FRagdollAsyncMailbox, ESPMode::ThreadSafe>& OutMailbox);
+	void SetAsyncMotorsEnabled(ACharacterBase* Character, bool bEnabled);
+	void EndAsyncControl(ACharacterBase* Character);
+
+	virtual void Deinitialize() override;
+
+private:
+	struct FRagdollEntry
+	{
+		TWeakObjectPtr<ACharacterBase> Character;
+		double StartTime = 0.0;
+		float Priority = 0.0f;
+		ERagdollSimulationTier Tier = ERagdollSimulationTier::Full;
+	};
+
+	void UpdateTiers();
+	float CalculatePriority(const FRagdollEntry& Entry, const TArray<FVector>& ViewLocations, double CurrentTime) const;
+	void GatherViewLocations(TArray<FVector>& OutViewLocations) const;
+
+	FRagdollAsyncInput* GetAsyncInput();
+
+	TArray<FRagdollEntry> Ragdolls;
+	TMap<TWeakObjectPtr<ACharacterBase>, int32> HitReactionBodies;
+	FRagdollAsyncCallback* AsyncCallback = nullptr;
+	FRagdollBudgetCounters Counters;
+	float TimeUntilUpdate = 0.0f;
+};
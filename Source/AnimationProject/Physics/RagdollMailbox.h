@@ -0,0 +1,51 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+/**
+ * 单生产者单消费者的最新值信箱(三缓冲)，物理线程写入，游戏线程读取最新的一份，双方都不会阻塞。
+ */
+template<typename ValueType>
+class TRagdollMailbox
+{
+public:
+	/** 只在生产者线程调用 */
+	void Publish(const ValueType& Value)
+	{
+		Buffers[WriteIndex] = Value;
+		WriteIndex = Ready.exchange(WriteIndex | NewValueFlag, std::memory_order_acq_rel) & IndexMask;
+	}
+
+	/** 只在消费者线程调用，没有新值时返回false */
+	bool Consume(ValueType& OutValue)
+	{
+		if ((Ready.load(std::memory_order_acquire) & NewValueFlag) == 0)
+		{
+			return false;
+		}
+		ReadIndex = Ready.exchange(ReadIndex, std::memory_order_acq_rel) & IndexMask;
+		OutValue = Buffers[ReadIndex];
+		return true;
+	}
+
+private:
+	static constexpr uint8 IndexMask = 0x3;
+	static constexpr uint8 NewValueFlag = 0x4;
+
+	ValueType Buffers[3];
+	uint8 WriteIndex = 0;
+	uint8 ReadIndex = 1;
+	std::atomic<uint8> Ready { 2 };
+};
+
+/** 物理线程每个子步发布给角色的布娃娃状态 */
+struct FRagdollAsyncState
+{
+	FVector RootVelocity = FVector::ZeroVector;
+	FVector PelvisLocation = FVector::ZeroVector;
+};
+
+using FRagdollAsyncMailbox = TRagdollMailbox<FRagdollAsyncState>;
@@ -0,0 +1,89 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "RagdollMotorDrive.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "PhysicsEngine/ConstraintInstance.h"
+
+DECLARE_STATS_GROUP(TEXT("RagdollMotorDrive"), STATGROUP_RagdollMotorDrive, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Constraint Writes"), STAT_RagdollConstraintWrites, STATGROUP_RagdollMotorDrive);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Constraint Writes Avoided"), STAT_RagdollConstraintWritesAvoided, STATGROUP_RagdollMotorDrive);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gravity Writes"), STAT_RagdollGravityWrites, STATGROUP_RagdollMotorDrive);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gravity Writes Avoided"), STAT_RagdollGravityWritesAvoided, STATGROUP_RagdollMotorDrive);
+
+void FRagdollMotorDrive::Initialize(USkeletalMeshComponent* InMesh, float InMaxSpring)
+{
+	Reset();
+	if (!IsValid(InMesh))
+	{
+		return;
+	}
+
+	Mesh = InMesh;
+	MaxSpring = FMath::Max(InMaxSpring, KINDA_SMALL_NUMBER);
+	NumConstraints = InMesh->Constraints.Num();
+	NumBodies = InMesh->Bodies.Num();
+	for (FConstraintInstance* Constraint : InMesh->Constraints)
+	{
+		if (Constraint != nullptr && HasAngularDrive(*Constraint))
+		{
+			DrivenConstraints.Add(Constraint);
+		}
+	}
+}
+
+void FRagdollMotorDrive::Reset()
+{
+	Mesh.Reset();
+	DrivenConstraints.Reset();
+	NumConstraints = 0;
+	NumBodies = 0;
+	SpringBucket = INDEX_NONE;
+	GravityState = INDEX_NONE;
+}
+
+void FRagdollMotorDrive::SetSpring(float Spring)
+{
+	const int32 NewBucket = FMath::Clamp(FMath::RoundToInt32(Spring / MaxSpring * (NumSpringBuckets - 1)), 0, NumSpringBuckets - 1);
+	if (NewBucket == SpringBucket || !Mesh.IsValid())
+	{
+		INC_DWORD_STAT_BY(STAT_RagdollConstraintWritesAvoided, NumConstraints);
+		return;
+	}
+
+	SpringBucket = NewBucket;
+	const float BucketSpring = MaxSpring * NewBucket / (NumSpringBuckets - 1);
+	for (FConstraintInstance* Constraint : DrivenConstraints)
+	{
+		Constraint->SetAngularDriveParams(BucketSpring, 0.0f, 0.0f);
+	}
+	INC_DWORD_STAT_BY(STAT_RagdollConstraintWrites, DrivenConstraints.Num());
+	INC_DWORD_STAT_BY(STAT_RagdollConstraintWritesAvoided, NumConstraints - DrivenConstraints.Num());
+}
+
+void FRagdollMotorDrive::SetGravityEnabled(bool bEnabled)
+{
+	const int8 NewState = bEnabled ? 1 : 0;
+	if (NewState == GravityState || !Mesh.IsValid())
+	{
+		INC_DWORD_STAT_BY(STAT_RagdollGravityWritesAvoided, NumBodies);
+		return;
+	}
+
+	GravityState = NewState;
+	Mesh->SetEnableGravity(bEnabled);
+	INC_DWORD_STAT_BY(STAT_RagdollGravityWrites, NumBodies);
+}
+
+bool FRagdollMotorDrive::HasAngularDrive(const FConstraintInstance& Constraint)
+{
+	const FAngularDriveConstraint& AngularDrive = Constraint.ProfileInstance.AngularDrive;
+	const auto IsEnabled = [](const FConstraintDrive& Drive)
+	{
+		return Drive.bEnablePositionDrive || Drive.bEnableVelocityDrive;
+	};
+	if (AngularDrive.AngularDriveMode == EAngularDriveMode::SLERP)
+	{
+		return IsEnabled(AngularDrive.SlerpDrive);
+	}
+	return IsEnabled(AngularDrive.SwingDrive) || IsEnabled(AngularDrive.TwistDrive);
+}
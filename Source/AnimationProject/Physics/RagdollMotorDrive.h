@@ -0,0 +1,36 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class USkeletalMeshComponent;
+struct FConstraintInstance;
+
+/**
+ * 布娃娃电机和重力的写入缓存。弹簧强度按档位量化，只有档位或重力开关变化时才写入物理，
+ * 写入时只遍历启用了角度驱动的约束。节省的写入次数可以用stat RagdollMotorDrive查看。
+ */
+class FRagdollMotorDrive
+{
+public:
+	static constexpr int32 NumSpringBuckets = 32;
+
+	/** 布娃娃开始时调用，缓存需要驱动的约束 */
+	void Initialize(USkeletalMeshComponent* InMesh, float InMaxSpring);
+	void Reset();
+
+	void SetSpring(float Spring);
+	void SetGravityEnabled(bool bEnabled);
+
+	static bool HasAngularDrive(const FConstraintInstance& Constraint);
+
+private:
+	TWeakObjectPtr<USkeletalMeshComponent> Mesh;
+	TArray<FConstraintInstance*> DrivenConstraints;
+	int32 NumConstraints = 0;
+	int32 NumBodies = 0;
+	float MaxSpring = 1.0f;
+	int32 SpringBucket = INDEX_NONE;
+	int8 GravityState = INDEX_NONE;
+};
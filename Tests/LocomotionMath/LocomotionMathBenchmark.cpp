@@ -0,0 +1,119 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "AnimationProject/Locomotion/LocomotionMath.h"
+#include "LocomotionMathTestTypes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+	constexpr int NumInputs = 1024;
+
+	// 输入用固定的伪随机序列，每次运行结果可比
+	struct FInputs
+	{
+		std::vector<float> Speed;
+		std::vector<float> Angle;
+		std::vector<float> X;
+		std::vector<float> Y;
+		std::vector<float> Z;
+
+		FInputs()
+		{
+			unsigned int State = 12345u;
+			const auto Next = [&State](float Min, float Max)
+			{
+				State = State * 1664525u + 1013904223u;
+				return Min + (Max - Min) * static_cast<float>(State >> 8) / static_cast<float>(1u << 24);
+			};
+			for (int Index = 0; Index < NumInputs; ++Index)
+			{
+				Speed.push_back(Next(0.0f, 700.0f));
+				Angle.push_back(Next(-180.0f, 180.0f));
+				X.push_back(Next(-1.0f, 1.0f));
+				Y.push_back(Next(-1.0f, 1.0f));
+				Z.push_back(Next(-0.2f, 0.2f));
+			}
+		}
+	};
+
+	// 结果累加到这里，避免编译器把循环优化掉
+	volatile float Sink = 0.0f;
+
+	template <typename FunctionType>
+	void Run(const char* Name, int Iterations, FunctionType&& Function)
+	{
+		const auto Start = std::chrono::steady_clock::now();
+		float Sum = 0.0f;
+		for (int Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			for (int Index = 0; Index < NumInputs; ++Index)
+			{
+				Sum += Function(Index);
+			}
+		}
+		const auto End = std::chrono::steady_clock::now();
+		Sink = Sink + Sum;
+
+		const double Nanoseconds = std::chrono::duration<double, std::nano>(End - Start).count();
+		const double Calls = static_cast<double>(Iterations) * NumInputs;
+		std::printf("%-24s %10.3f ns/call\n", Name, Nanoseconds / Calls);
+	}
+}
+
+/** 用法: LocomotionMathBenchmark [Iterations]，每次迭代对1024组输入各调用一次 */
+int main(int Argc, char** Argv)
+{
+	const int Iterations = Argc > 1 ? std::max(std::atoi(Argv[1]), 1) : 20000;
+	const FInputs Inputs;
+	constexpr float WalkSpeed = 165.0f;
+	constexpr float RunSpeed = 375.0f;
+	constexpr float SprintSpeed = 650.0f;
+
+	Run("MappedSpeed", Iterations, [&](int Index)
+	{
+		return LocomotionMath::MappedSpeed(Inputs.Speed[Index], WalkSpeed, RunSpeed, SprintSpeed);
+	});
+	Run("ActualGait", Iterations, [&](int Index)
+	{
+		return static_cast<float>(LocomotionMath::ActualGait(Inputs.Speed[Index], WalkSpeed, RunSpeed, EGait::Sprinting));
+	});
+	Run("FixDiagonalGamepad", Iterations, [&](int Index)
+	{
+		float X, Y;
+		LocomotionMath::FixDiagonalGamepadValues(Inputs.X[Index], Inputs.Y[Index], X, Y);
+		return X + Y;
+	});
+	Run("Quadrant", Iterations, [&](int Index)
+	{
+		return static_cast<float>(LocomotionMath::Quadrant(EMovementDirection::Forward, 70.0f, -70.0f, 110.0f, -110.0f, 5.0f, Inputs.Angle[Index]));
+	});
+	Run("VelocityBlend", Iterations, [&](int Index)
+	{
+		const FVelocityBlend Blend = LocomotionMath::VelocityBlend<FVelocityBlend>(Inputs.X[Index], Inputs.Y[Index], Inputs.Z[Index]);
+		return Blend.F + Blend.B + Blend.L + Blend.R;
+	});
+	FVelocityBlend Current;
+	Run("InterpVelocityBlend", Iterations, [&](int Index)
+	{
+		FVelocityBlend Target;
+		Target.F = Inputs.X[Index];
+		Target.R = Inputs.Y[Index];
+		Current = LocomotionMath::InterpVelocityBlend(Current, Target, 12.0f, 1.0f / 60.0f);
+		return Current.F;
+	});
+	FLeanAmount Lean;
+	Run("InterpLeanAmount", Iterations, [&](int Index)
+	{
+		FLeanAmount Target;
+		Target.LR = Inputs.Y[Index];
+		Target.FB = Inputs.X[Index];
+		Lean = LocomotionMath::InterpLeanAmount(Lean, Target, 4.0f, 1.0f / 60.0f);
+		return Lean.LR;
+	});
+	return 0;
+}
@@ -0,0 +1,33 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#pragma once
+
+// 与引擎里的枚举和结构体成员名相同，LocomotionMath的模板只依赖成员名
+enum class EGait : unsigned char
+{
+	Walking,
+	Running,
+	Sprinting
+};
+
+enum class EMovementDirection : unsigned char
+{
+	Forward,
+	Right,
+	Left,
+	Backward
+};
+
+struct FVelocityBlend
+{
+	float F = 0.0f;
+	float B = 0.0f;
+	float L = 0.0f;
+	float R = 0.0f;
+};
+
+struct FLeanAmount
+{
+	float LR = 0.0f;
+	float FB = 0.0f;
+};
@@ -0,0 +1,198 @@
+// Copyright XiaWen, Inc. All Rights Reserved.
+
+#include "AnimationProject/Locomotion/LocomotionMath.h"
+#include "LocomotionMathTestTypes.h"
+
+#include <cstdio>
+
+namespace
+{
+	int NumFailures = 0;
+
+	void CheckTrue(bool bValue, const char* Expression, const char* File, int Line)
+	{
+		if (!bValue)
+		{
+			std::printf("%s:%d: CHECK(%s) failed\n", File, Line, Expression);
+			++NumFailures;
+		}
+	}
+
+	void CheckNear(float Actual, float Expected, const char* Expression, const char* File, int Line)
+	{
+		if (!(std::abs(Actual - Expected) <= 1.e-5f))
+		{
+			std::printf("%s:%d: %s = %.9g, expected %.9g\n", File, Line, Expression, Actual, Expected);
+			++NumFailures;
+		}
+	}
+
+	#define CHECK(Expression) CheckTrue((Expression), #Expression, __FILE__, __LINE__)
+	#define CHECK_NEAR(Expression, Expected) CheckNear((Expression), (Expected), #Expression, __FILE__, __LINE__)
+
+	void TestMapRangeClamped()
+	{
+		using LocomotionMath::MapRangeClamped;
+		CHECK_NEAR(MapRangeClamped(5.0f, 0.0f, 10.0f, 0.0f, 1.0f), 0.5f);
+		// 超出输入区间时限制在输出区间的两端
+		CHECK_NEAR(MapRangeClamped(-5.0f, 0.0f, 10.0f, 0.0f, 1.0f), 0.0f);
+		CHECK_NEAR(MapRangeClamped(15.0f, 0.0f, 10.0f, 0.0f, 1.0f), 1.0f);
+		// 输出区间反向
+		CHECK_NEAR(MapRangeClamped(2.5f, 0.0f, 10.0f, 1.0f, 0.0f), 0.75f);
+		// 输入区间反向
+		CHECK_NEAR(MapRangeClamped(7.5f, 10.0f, 0.0f, 0.0f, 1.0f), 0.25f);
+		CHECK_NEAR(MapRangeClamped(-1.0f, 10.0f, 0.0f, 0.0f, 1.0f), 1.0f);
+		// 输入区间为0时按Value >= InB取两端
+		CHECK_NEAR(MapRangeClamped(3.0f, 3.0f, 3.0f, 2.0f, 4.0f), 4.0f);
+		CHECK_NEAR(MapRangeClamped(2.9f, 3.0f, 3.0f, 2.0f, 4.0f), 2.0f);
+		static_assert(LocomotionMath::MapRangeClamped(1.0f, 0.0f, 2.0f, 0.0f, 10.0f) == 5.0f, "MapRangeClamped must stay constexpr");
+	}
+
+	void TestFInterpTo()
+	{
+		using LocomotionMath::FInterpTo;
+		CHECK_NEAR(FInterpTo(0.0f, 10.0f, 0.1f, 5.0f), 5.0f);
+		// 插值速度不大于0时直接取目标值
+		CHECK_NEAR(FInterpTo(0.0f, 10.0f, 0.1f, 0.0f), 10.0f);
+		CHECK_NEAR(FInterpTo(0.0f, 10.0f, 0.1f, -1.0f), 10.0f);
+		// 一步超过目标时停在目标值，不会越过
+		CHECK_NEAR(FInterpTo(0.0f, 10.0f, 1.0f, 5.0f), 10.0f);
+		// DeltaTime为负时不动
+		CHECK_NEAR(FInterpTo(3.0f, 10.0f, -0.1f, 5.0f), 3.0f);
+		// 距离平方小于SmallNumber时直接取目标值
+		CHECK(FInterpTo(1.0f, 1.00005f, 0.01f, 1.0f) == 1.00005f);
+		CHECK(FInterpTo(1.0f, 1.001f, 0.01f, 1.0f) != 1.001f);
+	}
+
+	void TestGait()
+	{
+		using LocomotionMath::ActualGait;
+		constexpr float WalkSpeed = 165.0f;
+		constexpr float RunSpeed = 375.0f;
+		// 超过步态速度10以上才切换
+		CHECK(ActualGait(0.0f, WalkSpeed, RunSpeed, EGait::Sprinting) == EGait::Walking);
+		CHECK(ActualGait(174.9f, WalkSpeed, RunSpeed, EGait::Sprinting) == EGait::Walking);
+		CHECK(ActualGait(175.0f, WalkSpeed, RunSpeed, EGait::Sprinting) == EGait::Running);
+		CHECK(ActualGait(384.9f, WalkSpeed, RunSpeed, EGait::Sprinting) == EGait::Running);
+		CHECK(ActualGait(385.0f, WalkSpeed, RunSpeed, EGait::Sprinting) == EGait::Sprinting);
+		// 只有允许冲刺时才会冲刺
+		CHECK(ActualGait(385.0f, WalkSpeed, RunSpeed, EGait::Running) == EGait::Running);
+		CHECK(ActualGait(600.0f, WalkSpeed, RunSpeed, EGait::Walking) == EGait::Running);
+
+		using LocomotionMath::MappedSpeed;
+		CHECK_NEAR(MappedSpeed(0.0f, WalkSpeed, RunSpeed, 650.0f), 0.0f);
+		CHECK_NEAR(MappedSpeed(WalkSpeed, WalkSpeed, RunSpeed, 650.0f), 1.0f);
+		CHECK_NEAR(MappedSpeed(270.0f, WalkSpeed, RunSpeed, 650.0f), 1.5f);
+		CHECK_NEAR(MappedSpeed(RunSpeed, WalkSpeed, RunSpeed, 650.0f), 2.0f);
+		CHECK_NEAR(MappedSpeed(1000.0f, WalkSpeed, RunSpeed, 650.0f), 3.0f);
+	}
+
+	void TestQuadrant()
+	{
+		using LocomotionMath::Quadrant;
+		constexpr float FR = 70.0f;
+		constexpr float FL = -70.0f;
+		constexpr float BR = 110.0f;
+		constexpr float BL = -110.0f;
+		constexpr float Buffer = 5.0f;
+		const auto Direction = [=](EMovementDirection Current, float Angle)
+		{
+			return Quadrant(Current, FR, FL, BR, BL, Buffer, Angle);
+		};
+
+		CHECK(Direction(EMovementDirection::Forward, 0.0f) == EMovementDirection::Forward);
+		CHECK(Direction(EMovementDirection::Forward, 90.0f) == EMovementDirection::Right);
+		CHECK(Direction(EMovementDirection::Forward, -90.0f) == EMovementDirection::Left);
+		CHECK(Direction(EMovementDirection::Forward, 180.0f) == EMovementDirection::Backward);
+		CHECK(Direction(EMovementDirection::Forward, -180.0f) == EMovementDirection::Backward);
+		// 各象限总是向外扩Buffer，边界附近按Forward、Right、Left的顺序优先
+		CHECK(Direction(EMovementDirection::Right, 74.0f) == EMovementDirection::Forward);
+		CHECK(Direction(EMovementDirection::Right, 76.0f) == EMovementDirection::Right);
+		CHECK(Direction(EMovementDirection::Left, -74.0f) == EMovementDirection::Forward);
+		CHECK(Direction(EMovementDirection::Backward, 114.0f) == EMovementDirection::Right);
+		CHECK(Direction(EMovementDirection::Backward, 116.0f) == EMovementDirection::Backward);
+		CHECK(Direction(EMovementDirection::Backward, -114.0f) == EMovementDirection::Left);
+
+		using LocomotionMath::AngleInRange;
+		CHECK(AngleInRange(72.0f, -70.0f, 70.0f, 5.0f, true));
+		CHECK(!AngleInRange(68.0f, -70.0f, 70.0f, 5.0f, false));
+		CHECK(AngleInRange(65.0f, -70.0f, 70.0f, 5.0f, false));
+	}
+
+	void TestVelocityBlend()
+	{
+		using LocomotionMath::VelocityBlend;
+		FVelocityBlend Blend = VelocityBlend<FVelocityBlend>(1.0f, 0.0f, 0.0f);
+		CHECK_NEAR(Blend.F, 1.0f);
+		CHECK_NEAR(Blend.B, 0.0f);
+		CHECK_NEAR(Blend.L, 0.0f);
+		CHECK_NEAR(Blend.R, 0.0f);
+
+		Blend = VelocityBlend<FVelocityBlend>(-0.6f, 0.8f, 0.0f);
+		CHECK_NEAR(Blend.F, 0.0f);
+		CHECK_NEAR(Blend.B, -0.6f / 1.4f);
+		CHECK_NEAR(Blend.L, 0.0f);
+		CHECK_NEAR(Blend.R, 0.8f / 1.4f);
+
+		// 竖直分量也算进占比
+		Blend = VelocityBlend<FVelocityBlend>(0.0f, -0.6f, 0.8f);
+		CHECK_NEAR(Blend.L, -0.6f / 1.4f);
+		CHECK_NEAR(Blend.F + Blend.B + Blend.R, 0.0f);
+
+		// 速度为0时四个权重都是0，不会除以0
+		Blend = VelocityBlend<FVelocityBlend>(0.0f, 0.0f, 0.0f);
+		CHECK(Blend.F == 0.0f && Blend.B == 0.0f && Blend.L == 0.0f && Blend.R == 0.0f);
+
+		// 输入不需要归一化
+		Blend = VelocityBlend<FVelocityBlend>(300.0f, 300.0f, 0.0f);
+		CHECK_NEAR(Blend.F, 0.5f);
+		CHECK_NEAR(Blend.R, 0.5f);
+
+		const FVelocityBlend Current;
+		const FVelocityBlend Interped = LocomotionMath::InterpVelocityBlend(Current, Blend, 10.0f, 0.05f);
+		CHECK_NEAR(Interped.F, 0.25f);
+		CHECK_NEAR(Interped.R, 0.25f);
+		CHECK_NEAR(Interped.B, 0.0f);
+
+		FLeanAmount TargetLean;
+		TargetLean.LR = 1.0f;
+		TargetLean.FB = -1.0f;
+		const FLeanAmount Lean = LocomotionMath::InterpLeanAmount(FLeanAmount(), TargetLean, 4.0f, 0.125f);
+		CHECK_NEAR(Lean.LR, 0.5f);
+		CHECK_NEAR(Lean.FB, -0.5f);
+	}
+
+	void TestFixDiagonalGamepadValues()
+	{
+		float X = 0.0f;
+		float Y = 0.0f;
+		LocomotionMath::FixDiagonalGamepadValues(0.6f, 0.6f, X, Y);
+		CHECK_NEAR(X, 0.72f);
+		CHECK_NEAR(Y, 0.72f);
+		LocomotionMath::FixDiagonalGamepadValues(1.0f, -1.0f, X, Y);
+		CHECK_NEAR(X, 1.0f);
+		CHECK_NEAR(Y, -1.0f);
+		// 单轴输入不放大
+		LocomotionMath::FixDiagonalGamepadValues(0.5f, 0.0f, X, Y);
+		CHECK_NEAR(X, 0.5f);
+		CHECK_NEAR(Y, 0.0f);
+	}
+}
+
+int main()
+{
+	TestMapRangeClamped();
+	TestFInterpTo();
+	TestGait();
+	TestQuadrant();
+	TestVelocityBlend();
+	TestFixDiagonalGamepadValues();
+
+	if (NumFailures > 0)
+	{
+		std::printf("%d check(s) failed\n", NumFailures);
+		return 1;
+	}
+	std::printf("All LocomotionMath checks passed\n");
+	return 0;
+}